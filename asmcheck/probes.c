@@ -0,0 +1,290 @@
+/*
+    Probes for zero abstraction cost check (make asmcheck).
+
+    Every probe is a pair of functions:
+    asm_probe_<name>_kmacros - code written with KMacros
+    asm_probe_<name>_ref     - hand written equivalent
+
+    scripts/asmcheck.sh compiles this file to assembly and fails
+    when instructions of any pair differ.
+*/
+
+#include <stdint.h>
+
+#include <kmacros/kmacros.h>
+#include <kmacros/kint128.h>
+
+/* Only to silence -Wmissing-prototypes, probes have to be visible in assembly */
+#define ASM_PROBE(rettype, name, ...) \
+    rettype KCONCAT(asm_probe_, name)(__VA_ARGS__); \
+    rettype KCONCAT(asm_probe_, name)(__VA_ARGS__)
+
+typedef struct asm_probe_obj16
+{
+    uint64_t a;
+    uint64_t b;
+} asm_probe_obj16_t;
+
+/*********** KWRITE_PTR ******************/
+
+ASM_PROBE(void, kwrite_ptr_u32_kmacros, uint32_t *dst, uint32_t *src)
+{
+    KWRITE_PTR(dst, src);
+}
+
+ASM_PROBE(void, kwrite_ptr_u32_ref, uint32_t *dst, uint32_t *src)
+{
+    *dst = *src;
+}
+
+ASM_PROBE(void, kwrite_ptr_u64_kmacros, uint64_t *dst, uint64_t *src)
+{
+    KWRITE_PTR(dst, src);
+}
+
+ASM_PROBE(void, kwrite_ptr_u64_ref, uint64_t *dst, uint64_t *src)
+{
+    *dst = *src;
+}
+
+ASM_PROBE(void, kwrite_ptr_obj16_kmacros, asm_probe_obj16_t *dst, asm_probe_obj16_t *src)
+{
+    KWRITE_PTR(dst, src);
+}
+
+ASM_PROBE(void, kwrite_ptr_obj16_ref, asm_probe_obj16_t *dst, asm_probe_obj16_t *src)
+{
+    *dst = *src;
+}
+
+/*********** KSWAP ******************/
+
+ASM_PROBE(void, kswap_int_kmacros, int *pa, int *pb)
+{
+    int a = *pa;
+    int b = *pb;
+
+    KSWAP(a, b);
+
+    *pa = a;
+    *pb = b;
+}
+
+ASM_PROBE(void, kswap_int_ref, int *pa, int *pb)
+{
+    int a = *pa;
+    int b = *pb;
+
+    const int tmp = a;
+    a = b;
+    b = tmp;
+
+    *pa = a;
+    *pb = b;
+}
+
+ASM_PROBE(void, kswap_obj16_kmacros, asm_probe_obj16_t *pa, asm_probe_obj16_t *pb)
+{
+    asm_probe_obj16_t a = *pa;
+    asm_probe_obj16_t b = *pb;
+
+    KSWAP(a, b);
+
+    *pa = a;
+    *pb = b;
+}
+
+ASM_PROBE(void, kswap_obj16_ref, asm_probe_obj16_t *pa, asm_probe_obj16_t *pb)
+{
+    asm_probe_obj16_t a = *pa;
+    asm_probe_obj16_t b = *pb;
+
+    const asm_probe_obj16_t tmp = a;
+    a = b;
+    b = tmp;
+
+    *pa = a;
+    *pb = b;
+}
+
+/*********** KMIN / KMAX ******************/
+
+ASM_PROBE(int, kmin2_kmacros, int a, int b)
+{
+    return KMIN(a, b);
+}
+
+ASM_PROBE(int, kmin2_ref, int a, int b)
+{
+    return a <= b ? a : b;
+}
+
+ASM_PROBE(int, kmax2_kmacros, int a, int b)
+{
+    return KMAX(a, b);
+}
+
+ASM_PROBE(int, kmax2_ref, int a, int b)
+{
+    return a >= b ? a : b;
+}
+
+ASM_PROBE(unsigned long, kmin3_kmacros, unsigned long a, unsigned long b, unsigned long c)
+{
+    return KMIN(a, b, c);
+}
+
+ASM_PROBE(unsigned long, kmin3_ref, unsigned long a, unsigned long b, unsigned long c)
+{
+    const unsigned long ab = a <= b ? a : b;
+    return ab <= c ? ab : c;
+}
+
+/*********** KMASK_GET ******************/
+
+ASM_PROBE(unsigned int, kmask_get_u32_kmacros, unsigned int n)
+{
+    return KMASK_GET(n, 3, 7);
+}
+
+ASM_PROBE(unsigned int, kmask_get_u32_ref, unsigned int n)
+{
+    return (n >> 3) & 0x1Fu;
+}
+
+ASM_PROBE(uint64_t, kmask_get_u64_kmacros, uint64_t n)
+{
+    return KMASK_GET(n, 20, 51);
+}
+
+ASM_PROBE(uint64_t, kmask_get_u64_ref, uint64_t n)
+{
+    return (n >> 20) & 0xFFFFFFFFu;
+}
+
+/*********** KBIT_SET ******************/
+
+ASM_PROBE(unsigned int, kbit_set_u32_kmacros, unsigned int n)
+{
+    return KBIT_SET(n, 5);
+}
+
+ASM_PROBE(unsigned int, kbit_set_u32_ref, unsigned int n)
+{
+    return n | (1u << 5);
+}
+
+ASM_PROBE(uint64_t, kbit_set_u64_kmacros, uint64_t n, unsigned int k)
+{
+    return KBIT_SET(n, k);
+}
+
+ASM_PROBE(uint64_t, kbit_set_u64_ref, uint64_t n, unsigned int k)
+{
+    return n | (UINT64_C(1) << k);
+}
+
+/*********** KLOAD / KSTORE ******************/
+
+ASM_PROBE(uint32_t, kload_be32_kmacros, const uint8_t *p)
+{
+    return KLOAD_BE32(p);
+}
+
+ASM_PROBE(uint32_t, kload_be32_ref, const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+ASM_PROBE(void, kstore_le64_kmacros, uint8_t *p, uint64_t v)
+{
+    KSTORE_LE64(p, v);
+}
+
+ASM_PROBE(void, kstore_le64_ref, uint8_t *p, uint64_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    p[4] = (uint8_t)(v >> 32);
+    p[5] = (uint8_t)(v >> 40);
+    p[6] = (uint8_t)(v >> 48);
+    p[7] = (uint8_t)(v >> 56);
+}
+
+/*********** KFASTRANGE / KBUCKET_INDEX ******************/
+
+ASM_PROBE(uint32_t, kfastrange32_kmacros, uint32_t hash, uint32_t n)
+{
+    return KFASTRANGE32(hash, n);
+}
+
+ASM_PROBE(uint32_t, kfastrange32_ref, uint32_t hash, uint32_t n)
+{
+    return (uint32_t)(((uint64_t)hash * n) >> 32);
+}
+
+ASM_PROBE(uint64_t, kbucket_index64_pow2_kmacros, uint64_t hash)
+{
+    return KBUCKET_INDEX64(hash, 1024);
+}
+
+ASM_PROBE(uint64_t, kbucket_index64_pow2_ref, uint64_t hash)
+{
+    return hash >> 54;
+}
+
+/*********** KINT128 ******************/
+
+#ifdef KCOMPILER_HAS_INT128
+
+ASM_PROBE(uint64_t, kuint128_mulhi64_kmacros, uint64_t x, uint64_t y)
+{
+    return kuint128_mulhi64(x, y);
+}
+
+ASM_PROBE(uint64_t, kuint128_mulhi64_ref, uint64_t x, uint64_t y)
+{
+    __extension__ const unsigned __int128 p = (unsigned __int128)x * y;
+    return (uint64_t)(p >> 64);
+}
+
+ASM_PROBE(uint64_t, kuint128_add_carry_kmacros, uint64_t a_hi, uint64_t a_lo, uint64_t b_hi, uint64_t b_lo)
+{
+    bool carry;
+    const kuint128_t r = kuint128_add_carry(kuint128_make(a_hi, a_lo), kuint128_make(b_hi, b_lo), false, &carry);
+    return kuint128_hi(r) + carry;
+}
+
+ASM_PROBE(uint64_t, kuint128_add_carry_ref, uint64_t a_hi, uint64_t a_lo, uint64_t b_hi, uint64_t b_lo)
+{
+    __extension__ const unsigned __int128 a = ((unsigned __int128)a_hi << 64) | a_lo;
+    __extension__ const unsigned __int128 b = ((unsigned __int128)b_hi << 64) | b_lo;
+    __extension__ const unsigned __int128 r = a + b;
+    return (uint64_t)(r >> 64) + (r < a);
+}
+
+#endif
+
+/*********** KATOMIC ******************/
+
+ASM_PROBE(uint64_t, katomic_fetch_add_kmacros, uint64_t *p, uint64_t v)
+{
+    return KATOMIC_FETCH_ADD(p, v, KATOMIC_RELAXED);
+}
+
+ASM_PROBE(uint64_t, katomic_fetch_add_ref, uint64_t *p, uint64_t v)
+{
+    return __atomic_fetch_add(p, v, __ATOMIC_RELAXED);
+}
+
+ASM_PROBE(bool, katomic_cas_kmacros, uint64_t *p, uint64_t *expected, uint64_t v)
+{
+    return KATOMIC_CAS(p, expected, v, KATOMIC_ACQ_REL, KATOMIC_ACQUIRE);
+}
+
+ASM_PROBE(bool, katomic_cas_ref, uint64_t *p, uint64_t *expected, uint64_t v)
+{
+    return __atomic_compare_exchange_n(p, expected, v, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,1639 @@
+/*
+    Microbenchmarks for KMacros builtins and macros.
+
+    Each operation is measured on the path chosen by kcompiler-*.h (builtin)
+    and on the kbuiltin_*_impl fallback (impl), for several input distributions.
+    Macros without a fallback are compared with a hand written reference (ref).
+
+    Output is a CSV (one line per measurement):
+    compiler,op,path,dist,ns_per_op,cycles_per_op
+
+    cycles_per_op is based on TSC (reference cycles), -1 when TSC is not available
+
+    Contention cases (kqueue_mpmc, kfutex_mutex) use number of threads as dist, cycles_per_op is -1 for them
+
+    Usage: ./bench.out [output_file]
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+
+#include <kmacros/kmacros.h>
+#include <kmacros/kdivider.h>
+#include <kmacros/kslab.h>
+#include <kmacros/ktlsf.h>
+#include <kmacros/kbuddy.h>
+#include <kmacros/karena.h>
+#include <kmacros/kpool.h>
+#include <kmacros/kring.h>
+#include <kmacros/kqueue.h>
+#include <kmacros/klock.h>
+#include <kmacros/kfutex.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_TSC
+#endif
+
+/* Elements in input buffer, small enough to stay in L1/L2 cache */
+#define BENCH_N         4096
+/* Operations per single measurement */
+#define BENCH_OPS       (1u << 21)
+/* Measurements per case, best one is reported */
+#define BENCH_RUNS      5
+
+typedef uint64_t (*bench_kernel_f)(const uint64_t *in, size_t n);
+
+typedef struct bench_case
+{
+    const char     *op;
+    const char     *path;
+    bench_kernel_f  kernel;
+    bool            use_dist; /* false when input values do not matter */
+} bench_case_t;
+
+typedef struct bench_dist
+{
+    const char *name;
+    void      (*gen)(uint64_t *in, size_t n);
+} bench_dist_t;
+
+static uint64_t bench_in[BENCH_N];
+static uint64_t bench_src[BENCH_N * 4];
+static uint64_t bench_dst[BENCH_N * 4];
+
+static volatile uint64_t bench_sink;
+
+/*********** INPUT DISTRIBUTIONS ******************/
+
+/* Every generated value has non zero lower 32 bits, so clz / ctz are always defined */
+
+static uint64_t bench_rand_state = 0x9E3779B97F4A7C15ull;
+
+static uint64_t bench_rand(void)
+{
+    bench_rand_state ^= bench_rand_state << 13;
+    bench_rand_state ^= bench_rand_state >> 7;
+    bench_rand_state ^= bench_rand_state << 17;
+
+    return bench_rand_state;
+}
+
+static void bench_gen_uniform(uint64_t *in, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        in[i] = bench_rand();
+        if ((uint32_t)in[i] == 0)
+            in[i] |= 1;
+    }
+}
+
+static void bench_gen_sparse(uint64_t *in, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        in[i] = (1ull << (bench_rand() % 32)) | (1ull << (bench_rand() % 64));
+}
+
+static void bench_gen_dense(uint64_t *in, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        in[i] = ~((1ull << (bench_rand() % 32)) | (1ull << (bench_rand() % 64)));
+}
+
+static void bench_gen_small(uint64_t *in, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        in[i] = 1 + bench_rand() % 255;
+}
+
+static const bench_dist_t bench_dists[] =
+{
+    {"uniform", bench_gen_uniform},
+    {"sparse",  bench_gen_sparse},
+    {"dense",   bench_gen_dense},
+    {"small",   bench_gen_small},
+};
+
+/*********** KERNELS ******************/
+
+#define BENCH_KERNEL_UNARY(name, type, rtype, op) \
+    static uint64_t name(const uint64_t *in, size_t n) \
+    { \
+        uint64_t acc = 0; \
+        for (size_t i = 0; i < n; ++i) \
+        { \
+            const type x = (type)in[i]; \
+            const rtype r = op(x); \
+            acc += (uint64_t)r; \
+        } \
+        return acc; \
+    }
+
+#define BENCH_KERNEL_OVERFLOW(name, type, op) \
+    static uint64_t name(const uint64_t *in, size_t n) \
+    { \
+        uint64_t acc = 0; \
+        for (size_t i = 0; i + 1 < n; ++i) \
+        { \
+            const type x = (type)in[i]; \
+            const type y = (type)in[i + 1]; \
+            type r; \
+            const bool overflow = op(x, y, &r); \
+            acc += (uint64_t)r + (uint64_t)overflow; \
+        } \
+        return acc; \
+    }
+
+#define BENCH_KERNEL_WRITE(name, size, write) \
+    static uint64_t name(const uint64_t *in, size_t n) \
+    { \
+        uint8_t *dst = (uint8_t *)bench_dst; \
+        uint8_t *src = (uint8_t *)bench_src; \
+        (void)in; \
+        for (size_t i = 0; i < n; ++i) \
+            write(&dst[i * (size)], &src[i * (size)], size); \
+        return dst[(n - 1) * (size)]; \
+    }
+
+#define BENCH_KERNEL_SWAP(name, type, swap) \
+    static uint64_t name(const uint64_t *in, size_t n) \
+    { \
+        type *arr = (type *)(void *)bench_dst; \
+        const size_t len = sizeof(bench_dst) / (sizeof(type)); \
+        (void)in; \
+        for (size_t i = 0; i < n; ++i) \
+        { \
+            const size_t idx = (i * 2) % (len - 1); \
+            type x = arr[idx]; \
+            type y = arr[idx + 1]; \
+            swap(x, y); \
+            arr[idx] = x; \
+            arr[idx + 1] = y; \
+        } \
+        return (uint64_t)(((const uint8_t *)arr)[0]); \
+    }
+
+typedef struct bench_obj16 { uint64_t a[2]; } bench_obj16_t;
+typedef struct bench_obj64 { uint64_t a[8]; } bench_obj64_t;
+
+#define BENCH_MEMCPY(dst, src, size) (void)memcpy(dst, src, size)
+#define BENCH_SWAP_REF(a, b) do { const __typeof__(a) __bench_tmp = a; a = b; b = __bench_tmp; } while (0)
+
+/* Reference log2 built on top of fallbacks */
+#define BENCH_LOG2_FLOOR_IMPL32(x)  ((int)(sizeof(x) * CHAR_BIT) - 1 - kbuiltin_clz_impl(x))
+#define BENCH_LOG2_FLOOR_IMPL64(x)  ((long long)(sizeof(x) * CHAR_BIT) - 1 - kbuiltin_clzll_impl(x))
+#define BENCH_LOG2_CEIL_IMPL32(x)   (BENCH_LOG2_FLOOR_IMPL32(x) + (kbuiltin_popcount_impl(x) != 1))
+#define BENCH_LOG2_CEIL_IMPL64(x)   (BENCH_LOG2_FLOOR_IMPL64(x) + (kbuiltin_popcountll_impl(x) != 1))
+
+BENCH_KERNEL_UNARY(bench_popcount_builtin,   unsigned int,       int, KPOPCOUNT)
+BENCH_KERNEL_UNARY(bench_popcount_impl,      unsigned int,       int, kbuiltin_popcount_impl)
+BENCH_KERNEL_UNARY(bench_popcountl_builtin,  unsigned long,      int, KPOPCOUNTL)
+BENCH_KERNEL_UNARY(bench_popcountl_impl,     unsigned long,      int, kbuiltin_popcountl_impl)
+BENCH_KERNEL_UNARY(bench_popcountll_builtin, unsigned long long, int, KPOPCOUNTLL)
+BENCH_KERNEL_UNARY(bench_popcountll_impl,    unsigned long long, int, kbuiltin_popcountll_impl)
+
+BENCH_KERNEL_UNARY(bench_clz_builtin,   unsigned int,       int, KCLZ)
+BENCH_KERNEL_UNARY(bench_clz_impl,      unsigned int,       int, kbuiltin_clz_impl)
+BENCH_KERNEL_UNARY(bench_clzl_builtin,  unsigned long,      int, KCLZL)
+BENCH_KERNEL_UNARY(bench_clzl_impl,     unsigned long,      int, kbuiltin_clzl_impl)
+BENCH_KERNEL_UNARY(bench_clzll_builtin, unsigned long long, int, KCLZLL)
+BENCH_KERNEL_UNARY(bench_clzll_impl,    unsigned long long, int, kbuiltin_clzll_impl)
+
+BENCH_KERNEL_UNARY(bench_ctz_builtin,   unsigned int,       int, KCTZ)
+BENCH_KERNEL_UNARY(bench_ctz_impl,      unsigned int,       int, kbuiltin_ctz_impl)
+BENCH_KERNEL_UNARY(bench_ctzl_builtin,  unsigned long,      int, KCTZL)
+BENCH_KERNEL_UNARY(bench_ctzl_impl,     unsigned long,      int, kbuiltin_ctzl_impl)
+BENCH_KERNEL_UNARY(bench_ctzll_builtin, unsigned long long, int, KCTZLL)
+BENCH_KERNEL_UNARY(bench_ctzll_impl,    unsigned long long, int, kbuiltin_ctzll_impl)
+
+BENCH_KERNEL_UNARY(bench_bswap16_builtin, uint16_t, uint16_t, KBSWAP16)
+BENCH_KERNEL_UNARY(bench_bswap16_impl,    uint16_t, uint16_t, kbuiltin_bswap16_impl)
+BENCH_KERNEL_UNARY(bench_bswap32_builtin, uint32_t, uint32_t, KBSWAP32)
+BENCH_KERNEL_UNARY(bench_bswap32_impl,    uint32_t, uint32_t, kbuiltin_bswap32_impl)
+BENCH_KERNEL_UNARY(bench_bswap64_builtin, uint64_t, uint64_t, KBSWAP64)
+BENCH_KERNEL_UNARY(bench_bswap64_impl,    uint64_t, uint64_t, kbuiltin_bswap64_impl)
+
+/* Morton decode (even bits), the most common KBIT_EXTRACT use case */
+#define BENCH_EXTRACT_EVEN_MACRO(x) KBIT_EXTRACT(x, 0x5555555555555555ull)
+static inline unsigned long long bench_extract_even_shifts(unsigned long long x)
+{
+    x &= 0x5555555555555555ull;
+    x = (x | (x >> 1))  & 0x3333333333333333ull;
+    x = (x | (x >> 2))  & 0x0F0F0F0F0F0F0F0Full;
+    x = (x | (x >> 4))  & 0x00FF00FF00FF00FFull;
+    x = (x | (x >> 8))  & 0x0000FFFF0000FFFFull;
+    x = (x | (x >> 16)) & 0x00000000FFFFFFFFull;
+
+    return x;
+}
+
+#define BENCH_DEPOSIT_EVEN_MACRO(x) KBIT_DEPOSIT(x, 0x5555555555555555ull)
+static inline unsigned long long bench_deposit_even_shifts(unsigned long long x)
+{
+    x &= 0x00000000FFFFFFFFull;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFull;
+    x = (x | (x << 8))  & 0x00FF00FF00FF00FFull;
+    x = (x | (x << 4))  & 0x0F0F0F0F0F0F0F0Full;
+    x = (x | (x << 2))  & 0x3333333333333333ull;
+    x = (x | (x << 1))  & 0x5555555555555555ull;
+
+    return x;
+}
+
+BENCH_KERNEL_UNARY(bench_extract_even_macro, unsigned long long, unsigned long long, BENCH_EXTRACT_EVEN_MACRO)
+BENCH_KERNEL_UNARY(bench_extract_even_ref,   unsigned long long, unsigned long long, bench_extract_even_shifts)
+BENCH_KERNEL_UNARY(bench_deposit_even_macro, unsigned long long, unsigned long long, BENCH_DEPOSIT_EVEN_MACRO)
+BENCH_KERNEL_UNARY(bench_deposit_even_ref,   unsigned long long, unsigned long long, bench_deposit_even_shifts)
+
+BENCH_KERNEL_UNARY(bench_reverse_u32,  unsigned int,       unsigned int,       KBIT_REVERSE)
+BENCH_KERNEL_UNARY(bench_reverse_u64,  unsigned long long, unsigned long long, KBIT_REVERSE)
+BENCH_KERNEL_UNARY(bench_reverse_significant_u32, unsigned int,       unsigned int,       KBIT_REVERSE_SIGNIFICANT)
+BENCH_KERNEL_UNARY(bench_reverse_significant_u64, unsigned long long, unsigned long long, KBIT_REVERSE_SIGNIFICANT)
+
+/* FFT permutation of whole bench_dst, one operation = one element */
+static uint64_t bench_reverse_array_macro(const uint64_t *in, size_t n)
+{
+    (void)in;
+    KBIT_REVERSE_ARRAY(bench_dst, n);
+
+    return bench_dst[1];
+}
+
+static uint64_t bench_reverse_array_ref(const uint64_t *in, size_t n)
+{
+    const unsigned int log = (unsigned int)KLOG2_FLOOR((unsigned long long)n);
+    (void)in;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        size_t j = 0;
+        for (unsigned int b = 0; b < log; ++b)
+            j |= ((i >> b) & 1) << (log - 1 - b);
+
+        if (i < j)
+            BENCH_SWAP_REF(bench_dst[i], bench_dst[j]);
+    }
+
+    return bench_dst[1];
+}
+
+BENCH_KERNEL_UNARY(bench_log2_floor_u32_builtin, unsigned int,       int,       KLOG2_FLOOR)
+BENCH_KERNEL_UNARY(bench_log2_floor_u32_impl,    unsigned int,       int,       BENCH_LOG2_FLOOR_IMPL32)
+BENCH_KERNEL_UNARY(bench_log2_floor_u64_builtin, unsigned long long, long long, KLOG2_FLOOR)
+BENCH_KERNEL_UNARY(bench_log2_floor_u64_impl,    unsigned long long, long long, BENCH_LOG2_FLOOR_IMPL64)
+BENCH_KERNEL_UNARY(bench_log2_ceil_u32_builtin,  unsigned int,       int,       KLOG2_CEIL)
+BENCH_KERNEL_UNARY(bench_log2_ceil_u32_impl,     unsigned int,       int,       BENCH_LOG2_CEIL_IMPL32)
+BENCH_KERNEL_UNARY(bench_log2_ceil_u64_builtin,  unsigned long long, long long, KLOG2_CEIL)
+BENCH_KERNEL_UNARY(bench_log2_ceil_u64_impl,     unsigned long long, long long, BENCH_LOG2_CEIL_IMPL64)
+
+BENCH_KERNEL_OVERFLOW(bench_add_i32_builtin, int,                KADD_OVERFLOW)
+BENCH_KERNEL_OVERFLOW(bench_add_i32_impl,    int,                kbuiltin_add_overflow_impl)
+BENCH_KERNEL_OVERFLOW(bench_add_u32_builtin, unsigned int,       KADD_OVERFLOW)
+BENCH_KERNEL_OVERFLOW(bench_add_u32_impl,    unsigned int,       kbuiltin_add_overflow_impl)
+BENCH_KERNEL_OVERFLOW(bench_add_i64_builtin, long long,          KADD_OVERFLOW)
+BENCH_KERNEL_OVERFLOW(bench_add_i64_impl,    long long,          kbuiltin_add_overflow_impl)
+BENCH_KERNEL_OVERFLOW(bench_add_u64_builtin, unsigned long long, KADD_OVERFLOW)
+BENCH_KERNEL_OVERFLOW(bench_add_u64_impl,    unsigned long long, kbuiltin_add_overflow_impl)
+
+BENCH_KERNEL_OVERFLOW(bench_sub_i32_builtin, int,                KSUB_OVERFLOW)
+BENCH_KERNEL_OVERFLOW(bench_sub_i32_impl,    int,                kbuiltin_sub_overflow_impl)
+BENCH_KERNEL_OVERFLOW(bench_sub_u32_builtin, unsigned int,       KSUB_OVERFLOW)
+BENCH_KERNEL_OVERFLOW(bench_sub_u32_impl,    unsigned int,       kbuiltin_sub_overflow_impl)
+BENCH_KERNEL_OVERFLOW(bench_sub_i64_builtin, long long,          KSUB_OVERFLOW)
+BENCH_KERNEL_OVERFLOW(bench_sub_i64_impl,    long long,          kbuiltin_sub_overflow_impl)
+BENCH_KERNEL_OVERFLOW(bench_sub_u64_builtin, unsigned long long, KSUB_OVERFLOW)
+BENCH_KERNEL_OVERFLOW(bench_sub_u64_impl,    unsigned long long, kbuiltin_sub_overflow_impl)
+
+/* Previous overflow check by division and schoolbook product as references for wide multiply */
+static inline bool bench_umulll_overflow_div(unsigned long long x, unsigned long long y, unsigned long long *res)
+{
+    *res = x * y;
+    return y != 0 && x > ULLONG_MAX / y;
+}
+
+static inline bool bench_smulll_overflow_div(long long x, long long y, long long *res)
+{
+    *res = (long long)((unsigned long long)x * (unsigned long long)y);
+
+    if (x > 0)
+        return y > 0 ? x > LLONG_MAX / y : y < LLONG_MIN / x;
+
+    return y > 0 ? x < LLONG_MIN / y : (x != 0 && y < LLONG_MAX / x);
+}
+
+static inline bool bench_umulll_overflow_limbs(unsigned long long x, unsigned long long y, unsigned long long *res)
+{
+    uint64_t r;
+    const bool overflow = __kumul64_overflow_limbs(x, y, &r);
+    *res = r;
+    return overflow;
+}
+
+BENCH_KERNEL_OVERFLOW(bench_mul_i32_builtin, int,                KMUL_OVERFLOW)
+BENCH_KERNEL_OVERFLOW(bench_mul_i32_impl,    int,                kbuiltin_mul_overflow_impl)
+BENCH_KERNEL_OVERFLOW(bench_mul_u32_builtin, unsigned int,       KMUL_OVERFLOW)
+BENCH_KERNEL_OVERFLOW(bench_mul_u32_impl,    unsigned int,       kbuiltin_mul_overflow_impl)
+BENCH_KERNEL_OVERFLOW(bench_mul_i64_builtin, long long,          KMUL_OVERFLOW)
+BENCH_KERNEL_OVERFLOW(bench_mul_i64_impl,    long long,          kbuiltin_mul_overflow_impl)
+BENCH_KERNEL_OVERFLOW(bench_mul_u64_builtin, unsigned long long, KMUL_OVERFLOW)
+BENCH_KERNEL_OVERFLOW(bench_mul_u64_impl,    unsigned long long, kbuiltin_mul_overflow_impl)
+BENCH_KERNEL_OVERFLOW(bench_mul_i64_div,      long long,          bench_smulll_overflow_div)
+BENCH_KERNEL_OVERFLOW(bench_mul_u64_div,      unsigned long long, bench_umulll_overflow_div)
+BENCH_KERNEL_OVERFLOW(bench_mul_u64_limbs,    unsigned long long, bench_umulll_overflow_limbs)
+
+BENCH_KERNEL_WRITE(bench_write1_macro,  1,  KWRITE_SIZE_PTR)
+BENCH_KERNEL_WRITE(bench_write1_ref,    1,  BENCH_MEMCPY)
+BENCH_KERNEL_WRITE(bench_write2_macro,  2,  KWRITE_SIZE_PTR)
+BENCH_KERNEL_WRITE(bench_write2_ref,    2,  BENCH_MEMCPY)
+BENCH_KERNEL_WRITE(bench_write4_macro,  4,  KWRITE_SIZE_PTR)
+BENCH_KERNEL_WRITE(bench_write4_ref,    4,  BENCH_MEMCPY)
+BENCH_KERNEL_WRITE(bench_write8_macro,  8,  KWRITE_SIZE_PTR)
+BENCH_KERNEL_WRITE(bench_write8_ref,    8,  BENCH_MEMCPY)
+BENCH_KERNEL_WRITE(bench_write16_macro, 16, KWRITE_SIZE_PTR)
+BENCH_KERNEL_WRITE(bench_write16_ref,   16, BENCH_MEMCPY)
+BENCH_KERNEL_WRITE(bench_write32_macro, 32, KWRITE_SIZE_PTR)
+BENCH_KERNEL_WRITE(bench_write32_ref,   32, BENCH_MEMCPY)
+
+BENCH_KERNEL_SWAP(bench_swap_u32_macro,   uint32_t,      KSWAP)
+BENCH_KERNEL_SWAP(bench_swap_u32_ref,     uint32_t,      BENCH_SWAP_REF)
+BENCH_KERNEL_SWAP(bench_swap_obj16_macro, bench_obj16_t, KSWAP)
+BENCH_KERNEL_SWAP(bench_swap_obj16_ref,   bench_obj16_t, BENCH_SWAP_REF)
+BENCH_KERNEL_SWAP(bench_swap_obj64_macro, bench_obj64_t, KSWAP)
+BENCH_KERNEL_SWAP(bench_swap_obj64_ref,   bench_obj64_t, BENCH_SWAP_REF)
+
+/* Buffer kernels, one operation = one 64-bit word */
+static uint64_t bench_popcount_buffer_macro(const uint64_t *in, size_t n)
+{
+    return KPOPCOUNT_BUFFER(in, n * sizeof(*in));
+}
+
+static uint64_t bench_popcount_buffer_ref(const uint64_t *in, size_t n)
+{
+    uint64_t acc = 0;
+    for (size_t i = 0; i < n; ++i)
+        acc += (uint64_t)KPOPCOUNTLL(in[i]);
+
+    return acc;
+}
+
+static uint64_t bench_bswap32_array_macro(const uint64_t *in, size_t n)
+{
+    uint32_t *dst = (uint32_t *)(void *)bench_dst;
+    KBSWAP32_ARRAY(dst, in, n * 2);
+
+    return dst[n - 1];
+}
+
+static uint64_t bench_bswap32_array_ref(const uint64_t *in, size_t n)
+{
+    uint32_t *dst = (uint32_t *)(void *)bench_dst;
+    const uint32_t *src = (const uint32_t *)(const void *)in;
+    for (size_t i = 0; i < n * 2; ++i)
+        dst[i] = KBSWAP32(src[i]);
+
+    return dst[n - 1];
+}
+
+static uint64_t bench_bswap64_array_macro(const uint64_t *in, size_t n)
+{
+    KBSWAP64_ARRAY(bench_dst, in, n);
+
+    return bench_dst[n - 1];
+}
+
+static uint64_t bench_bswap64_array_ref(const uint64_t *in, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        bench_dst[i] = KBSWAP64(in[i]);
+
+    return bench_dst[n - 1];
+}
+
+/* Checked reductions, one operation = one element, KADD_OVERFLOW / KMUL_OVERFLOW chain is a reference */
+#define BENCH_KERNEL_SUM_OVERFLOW(name, type, ref) \
+    static uint64_t name(const uint64_t *in, size_t n) \
+    { \
+        const type *arr = (const type *)(const void *)in; \
+        const size_t len = n * sizeof(*in) / sizeof(type); \
+        type res = 0; \
+        bool overflow = false; \
+        if (ref) \
+            for (size_t i = 0; i < len; ++i) \
+                overflow |= KADD_OVERFLOW(res, arr[i], &res); \
+        else \
+            overflow = KSUM_OVERFLOW_ARRAY(arr, len, &res); \
+        return (uint64_t)res + (uint64_t)overflow; \
+    }
+
+#define BENCH_KERNEL_DOT_OVERFLOW(name, type, ref) \
+    static uint64_t name(const uint64_t *in, size_t n) \
+    { \
+        const type *arr = (const type *)(const void *)in; \
+        const size_t len = n * sizeof(*in) / sizeof(type) / 2; \
+        type res = 0; \
+        bool overflow = false; \
+        if (ref) \
+            for (size_t i = 0; i < len; ++i) \
+            { \
+                type p; \
+                overflow |= KMUL_OVERFLOW(arr[i], arr[len + i], &p); \
+                overflow |= KADD_OVERFLOW(res, p, &res); \
+            } \
+        else \
+            overflow = KDOT_OVERFLOW_ARRAY(arr, &arr[len], len, &res); \
+        return (uint64_t)res + (uint64_t)overflow; \
+    }
+
+BENCH_KERNEL_SUM_OVERFLOW(bench_sum_overflow_i32_macro, int,       false)
+BENCH_KERNEL_SUM_OVERFLOW(bench_sum_overflow_i32_ref,   int,       true)
+BENCH_KERNEL_SUM_OVERFLOW(bench_sum_overflow_i64_macro, long long, false)
+BENCH_KERNEL_SUM_OVERFLOW(bench_sum_overflow_i64_ref,   long long, true)
+BENCH_KERNEL_DOT_OVERFLOW(bench_dot_overflow_i32_macro, int,       false)
+BENCH_KERNEL_DOT_OVERFLOW(bench_dot_overflow_i32_ref,   int,       true)
+BENCH_KERNEL_DOT_OVERFLOW(bench_dot_overflow_i64_macro, long long, false)
+BENCH_KERNEL_DOT_OVERFLOW(bench_dot_overflow_i64_ref,   long long, true)
+
+/* Saturating arrays, one operation = one element, overflow macro and branch per element is a reference */
+#define BENCH_KERNEL_SAT(name, type, tmin, tmax, op, sat_array, is_max, ref) \
+    static uint64_t name(const uint64_t *in, size_t n) \
+    { \
+        const type *arr = (const type *)(const void *)in; \
+        type *dst = (type *)(void *)bench_dst; \
+        const size_t len = n * sizeof(*in) / sizeof(type) / 2; \
+        if (ref) \
+            for (size_t i = 0; i < len; ++i) \
+            { \
+                if (op(arr[i], arr[len + i], &dst[i])) \
+                    dst[i] = (is_max) ? (tmax) : (tmin); \
+            } \
+        else \
+            sat_array(dst, arr, &arr[len], len); \
+        return (uint64_t)dst[len - 1]; \
+    }
+
+BENCH_KERNEL_SAT(bench_add_sat_i32_macro, int,       INT_MIN,   INT_MAX,   KADD_OVERFLOW, KADD_SAT_ARRAY, arr[i] >= 0, false)
+BENCH_KERNEL_SAT(bench_add_sat_i32_ref,   int,       INT_MIN,   INT_MAX,   KADD_OVERFLOW, KADD_SAT_ARRAY, arr[i] >= 0, true)
+BENCH_KERNEL_SAT(bench_add_sat_i64_macro, long long, LLONG_MIN, LLONG_MAX, KADD_OVERFLOW, KADD_SAT_ARRAY, arr[i] >= 0, false)
+BENCH_KERNEL_SAT(bench_add_sat_i64_ref,   long long, LLONG_MIN, LLONG_MAX, KADD_OVERFLOW, KADD_SAT_ARRAY, arr[i] >= 0, true)
+BENCH_KERNEL_SAT(bench_mul_sat_i32_macro, int,       INT_MIN,   INT_MAX,   KMUL_OVERFLOW, KMUL_SAT_ARRAY, (arr[i] < 0) == (arr[len + i] < 0), false)
+BENCH_KERNEL_SAT(bench_mul_sat_i32_ref,   int,       INT_MIN,   INT_MAX,   KMUL_OVERFLOW, KMUL_SAT_ARRAY, (arr[i] < 0) == (arr[len + i] < 0), true)
+
+/* Division by runtime divisor, volatile so compiler cannot use constant divisor */
+static volatile uint64_t bench_divisor = 1000003;
+
+static uint64_t bench_div_u32_macro(const uint64_t *in, size_t n)
+{
+    const kdivider_u32_t div = kdivider_u32_create((uint32_t)bench_divisor);
+    uint64_t acc = 0;
+    for (size_t i = 0; i < n; ++i)
+        acc += KDIV_U32((uint32_t)in[i], &div);
+    return acc;
+}
+
+static uint64_t bench_div_u32_ref(const uint64_t *in, size_t n)
+{
+    const uint32_t d = (uint32_t)bench_divisor;
+    uint64_t acc = 0;
+    for (size_t i = 0; i < n; ++i)
+        acc += (uint32_t)in[i] / d;
+    return acc;
+}
+
+static uint64_t bench_mod_u64_macro(const uint64_t *in, size_t n)
+{
+    const kdivider_u64_t div = kdivider_u64_create(bench_divisor);
+    uint64_t acc = 0;
+    for (size_t i = 0; i < n; ++i)
+        acc += KMOD_U64(in[i], &div);
+    return acc;
+}
+
+static uint64_t bench_mod_u64_ref(const uint64_t *in, size_t n)
+{
+    const uint64_t d = bench_divisor;
+    uint64_t acc = 0;
+    for (size_t i = 0; i < n; ++i)
+        acc += in[i] % d;
+    return acc;
+}
+
+static uint64_t bench_div_s64_macro(const uint64_t *in, size_t n)
+{
+    const kdivider_s64_t div = kdivider_s64_create(-(int64_t)bench_divisor);
+    uint64_t acc = 0;
+    for (size_t i = 0; i < n; ++i)
+        acc += (uint64_t)KDIV_S64((int64_t)in[i], &div);
+    return acc;
+}
+
+static uint64_t bench_div_s64_ref(const uint64_t *in, size_t n)
+{
+    const int64_t d = -(int64_t)bench_divisor;
+    uint64_t acc = 0;
+    for (size_t i = 0; i < n; ++i)
+        acc += (uint64_t)((int64_t)in[i] / d);
+    return acc;
+}
+
+static uint64_t bench_div_u32_array_macro(const uint64_t *in, size_t n)
+{
+    const kdivider_u32_t div = kdivider_u32_create((uint32_t)bench_divisor);
+    const size_t len = n * 2;
+    uint32_t *dst = (uint32_t *)(void *)bench_dst;
+    KDIV_U32_ARRAY(dst, (const uint32_t *)(const void *)in, len, &div);
+    return dst[len - 1];
+}
+
+static uint64_t bench_div_u32_array_ref(const uint64_t *in, size_t n)
+{
+    const uint32_t d = (uint32_t)bench_divisor;
+    const uint32_t *src = (const uint32_t *)(const void *)in;
+    const size_t len = n * 2;
+    uint32_t *dst = (uint32_t *)(void *)bench_dst;
+    for (size_t i = 0; i < len; ++i)
+        dst[i] = src[i] / d;
+    return dst[len - 1];
+}
+
+/* Hash table bucket index for runtime table size (not power of 2) */
+static uint64_t bench_fastrange64_macro(const uint64_t *in, size_t n)
+{
+    const uint64_t buckets = bench_divisor;
+    uint64_t acc = 0;
+    for (size_t i = 0; i < n; ++i)
+        acc += KFASTRANGE64(in[i], buckets);
+    return acc;
+}
+
+static uint64_t bench_fastrange64_ref(const uint64_t *in, size_t n)
+{
+    const uint64_t buckets = bench_divisor;
+    uint64_t acc = 0;
+    for (size_t i = 0; i < n; ++i)
+        acc += in[i] % buckets;
+    return acc;
+}
+
+static uint64_t bench_fastrange32_macro(const uint64_t *in, size_t n)
+{
+    const uint32_t buckets = (uint32_t)bench_divisor;
+    uint64_t acc = 0;
+    for (size_t i = 0; i < n; ++i)
+        acc += KFASTRANGE32(in[i], buckets);
+    return acc;
+}
+
+static uint64_t bench_fastrange32_ref(const uint64_t *in, size_t n)
+{
+    const uint32_t buckets = (uint32_t)bench_divisor;
+    uint64_t acc = 0;
+    for (size_t i = 0; i < n; ++i)
+        acc += (uint32_t)in[i] % buckets;
+    return acc;
+}
+
+/* Small objects with random size [16; 271], 64 of them are alive at once (like request temporaries) */
+#define BENCH_ALLOC_LIVE 64
+
+static kslab_t bench_slab;
+
+static uint64_t bench_alloc_kslab(const uint64_t *in, size_t n)
+{
+    void *live[BENCH_ALLOC_LIVE] = {NULL};
+    size_t sizes[BENCH_ALLOC_LIVE] = {0};
+    uint64_t acc = 0;
+
+    (void)in;
+    for (size_t i = 0; i < n; ++i)
+    {
+        const size_t slot = i % BENCH_ALLOC_LIVE;
+        kslab_free(&bench_slab, live[slot], sizes[slot]);
+
+        sizes[slot] = 16 + (size_t)(bench_src[i] & 0xFF);
+        live[slot] = kslab_alloc(&bench_slab, sizes[slot]);
+        *(volatile char *)live[slot] = 0;
+        acc += (uint64_t)(uintptr_t)live[slot];
+    }
+
+    for (size_t i = 0; i < BENCH_ALLOC_LIVE; ++i)
+        kslab_free(&bench_slab, live[i], sizes[i]);
+
+    return acc;
+}
+
+static unsigned char bench_tlsf_pool[1u << 20];
+static ktlsf_t *bench_tlsf;
+
+static uint64_t bench_alloc_ktlsf(const uint64_t *in, size_t n)
+{
+    void *live[BENCH_ALLOC_LIVE] = {NULL};
+    uint64_t acc = 0;
+
+    (void)in;
+    for (size_t i = 0; i < n; ++i)
+    {
+        const size_t slot = i % BENCH_ALLOC_LIVE;
+        ktlsf_free(bench_tlsf, live[slot]);
+
+        live[slot] = ktlsf_alloc(bench_tlsf, 16 + (size_t)(bench_src[i] & 0xFF));
+        *(volatile char *)live[slot] = 0;
+        acc += (uint64_t)(uintptr_t)live[slot];
+    }
+
+    for (size_t i = 0; i < BENCH_ALLOC_LIVE; ++i)
+        ktlsf_free(bench_tlsf, live[i]);
+
+    return acc;
+}
+
+/* Page granular blocks [4 KiB; 1 MiB], malloc takes blocks >= 128 KiB directly from mmap */
+static kbuddy_t bench_buddy;
+
+static uint64_t bench_alloc_kbuddy(const uint64_t *in, size_t n)
+{
+    void *live[BENCH_ALLOC_LIVE] = {NULL};
+    uint64_t acc = 0;
+
+    (void)in;
+    for (size_t i = 0; i < n; ++i)
+    {
+        const size_t slot = i % BENCH_ALLOC_LIVE;
+        kbuddy_free(&bench_buddy, live[slot]);
+
+        live[slot] = kbuddy_alloc(&bench_buddy, (size_t)4096 << (bench_src[i] % 9));
+        *(volatile char *)live[slot] = 0;
+        acc += (uint64_t)(uintptr_t)live[slot];
+    }
+
+    for (size_t i = 0; i < BENCH_ALLOC_LIVE; ++i)
+        kbuddy_free(&bench_buddy, live[i]);
+
+    return acc;
+}
+
+static uint64_t bench_alloc_malloc_pages(const uint64_t *in, size_t n)
+{
+    void *live[BENCH_ALLOC_LIVE] = {NULL};
+    uint64_t acc = 0;
+
+    (void)in;
+    for (size_t i = 0; i < n; ++i)
+    {
+        const size_t slot = i % BENCH_ALLOC_LIVE;
+        free(live[slot]);
+
+        live[slot] = malloc((size_t)4096 << (bench_src[i] % 9));
+        *(volatile char *)live[slot] = 0;
+        acc += (uint64_t)(uintptr_t)live[slot];
+    }
+
+    for (size_t i = 0; i < BENCH_ALLOC_LIVE; ++i)
+        free(live[i]);
+
+    return acc;
+}
+
+static uint64_t bench_alloc_malloc(const uint64_t *in, size_t n)
+{
+    void *live[BENCH_ALLOC_LIVE] = {NULL};
+    uint64_t acc = 0;
+
+    (void)in;
+    for (size_t i = 0; i < n; ++i)
+    {
+        const size_t slot = i % BENCH_ALLOC_LIVE;
+        free(live[slot]);
+
+        live[slot] = malloc(16 + (size_t)(bench_src[i] & 0xFF));
+        *(volatile char *)live[slot] = 0;
+        acc += (uint64_t)(uintptr_t)live[slot];
+    }
+
+    for (size_t i = 0; i < BENCH_ALLOC_LIVE; ++i)
+        free(live[i]);
+
+    return acc;
+}
+
+/* Batch of BENCH_ALLOC_LIVE temporaries released together (arena rewind vs free of every object) */
+static karena_t bench_arena;
+
+static uint64_t bench_alloc_karena(const uint64_t *in, size_t n)
+{
+    uint64_t acc = 0;
+
+    (void)in;
+    const karena_mark_t mark = karena_mark(&bench_arena);
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (i % BENCH_ALLOC_LIVE == 0)
+            karena_rewind(&bench_arena, mark);
+
+        void *obj = karena_alloc(&bench_arena, 16 + (size_t)(bench_src[i] & 0xFF));
+        *(volatile char *)obj = 0;
+        acc += (uint64_t)(uintptr_t)obj;
+    }
+
+    karena_rewind(&bench_arena, mark);
+
+    return acc;
+}
+
+static uint64_t bench_alloc_malloc_batch(const uint64_t *in, size_t n)
+{
+    void *live[BENCH_ALLOC_LIVE] = {NULL};
+    uint64_t acc = 0;
+
+    (void)in;
+    for (size_t i = 0; i < n; ++i)
+    {
+        const size_t slot = i % BENCH_ALLOC_LIVE;
+        if (slot == 0)
+            for (size_t j = 0; j < BENCH_ALLOC_LIVE; ++j)
+            {
+                free(live[j]);
+                live[j] = NULL;
+            }
+
+        live[slot] = malloc(16 + (size_t)(bench_src[i] & 0xFF));
+        *(volatile char *)live[slot] = 0;
+        acc += (uint64_t)(uintptr_t)live[slot];
+    }
+
+    for (size_t i = 0; i < BENCH_ALLOC_LIVE; ++i)
+        free(live[i]);
+
+    return acc;
+}
+
+/* Fixed size objects (like connections) churned through cache of pool */
+typedef struct bench_conn
+{
+    uint64_t     id;
+    kpool_node_t node;
+    char         buf[112];
+} bench_conn_t;
+
+KPOOL_DEFINE(bench_conn_pool, bench_conn_t, node)
+
+static kpool_t bench_pool;
+static kpool_cache_t bench_pool_cache;
+
+static uint64_t bench_alloc_kpool(const uint64_t *in, size_t n)
+{
+    bench_conn_t *live[BENCH_ALLOC_LIVE] = {NULL};
+    uint64_t acc = 0;
+
+    (void)in;
+    for (size_t i = 0; i < n; ++i)
+    {
+        const size_t slot = (i * 7) % BENCH_ALLOC_LIVE;
+        bench_conn_pool_cache_free(&bench_pool_cache, live[slot]);
+
+        live[slot] = bench_conn_pool_cache_alloc(&bench_pool_cache);
+        *(volatile uint64_t *)&live[slot]->id = i;
+        acc += (uint64_t)(uintptr_t)live[slot];
+    }
+
+    for (size_t i = 0; i < BENCH_ALLOC_LIVE; ++i)
+        bench_conn_pool_cache_free(&bench_pool_cache, live[i]);
+
+    return acc;
+}
+
+static uint64_t bench_alloc_malloc_conn(const uint64_t *in, size_t n)
+{
+    bench_conn_t *live[BENCH_ALLOC_LIVE] = {NULL};
+    uint64_t acc = 0;
+
+    (void)in;
+    for (size_t i = 0; i < n; ++i)
+    {
+        const size_t slot = (i * 7) % BENCH_ALLOC_LIVE;
+        free(live[slot]);
+
+        live[slot] = malloc(sizeof(*live[slot]));
+        *(volatile uint64_t *)&live[slot]->id = i;
+        acc += (uint64_t)(uintptr_t)live[slot];
+    }
+
+    for (size_t i = 0; i < BENCH_ALLOC_LIVE; ++i)
+        free(live[i]);
+
+    return acc;
+}
+
+/*
+    Items handed from producer (kernel) to consumer thread. Consumer sleeps on semaphore between kernel calls,
+    so it does not take CPU from other cases. Full / empty side yields, so results are valid also on 1 CPU
+*/
+#define BENCH_PIPE_CAPACITY 1024
+#define BENCH_PIPE_BATCH    32
+
+typedef struct bench_mutex_ring
+{
+    pthread_mutex_t lock;
+    uint64_t        slots[BENCH_PIPE_CAPACITY];
+    size_t          head;
+    size_t          tail;
+} bench_mutex_ring_t;
+
+KRING_SPSC_DEFINE(bench_spsc, uint64_t)
+
+static bench_spsc_t bench_spsc_ring;
+static bench_mutex_ring_t bench_mutex_ring = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
+static pthread_t bench_pipe_thread;
+static bool bench_pipe_started;
+static sem_t bench_pipe_start;
+static sem_t bench_pipe_done;
+static size_t bench_pipe_items;
+static uint64_t bench_pipe_sum;
+static uint64_t (*bench_pipe_consume)(size_t n);
+
+static void *bench_pipe_consumer(void *arg)
+{
+    (void)arg;
+    for (;;)
+    {
+        (void)sem_wait(&bench_pipe_start);
+        if (bench_pipe_consume == NULL)
+            return NULL;
+
+        bench_pipe_sum = bench_pipe_consume(bench_pipe_items);
+        (void)sem_post(&bench_pipe_done);
+    }
+}
+
+static void bench_pipe_begin(uint64_t (*consume)(size_t n), size_t n)
+{
+    if (!bench_pipe_started)
+    {
+        (void)sem_init(&bench_pipe_start, 0, 0);
+        (void)sem_init(&bench_pipe_done, 0, 0);
+        if (bench_spsc_init(&bench_spsc_ring, BENCH_PIPE_CAPACITY) != 0 ||
+            pthread_create(&bench_pipe_thread, NULL, bench_pipe_consumer, NULL) != 0)
+        {
+            perror("bench_pipe_begin");
+            exit(1);
+        }
+
+        bench_pipe_started = true;
+    }
+
+    bench_pipe_consume = consume;
+    bench_pipe_items = n;
+    (void)sem_post(&bench_pipe_start);
+}
+
+static uint64_t bench_pipe_end(void)
+{
+    (void)sem_wait(&bench_pipe_done);
+    return bench_pipe_sum;
+}
+
+static void bench_pipe_stop(void)
+{
+    if (!bench_pipe_started)
+        return;
+
+    bench_pipe_consume = NULL;
+    (void)sem_post(&bench_pipe_start);
+    (void)pthread_join(bench_pipe_thread, NULL);
+    bench_spsc_destroy(&bench_spsc_ring);
+}
+
+static uint64_t bench_spsc_consume(size_t n)
+{
+    uint64_t sum = 0;
+    uint64_t item;
+
+    for (size_t i = 0; i < n; )
+    {
+        if (!bench_spsc_pop(&bench_spsc_ring, &item))
+        {
+            (void)sched_yield();
+            continue;
+        }
+
+        sum += item;
+        ++i;
+    }
+
+    return sum;
+}
+
+static uint64_t bench_spsc_consume_batch(size_t n)
+{
+    uint64_t sum = 0;
+    uint64_t items[BENCH_PIPE_BATCH];
+
+    for (size_t i = 0; i < n; )
+    {
+        const size_t popped = bench_spsc_pop_batch(&bench_spsc_ring, items, BENCH_PIPE_BATCH);
+        if (popped == 0)
+            (void)sched_yield();
+
+        for (size_t j = 0; j < popped; ++j)
+            sum += items[j];
+
+        i += popped;
+    }
+
+    return sum;
+}
+
+static uint64_t bench_mutex_consume(size_t n)
+{
+    uint64_t sum = 0;
+
+    for (size_t i = 0; i < n; )
+    {
+        bool popped = false;
+
+        (void)pthread_mutex_lock(&bench_mutex_ring.lock);
+        if (bench_mutex_ring.head != bench_mutex_ring.tail)
+        {
+            sum += bench_mutex_ring.slots[bench_mutex_ring.head++ % BENCH_PIPE_CAPACITY];
+            popped = true;
+        }
+        (void)pthread_mutex_unlock(&bench_mutex_ring.lock);
+
+        if (popped)
+            ++i;
+        else
+            (void)sched_yield();
+    }
+
+    return sum;
+}
+
+static uint64_t bench_pipe_kring(const uint64_t *in, size_t n)
+{
+    bench_pipe_begin(bench_spsc_consume, n);
+    for (size_t i = 0; i < n; )
+    {
+        if (bench_spsc_push(&bench_spsc_ring, in[i]))
+            ++i;
+        else
+            (void)sched_yield();
+    }
+
+    return bench_pipe_end();
+}
+
+static uint64_t bench_pipe_kring_batch(const uint64_t *in, size_t n)
+{
+    bench_pipe_begin(bench_spsc_consume_batch, n);
+    for (size_t i = 0; i < n; )
+    {
+        const size_t pushed = bench_spsc_push_batch(&bench_spsc_ring, &in[i], KMIN(n - i, (size_t)BENCH_PIPE_BATCH));
+        if (pushed == 0)
+            (void)sched_yield();
+
+        i += pushed;
+    }
+
+    return bench_pipe_end();
+}
+
+static uint64_t bench_pipe_mutex(const uint64_t *in, size_t n)
+{
+    bench_pipe_begin(bench_mutex_consume, n);
+    for (size_t i = 0; i < n; )
+    {
+        bool pushed = false;
+
+        (void)pthread_mutex_lock(&bench_mutex_ring.lock);
+        if (bench_mutex_ring.tail - bench_mutex_ring.head < BENCH_PIPE_CAPACITY)
+        {
+            bench_mutex_ring.slots[bench_mutex_ring.tail++ % BENCH_PIPE_CAPACITY] = in[i];
+            pushed = true;
+        }
+        (void)pthread_mutex_unlock(&bench_mutex_ring.lock);
+
+        if (pushed)
+            ++i;
+        else
+            (void)sched_yield();
+    }
+
+    return bench_pipe_end();
+}
+
+/* Uncontended lock / unlock around tiny critical section, cost of lock fast path */
+static kspinlock_t bench_spinlock = KSPINLOCK_INIT;
+static kticketlock_t bench_ticketlock = KTICKETLOCK_INIT;
+static kfutex_mutex_t bench_futex_mutex = KFUTEX_MUTEX_INIT;
+static pthread_mutex_t bench_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static kseqlock_t bench_seqlock = KSEQLOCK_INIT;
+static pthread_rwlock_t bench_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+static uint64_t bench_locked_data[2];
+
+static uint64_t bench_lock_kspinlock(const uint64_t *in, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        kspinlock_lock(&bench_spinlock);
+        bench_locked_data[0] += in[i];
+        kspinlock_unlock(&bench_spinlock);
+    }
+
+    return bench_locked_data[0];
+}
+
+static uint64_t bench_lock_kticketlock(const uint64_t *in, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        kticketlock_lock(&bench_ticketlock);
+        bench_locked_data[0] += in[i];
+        kticketlock_unlock(&bench_ticketlock);
+    }
+
+    return bench_locked_data[0];
+}
+
+static uint64_t bench_lock_kfutex(const uint64_t *in, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        kfutex_mutex_lock(&bench_futex_mutex);
+        bench_locked_data[0] += in[i];
+        kfutex_mutex_unlock(&bench_futex_mutex);
+    }
+
+    return bench_locked_data[0];
+}
+
+static uint64_t bench_lock_mutex(const uint64_t *in, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        (void)pthread_mutex_lock(&bench_mutex);
+        bench_locked_data[0] += in[i];
+        (void)pthread_mutex_unlock(&bench_mutex);
+    }
+
+    return bench_locked_data[0];
+}
+
+static uint64_t bench_read_kseqlock(const uint64_t *in, size_t n)
+{
+    uint64_t acc = 0;
+
+    (void)in;
+    for (size_t i = 0; i < n; ++i)
+    {
+        uint64_t a;
+        uint64_t b;
+        uint32_t seq;
+
+        do
+        {
+            seq = kseqlock_read_begin(&bench_seqlock);
+            a = KATOMIC_LOAD(&bench_locked_data[0], KATOMIC_RELAXED);
+            b = KATOMIC_LOAD(&bench_locked_data[1], KATOMIC_RELAXED);
+        } while (kseqlock_read_retry(&bench_seqlock, seq));
+
+        acc += a + b;
+    }
+
+    return acc;
+}
+
+static uint64_t bench_read_rwlock(const uint64_t *in, size_t n)
+{
+    uint64_t acc = 0;
+
+    (void)in;
+    for (size_t i = 0; i < n; ++i)
+    {
+        (void)pthread_rwlock_rdlock(&bench_rwlock);
+        acc += bench_locked_data[0] + bench_locked_data[1];
+        (void)pthread_rwlock_unlock(&bench_rwlock);
+    }
+
+    return acc;
+}
+
+static const bench_case_t bench_cases[] =
+{
+    {"KPOPCOUNT",   "builtin", bench_popcount_builtin,   true},
+    {"KPOPCOUNT",   "impl",    bench_popcount_impl,      true},
+    {"KPOPCOUNTL",  "builtin", bench_popcountl_builtin,  true},
+    {"KPOPCOUNTL",  "impl",    bench_popcountl_impl,     true},
+    {"KPOPCOUNTLL", "builtin", bench_popcountll_builtin, true},
+    {"KPOPCOUNTLL", "impl",    bench_popcountll_impl,    true},
+
+    {"KPOPCOUNT_BUFFER", "macro", bench_popcount_buffer_macro, true},
+    {"KPOPCOUNT_BUFFER", "ref",   bench_popcount_buffer_ref,   true},
+
+    {"KCLZ",   "builtin", bench_clz_builtin,   true},
+    {"KCLZ",   "impl",    bench_clz_impl,      true},
+    {"KCLZL",  "builtin", bench_clzl_builtin,  true},
+    {"KCLZL",  "impl",    bench_clzl_impl,     true},
+    {"KCLZLL", "builtin", bench_clzll_builtin, true},
+    {"KCLZLL", "impl",    bench_clzll_impl,    true},
+
+    {"KCTZ",   "builtin", bench_ctz_builtin,   true},
+    {"KCTZ",   "impl",    bench_ctz_impl,      true},
+    {"KCTZL",  "builtin", bench_ctzl_builtin,  true},
+    {"KCTZL",  "impl",    bench_ctzl_impl,     true},
+    {"KCTZLL", "builtin", bench_ctzll_builtin, true},
+    {"KCTZLL", "impl",    bench_ctzll_impl,    true},
+
+    {"KBSWAP16", "builtin", bench_bswap16_builtin, true},
+    {"KBSWAP16", "impl",    bench_bswap16_impl,    true},
+    {"KBSWAP32", "builtin", bench_bswap32_builtin, true},
+    {"KBSWAP32", "impl",    bench_bswap32_impl,    true},
+    {"KBSWAP64", "builtin", bench_bswap64_builtin, true},
+    {"KBSWAP64", "impl",    bench_bswap64_impl,    true},
+
+    {"KBSWAP32_ARRAY", "macro", bench_bswap32_array_macro, false},
+    {"KBSWAP32_ARRAY", "ref",   bench_bswap32_array_ref,   false},
+    {"KBSWAP64_ARRAY", "macro", bench_bswap64_array_macro, false},
+    {"KBSWAP64_ARRAY", "ref",   bench_bswap64_array_ref,   false},
+
+    {"KBIT_EXTRACT/even", "macro", bench_extract_even_macro, true},
+    {"KBIT_EXTRACT/even", "ref",   bench_extract_even_ref,   true},
+    {"KBIT_DEPOSIT/even", "macro", bench_deposit_even_macro, true},
+    {"KBIT_DEPOSIT/even", "ref",   bench_deposit_even_ref,   true},
+
+    {"KBIT_REVERSE/u32", "macro", bench_reverse_u32, true},
+    {"KBIT_REVERSE/u64", "macro", bench_reverse_u64, true},
+    {"KBIT_REVERSE_SIGNIFICANT/u32", "macro", bench_reverse_significant_u32, true},
+    {"KBIT_REVERSE_SIGNIFICANT/u64", "macro", bench_reverse_significant_u64, true},
+    {"KBIT_REVERSE_ARRAY", "macro", bench_reverse_array_macro, false},
+    {"KBIT_REVERSE_ARRAY", "ref",   bench_reverse_array_ref,   false},
+
+    {"KLOG2_FLOOR/u32", "builtin", bench_log2_floor_u32_builtin, true},
+    {"KLOG2_FLOOR/u32", "impl",    bench_log2_floor_u32_impl,    true},
+    {"KLOG2_FLOOR/u64", "builtin", bench_log2_floor_u64_builtin, true},
+    {"KLOG2_FLOOR/u64", "impl",    bench_log2_floor_u64_impl,    true},
+    {"KLOG2_CEIL/u32",  "builtin", bench_log2_ceil_u32_builtin,  true},
+    {"KLOG2_CEIL/u32",  "impl",    bench_log2_ceil_u32_impl,     true},
+    {"KLOG2_CEIL/u64",  "builtin", bench_log2_ceil_u64_builtin,  true},
+    {"KLOG2_CEIL/u64",  "impl",    bench_log2_ceil_u64_impl,     true},
+
+    {"KADD_OVERFLOW/i32", "builtin", bench_add_i32_builtin, true},
+    {"KADD_OVERFLOW/i32", "impl",    bench_add_i32_impl,    true},
+    {"KADD_OVERFLOW/u32", "builtin", bench_add_u32_builtin, true},
+    {"KADD_OVERFLOW/u32", "impl",    bench_add_u32_impl,    true},
+    {"KADD_OVERFLOW/i64", "builtin", bench_add_i64_builtin, true},
+    {"KADD_OVERFLOW/i64", "impl",    bench_add_i64_impl,    true},
+    {"KADD_OVERFLOW/u64", "builtin", bench_add_u64_builtin, true},
+    {"KADD_OVERFLOW/u64", "impl",    bench_add_u64_impl,    true},
+
+    {"KSUB_OVERFLOW/i32", "builtin", bench_sub_i32_builtin, true},
+    {"KSUB_OVERFLOW/i32", "impl",    bench_sub_i32_impl,    true},
+    {"KSUB_OVERFLOW/u32", "builtin", bench_sub_u32_builtin, true},
+    {"KSUB_OVERFLOW/u32", "impl",    bench_sub_u32_impl,    true},
+    {"KSUB_OVERFLOW/i64", "builtin", bench_sub_i64_builtin, true},
+    {"KSUB_OVERFLOW/i64", "impl",    bench_sub_i64_impl,    true},
+    {"KSUB_OVERFLOW/u64", "builtin", bench_sub_u64_builtin, true},
+    {"KSUB_OVERFLOW/u64", "impl",    bench_sub_u64_impl,    true},
+
+    {"KMUL_OVERFLOW/i32", "builtin", bench_mul_i32_builtin, true},
+    {"KMUL_OVERFLOW/i32", "impl",    bench_mul_i32_impl,    true},
+    {"KMUL_OVERFLOW/u32", "builtin", bench_mul_u32_builtin, true},
+    {"KMUL_OVERFLOW/u32", "impl",    bench_mul_u32_impl,    true},
+    {"KMUL_OVERFLOW/i64", "builtin", bench_mul_i64_builtin, true},
+    {"KMUL_OVERFLOW/i64", "impl",    bench_mul_i64_impl,    true},
+    {"KMUL_OVERFLOW/i64", "div",     bench_mul_i64_div,     true},
+    {"KMUL_OVERFLOW/u64", "builtin", bench_mul_u64_builtin, true},
+    {"KMUL_OVERFLOW/u64", "impl",    bench_mul_u64_impl,    true},
+    {"KMUL_OVERFLOW/u64", "limbs",   bench_mul_u64_limbs,   true},
+    {"KMUL_OVERFLOW/u64", "div",     bench_mul_u64_div,     true},
+
+    {"KSUM_OVERFLOW_ARRAY/i32", "macro", bench_sum_overflow_i32_macro, true},
+    {"KSUM_OVERFLOW_ARRAY/i32", "ref",   bench_sum_overflow_i32_ref,   true},
+    {"KSUM_OVERFLOW_ARRAY/i64", "macro", bench_sum_overflow_i64_macro, true},
+    {"KSUM_OVERFLOW_ARRAY/i64", "ref",   bench_sum_overflow_i64_ref,   true},
+    {"KDOT_OVERFLOW_ARRAY/i32", "macro", bench_dot_overflow_i32_macro, true},
+    {"KDOT_OVERFLOW_ARRAY/i32", "ref",   bench_dot_overflow_i32_ref,   true},
+    {"KDOT_OVERFLOW_ARRAY/i64", "macro", bench_dot_overflow_i64_macro, true},
+    {"KDOT_OVERFLOW_ARRAY/i64", "ref",   bench_dot_overflow_i64_ref,   true},
+
+    {"KADD_SAT_ARRAY/i32",      "macro", bench_add_sat_i32_macro,      true},
+    {"KADD_SAT_ARRAY/i32",      "ref",   bench_add_sat_i32_ref,        true},
+    {"KADD_SAT_ARRAY/i64",      "macro", bench_add_sat_i64_macro,      true},
+    {"KADD_SAT_ARRAY/i64",      "ref",   bench_add_sat_i64_ref,        true},
+    {"KMUL_SAT_ARRAY/i32",      "macro", bench_mul_sat_i32_macro,      true},
+    {"KMUL_SAT_ARRAY/i32",      "ref",   bench_mul_sat_i32_ref,        true},
+
+    {"KDIV_U32",       "macro", bench_div_u32_macro,       true},
+    {"KDIV_U32",       "ref",   bench_div_u32_ref,         true},
+    {"KMOD_U64",       "macro", bench_mod_u64_macro,       true},
+    {"KMOD_U64",       "ref",   bench_mod_u64_ref,         true},
+    {"KDIV_S64",       "macro", bench_div_s64_macro,       true},
+    {"KDIV_S64",       "ref",   bench_div_s64_ref,         true},
+    {"KDIV_U32_ARRAY", "macro", bench_div_u32_array_macro, true},
+    {"KDIV_U32_ARRAY", "ref",   bench_div_u32_array_ref,   true},
+
+    {"KFASTRANGE32",   "macro", bench_fastrange32_macro,   true},
+    {"KFASTRANGE32",   "ref",   bench_fastrange32_ref,     true},
+    {"KFASTRANGE64",   "macro", bench_fastrange64_macro,   true},
+    {"KFASTRANGE64",   "ref",   bench_fastrange64_ref,     true},
+
+    {"kslab_alloc/free", "kslab",  bench_alloc_kslab,  false},
+    {"kslab_alloc/free", "malloc", bench_alloc_malloc, false},
+    {"ktlsf_alloc/free", "ktlsf",  bench_alloc_ktlsf,  false},
+    {"ktlsf_alloc/free", "malloc", bench_alloc_malloc, false},
+    {"kbuddy_alloc/free", "kbuddy", bench_alloc_kbuddy,       false},
+    {"kbuddy_alloc/free", "malloc", bench_alloc_malloc_pages, false},
+    {"karena_alloc/rewind", "karena", bench_alloc_karena,       false},
+    {"karena_alloc/rewind", "malloc", bench_alloc_malloc_batch, false},
+    {"kpool_cache_alloc/free", "kpool",  bench_alloc_kpool,       false},
+    {"kpool_cache_alloc/free", "malloc", bench_alloc_malloc_conn, false},
+    {"kring_spsc push/pop", "kring",       bench_pipe_kring,       false},
+    {"kring_spsc push/pop", "kring_batch", bench_pipe_kring_batch, false},
+    {"kring_spsc push/pop", "mutex",       bench_pipe_mutex,       false},
+    {"lock/unlock", "kspinlock",   bench_lock_kspinlock,   false},
+    {"lock/unlock", "kticketlock", bench_lock_kticketlock, false},
+    {"lock/unlock", "kfutex",      bench_lock_kfutex,      false},
+    {"lock/unlock", "mutex",       bench_lock_mutex,       false},
+    {"read_lock",   "kseqlock",    bench_read_kseqlock,    false},
+    {"read_lock",   "rwlock",      bench_read_rwlock,      false},
+
+    {"KWRITE_SIZE_PTR/1",  "macro", bench_write1_macro,  false},
+    {"KWRITE_SIZE_PTR/1",  "ref",   bench_write1_ref,    false},
+    {"KWRITE_SIZE_PTR/2",  "macro", bench_write2_macro,  false},
+    {"KWRITE_SIZE_PTR/2",  "ref",   bench_write2_ref,    false},
+    {"KWRITE_SIZE_PTR/4",  "macro", bench_write4_macro,  false},
+    {"KWRITE_SIZE_PTR/4",  "ref",   bench_write4_ref,    false},
+    {"KWRITE_SIZE_PTR/8",  "macro", bench_write8_macro,  false},
+    {"KWRITE_SIZE_PTR/8",  "ref",   bench_write8_ref,    false},
+    {"KWRITE_SIZE_PTR/16", "macro", bench_write16_macro, false},
+    {"KWRITE_SIZE_PTR/16", "ref",   bench_write16_ref,   false},
+    {"KWRITE_SIZE_PTR/32", "macro", bench_write32_macro, false},
+    {"KWRITE_SIZE_PTR/32", "ref",   bench_write32_ref,   false},
+
+    {"KSWAP/u32",   "macro", bench_swap_u32_macro,   false},
+    {"KSWAP/u32",   "ref",   bench_swap_u32_ref,     false},
+    {"KSWAP/obj16", "macro", bench_swap_obj16_macro, false},
+    {"KSWAP/obj16", "ref",   bench_swap_obj16_ref,   false},
+    {"KSWAP/obj64", "macro", bench_swap_obj64_macro, false},
+    {"KSWAP/obj64", "ref",   bench_swap_obj64_ref,   false},
+};
+
+/*********** DRIVER ******************/
+
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t bench_now_cycles(void)
+{
+#ifdef BENCH_HAS_TSC
+    return (uint64_t)__rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static void bench_run_case(FILE *out, const bench_case_t *c, const char *dist)
+{
+    const size_t reps = BENCH_OPS / BENCH_N;
+    double best_ns = 0.0;
+    double best_cycles = 0.0;
+
+    /* warm up caches and branch predictors */
+    bench_sink += c->kernel(bench_in, BENCH_N);
+
+    for (size_t run = 0; run < BENCH_RUNS; ++run)
+    {
+        uint64_t acc = 0;
+        const uint64_t ns_start = bench_now_ns();
+        const uint64_t cycles_start = bench_now_cycles();
+
+        for (size_t r = 0; r < reps; ++r)
+            acc += c->kernel(bench_in, BENCH_N);
+
+        const uint64_t cycles_end = bench_now_cycles();
+        const uint64_t ns_end = bench_now_ns();
+
+        bench_sink += acc;
+
+        const double ns = (double)(ns_end - ns_start) / (double)(reps * BENCH_N);
+        const double cycles = (double)(cycles_end - cycles_start) / (double)(reps * BENCH_N);
+
+        if (run == 0 || ns < best_ns)
+        {
+            best_ns = ns;
+            best_cycles = cycles;
+        }
+    }
+
+#ifndef BENCH_HAS_TSC
+    best_cycles = -1.0;
+#endif
+
+    fprintf(out, "%s %d.%d,%s,%s,%s,%.3f,%.3f\n",
+#ifdef KCOMPILER_CLANG
+            "clang",
+#elif defined(KCOMPILER_GCC)
+            "gcc",
+#else
+            "unknown",
+#endif
+            KCOMPILER_MAJOR_VERSION, KCOMPILER_MINOR_VERSION,
+            c->op, c->path, dist, best_ns, best_cycles);
+}
+
+/*
+    Contention of MPMC queue: every thread pushes and pops in loop, so all threads hit both cursors.
+    Lock-free queue is compared with ring guarded by mutex
+*/
+#define BENCH_MPMC_CAPACITY     1024
+#define BENCH_THREADS_OPS       (1u << 20)
+#define BENCH_THREADS_MAX       64
+
+KQUEUE_MPMC_DEFINE(bench_mpmc, uint64_t)
+
+static bench_mpmc_t bench_mpmc_queue;
+static bench_mutex_ring_t bench_mpmc_mutex_ring = {.lock = PTHREAD_MUTEX_INITIALIZER};
+static pthread_barrier_t bench_threads_barrier;
+static size_t bench_threads_ops;
+
+static bool bench_mutex_ring_push(bench_mutex_ring_t *ring, uint64_t item)
+{
+    bool pushed = false;
+
+    (void)pthread_mutex_lock(&ring->lock);
+    if (ring->tail - ring->head < BENCH_PIPE_CAPACITY)
+    {
+        ring->slots[ring->tail++ % BENCH_PIPE_CAPACITY] = item;
+        pushed = true;
+    }
+    (void)pthread_mutex_unlock(&ring->lock);
+
+    return pushed;
+}
+
+static bool bench_mutex_ring_pop(bench_mutex_ring_t *ring, uint64_t *item)
+{
+    bool popped = false;
+
+    (void)pthread_mutex_lock(&ring->lock);
+    if (ring->head != ring->tail)
+    {
+        *item = ring->slots[ring->head++ % BENCH_PIPE_CAPACITY];
+        popped = true;
+    }
+    (void)pthread_mutex_unlock(&ring->lock);
+
+    return popped;
+}
+
+static void *bench_mpmc_kqueue_thread(void *arg)
+{
+    uint64_t sum = 0;
+    uint64_t item;
+
+    (void)arg;
+    (void)pthread_barrier_wait(&bench_threads_barrier);
+    for (size_t i = 0; i < bench_threads_ops; ++i)
+    {
+        while (!bench_mpmc_push(&bench_mpmc_queue, i))
+            (void)sched_yield();
+
+        while (!bench_mpmc_pop(&bench_mpmc_queue, &item))
+            (void)sched_yield();
+
+        sum += item;
+    }
+
+    bench_sink += sum;
+
+    return NULL;
+}
+
+static void *bench_mpmc_mutex_thread(void *arg)
+{
+    uint64_t sum = 0;
+    uint64_t item;
+
+    (void)arg;
+    (void)pthread_barrier_wait(&bench_threads_barrier);
+    for (size_t i = 0; i < bench_threads_ops; ++i)
+    {
+        while (!bench_mutex_ring_push(&bench_mpmc_mutex_ring, i))
+            (void)sched_yield();
+
+        while (!bench_mutex_ring_pop(&bench_mpmc_mutex_ring, &item))
+            (void)sched_yield();
+
+        sum += item;
+    }
+
+    bench_sink += sum;
+
+    return NULL;
+}
+
+/* Every thread does bench_threads_ops iterations of ops_per_iter operations, op is reported per operation */
+static void bench_run_threads(FILE *out, const char *op, const char *path, void *(*thread)(void *arg),
+                              size_t nthreads, size_t ops_per_iter)
+{
+    pthread_t threads[BENCH_THREADS_MAX];
+    double best_ns = 0.0;
+    char dist[32];
+
+    bench_threads_ops = BENCH_THREADS_OPS / nthreads;
+    for (size_t run = 0; run < BENCH_RUNS; ++run)
+    {
+        (void)pthread_barrier_init(&bench_threads_barrier, NULL, (unsigned int)nthreads + 1);
+        for (size_t i = 0; i < nthreads; ++i)
+            if (pthread_create(&threads[i], NULL, thread, NULL) != 0)
+            {
+                perror("pthread_create");
+                exit(1);
+            }
+
+        (void)pthread_barrier_wait(&bench_threads_barrier);
+        const uint64_t ns_start = bench_now_ns();
+
+        for (size_t i = 0; i < nthreads; ++i)
+            (void)pthread_join(threads[i], NULL);
+
+        const uint64_t ns_end = bench_now_ns();
+        (void)pthread_barrier_destroy(&bench_threads_barrier);
+
+        const double ns = (double)(ns_end - ns_start) / (double)(ops_per_iter * bench_threads_ops * nthreads);
+        if (run == 0 || ns < best_ns)
+            best_ns = ns;
+    }
+
+    (void)snprintf(dist, sizeof(dist), "threads=%zu", nthreads);
+    fprintf(out, "%s %d.%d,%s,%s,%s,%.3f,%.3f\n",
+#ifdef KCOMPILER_CLANG
+            "clang",
+#elif defined(KCOMPILER_GCC)
+            "gcc",
+#else
+            "unknown",
+#endif
+            KCOMPILER_MAJOR_VERSION, KCOMPILER_MINOR_VERSION,
+            op, path, dist, best_ns, -1.0);
+}
+
+static void bench_mpmc_scaling(FILE *out)
+{
+    if (bench_mpmc_init(&bench_mpmc_queue, BENCH_MPMC_CAPACITY) != 0)
+    {
+        perror("bench_mpmc_init");
+        exit(1);
+    }
+
+    /* push and pop are 2 operations */
+    for (size_t nthreads = 1; nthreads <= BENCH_THREADS_MAX; nthreads *= 2)
+    {
+        bench_run_threads(out, "kqueue_mpmc push+pop", "kqueue", bench_mpmc_kqueue_thread, nthreads, 2);
+        bench_run_threads(out, "kqueue_mpmc push+pop", "mutex", bench_mpmc_mutex_thread, nthreads, 2);
+    }
+
+    bench_mpmc_destroy(&bench_mpmc_queue);
+}
+
+/*
+    Contention of sleeping mutex: every thread increments shared counter under lock and does a bit of
+    private work outside of it. More threads than CPUs forces waiters to sleep in kernel
+*/
+#define BENCH_CONTENTION_WORK   32
+
+static kfutex_mutex_t bench_contention_futex = KFUTEX_MUTEX_INIT;
+static pthread_mutex_t bench_contention_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t bench_contention_counter;
+
+static uint64_t bench_contention_work(uint64_t x)
+{
+    for (size_t i = 0; i < BENCH_CONTENTION_WORK; ++i)
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+
+    return x;
+}
+
+static void *bench_contention_kfutex_thread(void *arg)
+{
+    uint64_t x = bench_threads_ops;
+
+    (void)arg;
+    (void)pthread_barrier_wait(&bench_threads_barrier);
+    for (size_t i = 0; i < bench_threads_ops; ++i)
+    {
+        kfutex_mutex_lock(&bench_contention_futex);
+        bench_contention_counter += x;
+        kfutex_mutex_unlock(&bench_contention_futex);
+
+        x = bench_contention_work(x);
+    }
+
+    return NULL;
+}
+
+static void *bench_contention_mutex_thread(void *arg)
+{
+    uint64_t x = bench_threads_ops;
+
+    (void)arg;
+    (void)pthread_barrier_wait(&bench_threads_barrier);
+    for (size_t i = 0; i < bench_threads_ops; ++i)
+    {
+        (void)pthread_mutex_lock(&bench_contention_mutex);
+        bench_contention_counter += x;
+        (void)pthread_mutex_unlock(&bench_contention_mutex);
+
+        x = bench_contention_work(x);
+    }
+
+    return NULL;
+}
+
+static void bench_contention_scaling(FILE *out)
+{
+    for (size_t nthreads = 1; nthreads <= BENCH_THREADS_MAX; nthreads *= 2)
+    {
+        bench_run_threads(out, "lock/unlock contended", "kfutex", bench_contention_kfutex_thread, nthreads, 1);
+        bench_run_threads(out, "lock/unlock contended", "mutex", bench_contention_mutex_thread, nthreads, 1);
+    }
+
+    bench_sink += bench_contention_counter;
+}
+
+int main(int argc, char **argv)
+{
+    FILE *out = stdout;
+
+    if (argc > 1)
+    {
+        out = fopen(argv[1], "w");
+        if (out == NULL)
+        {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+
+    for (size_t i = 0; i < KARRAY_SIZE(bench_src); ++i)
+        bench_src[i] = bench_rand();
+
+    kslab_init(&bench_slab);
+    bench_tlsf = ktlsf_create(bench_tlsf_pool, sizeof(bench_tlsf_pool));
+    kbuddy_init(&bench_buddy);
+    if (kbuddy_add_arena(&bench_buddy, KBUDDY_BLOCK_SIZE_MAX, KBUDDY_ARENA_THP) != 0)
+    {
+        perror("kbuddy_add_arena");
+        return 1;
+    }
+    karena_init(&bench_arena, 0);
+    if (bench_conn_pool_init(&bench_pool, 0) != 0)
+    {
+        perror("kpool_init");
+        return 1;
+    }
+    bench_conn_pool_cache_init(&bench_pool_cache, &bench_pool);
+
+    fprintf(out, "compiler,op,path,dist,ns_per_op,cycles_per_op\n");
+
+    for (size_t d = 0; d < KARRAY_SIZE(bench_dists); ++d)
+    {
+        bench_dists[d].gen(bench_in, BENCH_N);
+
+        for (size_t i = 0; i < KARRAY_SIZE(bench_cases); ++i)
+            if (bench_cases[i].use_dist)
+                bench_run_case(out, &bench_cases[i], bench_dists[d].name);
+    }
+
+    for (size_t i = 0; i < KARRAY_SIZE(bench_cases); ++i)
+        if (!bench_cases[i].use_dist)
+            bench_run_case(out, &bench_cases[i], "-");
+
+    bench_mpmc_scaling(out);
+    bench_contention_scaling(out);
+
+    kslab_destroy(&bench_slab);
+    kbuddy_destroy(&bench_buddy);
+    karena_destroy(&bench_arena);
+    bench_conn_pool_cache_destroy(&bench_pool_cache);
+    bench_conn_pool_destroy(&bench_pool);
+    bench_pipe_stop();
+
+    if (out != stdout)
+        fclose(out);
+
+    return 0;
+}
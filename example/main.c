@@ -84,6 +84,22 @@ static inline void f_var_attr(void)
 /*************************************************************************************/
 
 extern void test_builtins_impl(void);
+extern void test_kbitset(void);
+extern void test_kbits(void);
+extern void test_karith(void);
+extern void test_kint128(void);
+extern void test_kdivider(void);
+extern void test_kmacros_common(void);
+extern void test_kslab(void);
+extern void test_ktlsf(void);
+extern void test_kbuddy(void);
+extern void test_karena(void);
+extern void test_kpool(void);
+extern void test_kring(void);
+extern void test_kqueue(void);
+extern void test_katomic(void);
+extern void test_klock(void);
+extern void test_kfutex(void);
 
 static void example_preprocessr_tricks(void);
 static void example_compiler_diag(void);
@@ -518,6 +534,8 @@ static void example_common_macros(void)
     printf("roundUp(%lu) = %lu, roundDown(%lu) = %lu, allign(%lu) = %lu\n", c, KROUND_POWER2_UP(c), c, KROUND_POWER2_DOWN(c), c, KALLIGN_POWER2(c));
     printf("roundUp(%llu) = %llu, roundDown(%llu) = %llu, allign(%llu) = %llu\n", d, KROUND_POWER2_UP(d), d, KROUND_POWER2_DOWN(d), d, KALLIGN_POWER2(d));
 
+    printf("fastrange(%#x, %u) = %u, bucket(%#x, %u) = %u, %u mod %u = %u\n", 0x9E3779B9u, b, KFASTRANGE32(0x9E3779B9u, b), 0x9E3779B9u, 1024u, KBUCKET_INDEX32(0x9E3779B9u, 1024u), 77u, 32u, KMOD_POW2(77u, 32u));
+
     printf("MIN(%d %d %d) = %d\n", 100, 50, -100, KMIN(100, 50, -100));
     printf("MIN(%lf %lf %lf %lf %lf) = %lf\n", 0.2, 50.1, -1323.1312, -100.11, 0.0, KMIN(0.2, 50.1, -1323.1312, -100.11, 0.0));
 
@@ -680,6 +698,22 @@ int main(void)
     example_common_macros();
 
     test_builtins_impl();
+    test_kbitset();
+    test_kbits();
+    test_karith();
+    test_kint128();
+    test_kdivider();
+    test_kmacros_common();
+    test_kslab();
+    test_ktlsf();
+    test_kbuddy();
+    test_karena();
+    test_kpool();
+    test_kring();
+    test_kqueue();
+    test_katomic();
+    test_klock();
+    test_kfutex();
 
     // fdeprecated();
     // ferrore();
@@ -14,15 +14,15 @@ static void test_clrsb(void);
 static void test_popcount(void);
 static void test_parity(void);
 static void test_bswap(void);
+static void test_bit_patterns(void);
 static void test_overflow(void);
 
 static void test_only_compiling_builtins(void)
 {
-    if (kbuiltin_expect_impl(10, 11))
-        assert(10 == 11);
-
-    if (kbuiltin_expect_with_probability_impl(10, 11, 0.5))
-        assert(10 == 11);
+    /* the same as __builtin_expect, hint does not change value of cond */
+    assert(kbuiltin_expect_impl(10, 11) == 10);
+    assert(kbuiltin_expect_impl(0, 1) == 0);
+    assert(kbuiltin_expect_with_probability_impl(10, 11, 0.5) == 10);
 
     int x = kbuiltin_choose_expr_impl(10 == 11, 10, 11);
     assert(x == 11);
@@ -345,6 +345,71 @@ static void test_bswap(void)
     assert(__builtin_bswap64(z) == kbuiltin_bswap64_impl(z));
 }
 
+static void test_bit_patterns(void)
+{
+    /* Single bits, low masks, high masks and some pseudo random words (xorshift64) */
+    unsigned long long seed = 0x9E3779B97F4A7C15ull;
+    unsigned long long patterns[3 * 64 + 256];
+    size_t n = 0;
+
+    for (size_t i = 0; i < sizeof(patterns[0]) * CHAR_BIT; ++i)
+    {
+        patterns[n++] = 1ull << i;
+        patterns[n++] = (1ull << i) - 1;
+        patterns[n++] = ~((1ull << i) - 1);
+    }
+
+    while (n < KARRAY_SIZE(patterns))
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        patterns[n++] = seed;
+    }
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        const unsigned long long z = patterns[i];
+        const unsigned long y = (unsigned long)z;
+        const unsigned int x = (unsigned int)z;
+
+        assert(__builtin_ffs((int)x) == kbuiltin_ffs_impl((int)x));
+        assert(__builtin_ffsl((long)y) == kbuiltin_ffsl_impl((long)y));
+        assert(__builtin_ffsll((long long)z) == kbuiltin_ffsll_impl((long long)z));
+
+        assert(__builtin_clrsb((int)x) == kbuiltin_clrsb_impl((int)x));
+        assert(__builtin_clrsbl((long)y) == kbuiltin_clrsbl_impl((long)y));
+        assert(__builtin_clrsbll((long long)z) == kbuiltin_clrsbll_impl((long long)z));
+
+        assert(__builtin_popcount(x) == kbuiltin_popcount_impl(x));
+        assert(__builtin_popcountl(y) == kbuiltin_popcountl_impl(y));
+        assert(__builtin_popcountll(z) == kbuiltin_popcountll_impl(z));
+
+        assert(__builtin_parity(x) == kbuiltin_parity_impl(x));
+        assert(__builtin_parityl(y) == kbuiltin_parityl_impl(y));
+        assert(__builtin_parityll(z) == kbuiltin_parityll_impl(z));
+
+        /* clz and ctz are undefined for 0 */
+        if (x != 0)
+        {
+            assert(__builtin_clz(x) == kbuiltin_clz_impl(x));
+            assert(__builtin_ctz(x) == kbuiltin_ctz_impl(x));
+        }
+
+        if (y != 0)
+        {
+            assert(__builtin_clzl(y) == kbuiltin_clzl_impl(y));
+            assert(__builtin_ctzl(y) == kbuiltin_ctzl_impl(y));
+        }
+
+        if (z != 0)
+        {
+            assert(__builtin_clzll(z) == kbuiltin_clzll_impl(z));
+            assert(__builtin_ctzll(z) == kbuiltin_ctzll_impl(z));
+        }
+    }
+}
+
 #if defined(KCOMPILER_CLANG) || (defined(KCOMPILER_GCC) && (defined(__x86_64__) || defined(__i386__)))
 
 static void test_overflow_addi(void);
@@ -1469,6 +1534,69 @@ static void test_overflow_mul_generic(void)
     assert(res_built6 == res_impl6);
 }
 
+/* Zero, signs and values around sqrt(MAX) for every pair */
+#define TEST_OVERFLOW_MUL_EDGES(type, builtin, impl, ...) \
+    do { \
+        const type edges[] = { __VA_ARGS__ }; \
+        for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); ++i) \
+            for (size_t j = 0; j < sizeof(edges) / sizeof(edges[0]); ++j) \
+            { \
+                type res_built; \
+                type res_impl; \
+                const bool overflow_built = builtin(edges[i], edges[j], &res_built); \
+                const bool overflow_impl = impl(edges[i], edges[j], &res_impl); \
+                assert(overflow_built == overflow_impl); \
+                assert(res_built == res_impl); \
+            } \
+    } while (0)
+
+static void test_overflow_mul_edges(void)
+{
+    TEST_OVERFLOW_MUL_EDGES(int, __builtin_smul_overflow, kbuiltin_smul_overflow_impl,
+                            0, 1, -1, 2, -2, 46340, 46341, -46340, -46341, INT_MAX, INT_MIN, INT_MAX / 2, INT_MIN / 2);
+    TEST_OVERFLOW_MUL_EDGES(long long, __builtin_smulll_overflow, kbuiltin_smulll_overflow_impl,
+                            0, 1, -1, 2, -2, 3037000499LL, 3037000500LL, -3037000499LL, -3037000500LL,
+                            LLONG_MAX, LLONG_MIN, LLONG_MAX / 2, LLONG_MIN / 2);
+    TEST_OVERFLOW_MUL_EDGES(unsigned int, __builtin_umul_overflow, kbuiltin_umul_overflow_impl,
+                            0, 1, 2, 65535, 65536, 65537, UINT_MAX, UINT_MAX / 2);
+    TEST_OVERFLOW_MUL_EDGES(unsigned long long, __builtin_umulll_overflow, kbuiltin_umulll_overflow_impl,
+                            0, 1, 2, 4294967295ULL, 4294967296ULL, 4294967297ULL, ULLONG_MAX, ULLONG_MAX / 2);
+}
+
+/* Schoolbook fallback is used only without __int128, so check it against __int128 product */
+static void test_overflow_mul_wide_limbs(void)
+{
+#ifdef KCOMPILER_HAS_INT128
+    const uint64_t edges[] = {0, 1, 2, UINT32_MAX, (uint64_t)UINT32_MAX + 1, UINT64_MAX, UINT64_MAX / 2, UINT64_MAX - UINT32_MAX};
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+
+    for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]) + 1000; ++i)
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+
+        const uint64_t x = i < sizeof(edges) / sizeof(edges[0]) ? edges[i] : seed;
+        for (size_t j = 0; j < sizeof(edges) / sizeof(edges[0]); ++j)
+        {
+            const uint64_t ys[2] = {edges[j], seed * 0xD6E8FEB86659FD93ull};
+            for (size_t k = 0; k < 2; ++k)
+            {
+                __extension__ const unsigned __int128 p = (unsigned __int128)x * ys[k];
+                uint64_t hi;
+                const uint64_t lo = __kmul64_wide_limbs(x, ys[k], &hi);
+                assert(lo == (uint64_t)p);
+                assert(hi == (uint64_t)(p >> 64));
+
+                uint64_t r;
+                const bool overflow = __kumul64_overflow_limbs(x, ys[k], &r);
+                assert(r == lo && overflow == (hi != 0));
+            }
+        }
+    }
+#endif
+}
+
 static void test_overflow(void)
 {
     test_overflow_addi();
@@ -1494,6 +1622,8 @@ static void test_overflow(void)
     test_overflow_mulll();
     test_overflow_mulull();
     test_overflow_mul_generic();
+    test_overflow_mul_edges();
+    test_overflow_mul_wide_limbs();
 }
 
 #else
@@ -1516,6 +1646,7 @@ void test_builtins_impl(void)
     test_popcount();
     test_parity();
     test_bswap();
+    test_bit_patterns();
     test_overflow();
 }
 
@@ -0,0 +1,150 @@
+#include <kmacros/karena.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+void test_karena(void);
+
+typedef struct test_karena_obj
+{
+    double   d;
+    uint32_t x;
+} test_karena_obj_t;
+
+static void test_karena_alloc(void)
+{
+    karena_t arena;
+    karena_init(&arena, 1024);
+
+    char *prev = NULL;
+    for (size_t i = 1; i < 200; ++i)
+    {
+        const size_t align = i % 7 == 0 ? 64 : i % 5;
+        char *p = karena_alloc_aligned(&arena, i, align);
+        assert(p != NULL);
+
+        /* not power of 2 alignment is rounded up */
+        const size_t real_align = align <= 1 ? 1 : KROUND_POWER2_UP(align);
+        assert((uintptr_t)p % real_align == 0);
+        memset(p, (int)i, i);
+
+        if (prev != NULL)
+            assert(prev[0] == (char)(i - 1));
+
+        prev = p;
+    }
+
+    /* bigger than chunk gets own chunk */
+    char *big = karena_alloc(&arena, 10000);
+    assert(big != NULL && (uintptr_t)big % _Alignof(max_align_t) == 0);
+    memset(big, 1, 10000);
+
+    test_karena_obj_t *obj = KARENA_NEW(&arena, test_karena_obj_t);
+    assert(obj != NULL && (uintptr_t)obj % _Alignof(test_karena_obj_t) == 0);
+
+    /* consecutive allocations are consecutive in memory */
+    char *a = karena_alloc_aligned(&arena, 8, 8);
+    char *b = karena_alloc_aligned(&arena, 8, 8);
+    assert(b == a + 8);
+
+    karena_destroy(&arena);
+    assert(arena.chunk == NULL && arena.spare == NULL && arena.chunk_size == 1024);
+}
+
+static void test_karena_rewind(void)
+{
+    karena_t arena;
+    karena_init(&arena, 256);
+
+    char *first = karena_alloc(&arena, 16);
+    const karena_mark_t mark = karena_mark(&arena);
+    char *second = karena_alloc(&arena, 16);
+
+    for (size_t i = 0; i < 100; ++i)
+        assert(karena_alloc(&arena, 100) != NULL);
+
+    /* memory after mark is reused, chunks are not freed */
+    karena_rewind(&arena, mark);
+    assert(arena.spare != NULL);
+    assert(karena_alloc(&arena, 16) == second);
+
+    karena_chunk_t *spare = arena.spare;
+    assert(karena_alloc(&arena, 200) != NULL && karena_alloc(&arena, 200) != NULL);
+    assert(arena.chunk == spare);
+
+    karena_reset(&arena);
+    assert(arena.chunk == NULL && arena.used == 0);
+    assert(karena_alloc(&arena, 16) != NULL);
+
+    (void)first;
+    karena_destroy(&arena);
+}
+
+static void test_karena_huge(void)
+{
+    karena_t arena;
+    karena_init(&arena, 1024);
+
+    char *first = karena_alloc(&arena, 16);
+    assert(first != NULL);
+
+    /* size + padding or chunk header does not fit into size_t */
+    assert(karena_alloc(&arena, SIZE_MAX - 8) == NULL);
+    assert(karena_alloc_aligned(&arena, SIZE_MAX - 8, 64) == NULL);
+    assert(karena_alloc_aligned(&arena, SIZE_MAX - sizeof(karena_chunk_t) / 2, 1) == NULL);
+
+    /* failed allocations do not change arena */
+    char *next = karena_alloc(&arena, 16);
+    assert(next == first + 16);
+
+    /* new chunk for alignment bigger than max_align_t */
+    char *page = karena_alloc_aligned(&arena, 5000, 4096);
+    assert(page != NULL && (uintptr_t)page % 4096 == 0);
+    memset(page, 1, 5000);
+
+    karena_destroy(&arena);
+}
+
+#ifdef KATTR_VAR_CLEANUP_SUPPORTED
+static void test_karena_scope(void)
+{
+    karena_t arena;
+    karena_init(&arena, 0);
+
+    char *before = karena_alloc(&arena, 32);
+    const karena_mark_t mark = karena_mark(&arena);
+
+    for (size_t i = 0; i < 10; ++i)
+    {
+        KARENA_SCOPE(&arena);
+
+        char *tmp = karena_alloc(&arena, 1000);
+        assert(tmp != NULL);
+        tmp[999] = 1;
+
+        {
+            KARENA_SCOPE(&arena);
+            assert(karena_alloc(&arena, 100000) != NULL);
+        }
+    }
+
+    /* every scope has been rewound */
+    const karena_mark_t now = karena_mark(&arena);
+    assert(now.chunk == mark.chunk && now.used == mark.used);
+
+    (void)before;
+    karena_destroy(&arena);
+}
+#endif
+
+void test_karena(void)
+{
+    test_karena_alloc();
+    test_karena_rewind();
+    test_karena_huge();
+#ifdef KATTR_VAR_CLEANUP_SUPPORTED
+    test_karena_scope();
+#endif
+}
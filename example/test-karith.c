@@ -0,0 +1,182 @@
+#include <kmacros/kmacros.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <limits.h>
+
+#include "test-rand.h"
+
+void test_karith(void);
+
+/* Bigger than block, with not full last block */
+#define TEST_KARITH_N 3000
+
+static uint64_t test_karith_seed = 0xD1B54A32D192ED03ull;
+
+/*
+    Modes of generated values:
+    0 - small values, no overflow
+    1 - full range values, overflow very quickly
+    2 - values near max and near min, prefix sums go out of range and back
+    3 - small values and one huge in the middle
+*/
+#define TEST_KARITH_GEN(type, arr, n, mode, tmin, tmax) \
+    do { \
+        for (size_t __i = 0; __i < (n); ++__i) \
+        { \
+            const uint64_t __r = test_rand_next(&test_karith_seed); \
+            switch (mode) \
+            { \
+                case 0: arr[__i] = (type)(__r % 1000); if ((tmin) != 0 && (__r & 1)) arr[__i] = (type)(0 - arr[__i]); break; \
+                case 1: arr[__i] = (type)__r; break; \
+                case 2: arr[__i] = (__r & 1) ? (type)((tmax) - (type)(__r % 16)) : (type)((tmin) + (type)(__r % 16)); break; \
+                default: arr[__i] = (type)(__r % 100); if (__i == (n) / 2) arr[__i] = (tmax); break; \
+            } \
+        } \
+    } while (0)
+
+#define TEST_KARITH_TYPE(type, tmin, tmax) \
+    do { \
+        static type a[TEST_KARITH_N]; \
+        static type b[TEST_KARITH_N]; \
+        for (int mode = 0; mode < 4; ++mode) \
+        { \
+            TEST_KARITH_GEN(type, a, TEST_KARITH_N, mode, tmin, tmax); \
+            TEST_KARITH_GEN(type, b, TEST_KARITH_N, mode, tmin, tmax); \
+            \
+            for (size_t n = 0; n <= TEST_KARITH_N; n += (n < 20 ? 1 : 997)) \
+            { \
+                type sum_ref = 0; \
+                type dot_ref = 0; \
+                bool sum_overflow_ref = false; \
+                bool dot_overflow_ref = false; \
+                for (size_t i = 0; i < n; ++i) \
+                { \
+                    type p; \
+                    sum_overflow_ref |= KADD_OVERFLOW(sum_ref, a[i], &sum_ref); \
+                    dot_overflow_ref |= KMUL_OVERFLOW(a[i], b[i], &p); \
+                    dot_overflow_ref |= KADD_OVERFLOW(dot_ref, p, &dot_ref); \
+                } \
+                \
+                type sum; \
+                type dot; \
+                const bool sum_overflow = KSUM_OVERFLOW_ARRAY(a, n, &sum); \
+                const bool dot_overflow = KDOT_OVERFLOW_ARRAY(a, b, n, &dot); \
+                assert(sum == sum_ref && sum_overflow == sum_overflow_ref); \
+                assert(dot == dot_ref && dot_overflow == dot_overflow_ref); \
+            } \
+        } \
+    } while (0)
+
+static void test_karith_overflow_array(void)
+{
+    /* Prefix overflows, but final sum fits, chain reports overflow */
+    const int t[3] = {INT_MAX, 1, -1};
+    int res;
+    assert(KSUM_OVERFLOW_ARRAY(t, 3, &res) == true && res == INT_MAX);
+    assert(KSUM_OVERFLOW_ARRAY(t, 1, &res) == false && res == INT_MAX);
+
+    const unsigned long long u[2] = {ULLONG_MAX, 1};
+    unsigned long long ures;
+    assert(KSUM_OVERFLOW_ARRAY(u, 2, &ures) == true && ures == 0);
+    assert(KDOT_OVERFLOW_ARRAY(u, u, 2, &ures) == true);
+
+    TEST_KARITH_TYPE(int, INT_MIN, INT_MAX);
+    TEST_KARITH_TYPE(unsigned int, 0u, UINT_MAX);
+    TEST_KARITH_TYPE(long, LONG_MIN, LONG_MAX);
+    TEST_KARITH_TYPE(unsigned long, 0ul, ULONG_MAX);
+    TEST_KARITH_TYPE(long long, LLONG_MIN, LLONG_MAX);
+    TEST_KARITH_TYPE(unsigned long long, 0ull, ULLONG_MAX);
+}
+
+/* Reference: overflow macro and branch, saturated value from signs of operands */
+#define TEST_KARITH_SAT_REF(op, x, y, zero, tmin, tmax, res) \
+    do { \
+        if (KCONCAT(op, _OVERFLOW)(x, y, &(res))) \
+        { \
+            (res) = TEST_KARITH_SAT_IS_MAX(op, (x) < (zero), (y) < (zero)) ? (tmax) : (tmin); \
+        } \
+    } while (0)
+
+#define TEST_KARITH_SAT_IS_MAX(op, x_neg, y_neg) \
+    (KCONCAT(TEST_KARITH_SAT_IS_MAX_, op)(x_neg, y_neg))
+
+#define TEST_KARITH_SAT_IS_MAX_KADD(x_neg, y_neg) (!(x_neg))
+#define TEST_KARITH_SAT_IS_MAX_KSUB(x_neg, y_neg) (y_neg)
+#define TEST_KARITH_SAT_IS_MAX_KMUL(x_neg, y_neg) ((x_neg) == (y_neg))
+
+#define TEST_KARITH_SAT_TYPE(type, tmin, tmax) \
+    do { \
+        static type a[TEST_KARITH_N]; \
+        static type b[TEST_KARITH_N]; \
+        static type dst[TEST_KARITH_N]; \
+        /* not a constant, to compare also unsigned values with 0 without warnings */ \
+        volatile type zero = 0; \
+        const type edges[] = {0, 1, 2, (type)((tmax) / 2), (tmax), (type)((tmax) - 1), (tmin), (type)((tmin) + 1), (type)((tmin) / 2), (type)-1}; \
+        for (size_t i = 0; i < KARRAY_SIZE(edges); ++i) \
+            for (size_t j = 0; j < KARRAY_SIZE(edges); ++j) \
+            { \
+                type ref; \
+                TEST_KARITH_SAT_REF(KADD, edges[i], edges[j], zero, tmin, tmax, ref); \
+                assert(KADD_SAT(edges[i], edges[j]) == ref); \
+                TEST_KARITH_SAT_REF(KSUB, edges[i], edges[j], zero, tmin, tmax, ref); \
+                assert(KSUB_SAT(edges[i], edges[j]) == ref); \
+                TEST_KARITH_SAT_REF(KMUL, edges[i], edges[j], zero, tmin, tmax, ref); \
+                assert(KMUL_SAT(edges[i], edges[j]) == ref); \
+            } \
+        \
+        for (int mode = 0; mode < 4; ++mode) \
+        { \
+            TEST_KARITH_GEN(type, a, TEST_KARITH_N, mode, tmin, tmax); \
+            TEST_KARITH_GEN(type, b, TEST_KARITH_N, 3 - mode, tmin, tmax); \
+            \
+            KADD_SAT_ARRAY(dst, a, b, TEST_KARITH_N); \
+            for (size_t i = 0; i < TEST_KARITH_N; ++i) \
+            { \
+                type ref; \
+                TEST_KARITH_SAT_REF(KADD, a[i], b[i], zero, tmin, tmax, ref); \
+                assert(dst[i] == ref); \
+            } \
+            KSUB_SAT_ARRAY(dst, a, b, TEST_KARITH_N); \
+            for (size_t i = 0; i < TEST_KARITH_N; ++i) \
+            { \
+                type ref; \
+                TEST_KARITH_SAT_REF(KSUB, a[i], b[i], zero, tmin, tmax, ref); \
+                assert(dst[i] == ref); \
+            } \
+            KMUL_SAT_ARRAY(dst, a, b, TEST_KARITH_N); \
+            for (size_t i = 0; i < TEST_KARITH_N; ++i) \
+            { \
+                type ref; \
+                TEST_KARITH_SAT_REF(KMUL, a[i], b[i], zero, tmin, tmax, ref); \
+                assert(dst[i] == ref); \
+            } \
+        } \
+    } while (0)
+
+static void test_karith_sat(void)
+{
+    assert(KADD_SAT(INT_MAX, 5) == INT_MAX);
+    assert(KADD_SAT(INT_MIN, -5) == INT_MIN);
+    assert(KSUB_SAT(2u, 5u) == 0);
+    assert(KSUB_SAT(INT_MIN, 1) == INT_MIN);
+    assert(KSUB_SAT(0, INT_MIN) == INT_MAX);
+    assert(KMUL_SAT(INT_MIN, 2) == INT_MIN);
+    assert(KMUL_SAT(INT_MIN, -1) == INT_MAX);
+    assert(KMUL_SAT(ULLONG_MAX, 2ull) == ULLONG_MAX);
+    assert(KMUL_SAT(LLONG_MIN, -1ll) == LLONG_MAX);
+    assert(KADD_SAT(3l, 4l) == 7l);
+
+    TEST_KARITH_SAT_TYPE(int, INT_MIN, INT_MAX);
+    TEST_KARITH_SAT_TYPE(unsigned int, 0u, UINT_MAX);
+    TEST_KARITH_SAT_TYPE(long, LONG_MIN, LONG_MAX);
+    TEST_KARITH_SAT_TYPE(unsigned long, 0ul, ULONG_MAX);
+    TEST_KARITH_SAT_TYPE(long long, LLONG_MIN, LLONG_MAX);
+    TEST_KARITH_SAT_TYPE(unsigned long long, 0ull, ULLONG_MAX);
+}
+
+void test_karith(void)
+{
+    test_karith_overflow_array();
+    test_karith_sat();
+}
@@ -0,0 +1,93 @@
+#include <kmacros/kmacros.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+void test_katomic(void);
+
+#define TEST_KATOMIC_THREADS    4
+#define TEST_KATOMIC_ITERS      20000
+
+static void test_katomic_ops(void)
+{
+    KATOMIC(uint32_t) x;
+    KATOMIC(void *) p;
+    int value;
+
+    KATOMIC_STORE(&x, 10, KATOMIC_RELAXED);
+    assert(KATOMIC_LOAD(&x, KATOMIC_ACQUIRE) == 10);
+
+    assert(KATOMIC_FETCH_ADD(&x, 5, KATOMIC_RELAXED) == 10);
+    assert(KATOMIC_FETCH_SUB(&x, 3, KATOMIC_RELAXED) == 15);
+    assert(KATOMIC_FETCH_OR(&x, 0xF0, KATOMIC_RELAXED) == 12);
+    assert(KATOMIC_FETCH_AND(&x, 0x3C, KATOMIC_RELAXED) == 0xFC);
+    assert(KATOMIC_FETCH_XOR(&x, 0xFF, KATOMIC_RELAXED) == 0x3C);
+    assert(KATOMIC_EXCHANGE(&x, 7, KATOMIC_ACQ_REL) == 0xC3);
+
+    /* failed CAS writes current value into expected */
+    uint32_t expected = 1;
+    assert(!KATOMIC_CAS(&x, &expected, 2, KATOMIC_SEQ_CST, KATOMIC_RELAXED) && expected == 7);
+    assert(KATOMIC_CAS(&x, &expected, 2, KATOMIC_SEQ_CST, KATOMIC_RELAXED) && KATOMIC_LOAD(&x, KATOMIC_RELAXED) == 2);
+
+    while (!KATOMIC_CAS_WEAK(&x, &expected, 3, KATOMIC_RELEASE, KATOMIC_RELAXED))
+        KCPU_RELAX();
+
+    assert(KATOMIC_LOAD(&x, KATOMIC_SEQ_CST) == 3);
+
+    KATOMIC_STORE(&p, &value, KATOMIC_RELEASE);
+    assert(KATOMIC_LOAD(&p, KATOMIC_ACQUIRE) == &value);
+
+    KATOMIC_THREAD_FENCE(KATOMIC_SEQ_CST);
+    KATOMIC_SIGNAL_FENCE(KATOMIC_SEQ_CST);
+}
+
+static KATOMIC(uint64_t) test_katomic_counter;
+static KATOMIC(uint64_t) test_katomic_cas_counter;
+
+static void *test_katomic_thread(void *arg)
+{
+    (void)arg;
+    for (size_t i = 0; i < TEST_KATOMIC_ITERS; ++i)
+    {
+        (void)KATOMIC_FETCH_ADD(&test_katomic_counter, 1, KATOMIC_RELAXED);
+
+        uint64_t old = KATOMIC_LOAD(&test_katomic_cas_counter, KATOMIC_RELAXED);
+        while (!KATOMIC_CAS_WEAK(&test_katomic_cas_counter, &old, old + 2, KATOMIC_RELAXED, KATOMIC_RELAXED))
+            KCPU_RELAX();
+    }
+
+    return NULL;
+}
+
+static void test_katomic_threads(void)
+{
+    pthread_t threads[TEST_KATOMIC_THREADS];
+    int ret;
+
+    for (size_t i = 0; i < TEST_KATOMIC_THREADS; ++i)
+    {
+        ret = pthread_create(&threads[i], NULL, test_katomic_thread, NULL);
+        assert(ret == 0);
+    }
+
+    for (size_t i = 0; i < TEST_KATOMIC_THREADS; ++i)
+    {
+        ret = pthread_join(threads[i], NULL);
+        assert(ret == 0);
+    }
+
+    /* no update is lost */
+    assert(KATOMIC_LOAD(&test_katomic_counter, KATOMIC_RELAXED) == TEST_KATOMIC_THREADS * TEST_KATOMIC_ITERS);
+    assert(KATOMIC_LOAD(&test_katomic_cas_counter, KATOMIC_RELAXED) == 2 * TEST_KATOMIC_THREADS * TEST_KATOMIC_ITERS);
+
+    (void)ret; /* only checked by assert */
+}
+
+void test_katomic(void)
+{
+    test_katomic_ops();
+    test_katomic_threads();
+}
@@ -0,0 +1,336 @@
+#include <kmacros/kmacros.h>
+
+#include <assert.h>
+#include <stdint.h>
+
+#include "test-rand.h"
+
+void test_kbits(void);
+
+static void test_kbits_popcount_buffer(void);
+static void test_kbits_bswap_array(void);
+static void test_kbits_endian_access(void);
+static void test_kbits_extract_deposit(void);
+static void test_kbits_reverse(void);
+static void test_kbits_reverse_array(void);
+
+static uint64_t test_kbits_seed = 0x2545F4914F6CDD1Dull;
+
+static uint64_t test_kbits_popcount_naive(const uint8_t *buf, size_t nbytes)
+{
+    uint64_t ones = 0;
+
+    for (size_t i = 0; i < nbytes; ++i)
+        for (unsigned int b = 0; b < 8; ++b)
+            ones += (buf[i] >> b) & 1u;
+
+    return ones;
+}
+
+static void test_kbits_popcount_buffer(void)
+{
+    /* Enough for several full blocks of every kernel (AVX2 block = 512 bytes) */
+    static uint8_t buf[4096 + 64];
+
+    /* All zeros and all ones */
+    for (size_t i = 0; i < sizeof(buf); ++i)
+        buf[i] = 0;
+
+    assert(KPOPCOUNT_BUFFER(buf, sizeof(buf)) == 0);
+    assert(KPOPCOUNT_BUFFER(buf, 0) == 0);
+
+    for (size_t i = 0; i < sizeof(buf); ++i)
+        buf[i] = 0xFF;
+
+    assert(KPOPCOUNT_BUFFER(buf, sizeof(buf)) == 8 * sizeof(buf));
+
+    for (size_t i = 0; i < sizeof(buf); ++i)
+        buf[i] = (uint8_t)test_rand_next(&test_kbits_seed);
+
+    /* Every length around kernel block boundaries, with unaligned start */
+    for (size_t offset = 0; offset < 9; ++offset)
+        for (size_t nbytes = 0; nbytes + offset <= sizeof(buf); nbytes += (nbytes < 1100 ? 1 : 37))
+            assert(KPOPCOUNT_BUFFER(&buf[offset], nbytes) == test_kbits_popcount_naive(&buf[offset], nbytes));
+}
+
+static void test_kbits_bswap_array(void)
+{
+    /* + 1 element to test unaligned buffers */
+    static uint32_t src32[301];
+    static uint32_t dst32[301];
+    static uint64_t src64[301];
+    static uint64_t dst64[301];
+
+    for (size_t i = 0; i < KARRAY_SIZE(src32); ++i)
+        src32[i] = (uint32_t)test_rand_next(&test_kbits_seed);
+
+    for (size_t i = 0; i < KARRAY_SIZE(src64); ++i)
+        src64[i] = test_rand_next(&test_kbits_seed);
+
+    /* All lengths around vector sizes, out of place and in place */
+    for (size_t n = 0; n < 300; n += (n < 40 ? 1 : 13))
+    {
+        KBSWAP32_ARRAY(dst32, src32, n);
+        for (size_t i = 0; i < n; ++i)
+            assert(dst32[i] == KBSWAP32(src32[i]));
+
+        KBSWAP32_ARRAY_INPLACE(dst32, n);
+        for (size_t i = 0; i < n; ++i)
+            assert(dst32[i] == src32[i]);
+
+        KBSWAP64_ARRAY(dst64, src64, n);
+        for (size_t i = 0; i < n; ++i)
+            assert(dst64[i] == KBSWAP64(src64[i]));
+
+        KBSWAP64_ARRAY_INPLACE(dst64, n);
+        for (size_t i = 0; i < n; ++i)
+            assert(dst64[i] == src64[i]);
+
+        /* Unaligned source and destination */
+        uint8_t *src_bytes = (uint8_t *)src64 + 1;
+        uint8_t *dst_bytes = (uint8_t *)dst64 + 3;
+
+        KBSWAP32_ARRAY(dst_bytes, src_bytes, n);
+        for (size_t i = 0; i < n; ++i)
+            assert(KLOAD_BE32(dst_bytes + i * 4) == KLOAD_LE32(src_bytes + i * 4));
+    }
+}
+
+static void test_kbits_endian_access(void)
+{
+    uint8_t buf[16 + 7];
+    const uint8_t bytes[8] = {0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF};
+
+    /* Every offset, so accessors have to work on unaligned pointers */
+    for (size_t offset = 0; offset < 8; ++offset)
+    {
+        uint8_t *ptr = &buf[offset];
+
+        for (size_t i = 0; i < sizeof(bytes); ++i)
+            ptr[i] = bytes[i];
+
+        assert(KLOAD_BE16(ptr) == 0x0123u);
+        assert(KLOAD_LE16(ptr) == 0x2301u);
+        assert(KLOAD_BE32(ptr) == 0x01234567u);
+        assert(KLOAD_LE32(ptr) == 0x67452301u);
+        assert(KLOAD_BE64(ptr) == 0x0123456789ABCDEFull);
+        assert(KLOAD_LE64(ptr) == 0xEFCDAB8967452301ull);
+
+        KSTORE_LE64(ptr, 0x0123456789ABCDEFull);
+        assert(KLOAD_BE64(ptr) == 0xEFCDAB8967452301ull);
+        assert(ptr[0] == 0xEF && ptr[7] == 0x01);
+
+        KSTORE_BE64(ptr, 0x0123456789ABCDEFull);
+        for (size_t i = 0; i < sizeof(bytes); ++i)
+            assert(ptr[i] == bytes[i]);
+
+        KSTORE_BE32(ptr, 0xDEADBEEFu);
+        assert(ptr[0] == 0xDE && ptr[3] == 0xEF && ptr[4] == 0x89);
+        assert(KLOAD_LE32(ptr) == 0xEFBEADDEu);
+
+        KSTORE_LE32(ptr, 0xDEADBEEFu);
+        assert(ptr[0] == 0xEF && ptr[3] == 0xDE);
+
+        KSTORE_BE16(ptr, 0xBEEF);
+        assert(ptr[0] == 0xBE && ptr[1] == 0xEF && ptr[2] == 0xAD);
+
+        KSTORE_LE16(ptr, 0xBEEF);
+        assert(ptr[0] == 0xEF && ptr[1] == 0xBE);
+    }
+}
+
+static uint64_t test_kbits_extract_naive(uint64_t n, uint64_t mask)
+{
+    uint64_t res = 0;
+    unsigned int k = 0;
+
+    for (unsigned int i = 0; i < 64; ++i)
+        if ((mask >> i) & 1)
+            res |= ((n >> i) & 1) << k++;
+
+    return res;
+}
+
+static uint64_t test_kbits_deposit_naive(uint64_t n, uint64_t mask)
+{
+    uint64_t res = 0;
+    unsigned int k = 0;
+
+    for (unsigned int i = 0; i < 64; ++i)
+        if ((mask >> i) & 1)
+            res |= ((n >> k++) & 1) << i;
+
+    return res;
+}
+
+static void test_kbits_extract_deposit(void)
+{
+    /* Contiguous field is the same as KMASK_GET */
+    const unsigned int a = 0xDEADBEEFu;
+    assert(KBIT_EXTRACT(a, KMASK(4, 11)) == KMASK_GET(a, 4, 11));
+    assert(KBIT_EXTRACT(a, 0u) == 0);
+    assert(KBIT_EXTRACT(a, ~0u) == a);
+    assert(KBIT_DEPOSIT(a, ~0u) == a);
+    assert(KBIT_DEPOSIT(0xBu, 0xF0u) == 0xB0u);
+    assert(KBIT_EXTRACT(0xB4u, 0x55u) == 0x6u);
+
+    /* Result has the same type as n */
+    KSTATIC_ASSERT(KTYPES_COMPATIBLE(__typeof__(KBIT_EXTRACT(1, 1)), int));
+    KSTATIC_ASSERT(KTYPES_COMPATIBLE(__typeof__(KBIT_DEPOSIT(1ul, 1ul)), unsigned long));
+
+    /* Morton code */
+    const uint64_t x = 0x3u;
+    const uint64_t y = 0x5u;
+    assert((KBIT_DEPOSIT(x, 0x5555555555555555ull) | KBIT_DEPOSIT(y, 0xAAAAAAAAAAAAAAAAull)) == 0x27u);
+
+    for (size_t i = 0; i < 10000; ++i)
+    {
+        const uint64_t n = test_rand_next(&test_kbits_seed);
+        uint64_t mask = test_rand_next(&test_kbits_seed);
+
+        /* Sparse and dense masks too */
+        if (i % 3 == 1)
+            mask &= test_rand_next(&test_kbits_seed);
+        else if (i % 3 == 2)
+            mask |= test_rand_next(&test_kbits_seed);
+
+        const unsigned long long ext64 = KBIT_EXTRACT((unsigned long long)n, (unsigned long long)mask);
+        const unsigned long long dep64 = KBIT_DEPOSIT((unsigned long long)n, (unsigned long long)mask);
+        assert(ext64 == test_kbits_extract_naive(n, mask));
+        assert(dep64 == test_kbits_deposit_naive(n, mask));
+        assert(KBIT_DEPOSIT(ext64, (unsigned long long)mask) == (n & mask));
+
+        const unsigned int ext32 = KBIT_EXTRACT((unsigned int)n, (unsigned int)mask);
+        const unsigned int dep32 = KBIT_DEPOSIT((unsigned int)n, (unsigned int)mask);
+        assert(ext32 == test_kbits_extract_naive((uint32_t)n, (uint32_t)mask));
+        assert(dep32 == test_kbits_deposit_naive((uint32_t)n, (uint32_t)mask));
+
+        const int ext_signed = KBIT_EXTRACT((int)n, (int)mask);
+        assert((unsigned int)ext_signed == ext32);
+    }
+}
+
+/* Bit by bit reference, reverse of width lowest bits */
+static uint64_t test_kbits_reverse_naive(uint64_t n, unsigned int width)
+{
+    uint64_t res = 0;
+
+    for (unsigned int i = 0; i < width; ++i)
+        res |= ((n >> i) & 1) << (width - 1 - i);
+
+    return res;
+}
+
+static unsigned int test_kbits_bit_length(uint64_t n)
+{
+    unsigned int len = 0;
+
+    while (n != 0)
+    {
+        ++len;
+        n >>= 1;
+    }
+
+    return len;
+}
+
+#define TEST_KBITS_REVERSE_TYPE(type, utype, val) \
+    do { \
+        const type v = (type)(val); \
+        const uint64_t u = (uint64_t)(utype)v; \
+        const unsigned int width = (unsigned int)(sizeof(type) * CHAR_BIT); \
+        const type r = (type)KBIT_REVERSE(v); \
+        const type rs = (type)KBIT_REVERSE_SIGNIFICANT(v); \
+        assert((uint64_t)(utype)r == test_kbits_reverse_naive(u, width)); \
+        assert((uint64_t)(utype)rs == test_kbits_reverse_naive(u, test_kbits_bit_length(u))); \
+    } while (0)
+
+static void test_kbits_reverse(void)
+{
+    assert(KBITREVERSE8(0x01) == 0x80);
+    assert(KBITREVERSE16(0x0001) == 0x8000);
+    assert(KBITREVERSE32(0x0000000Fu) == 0xF0000000u);
+    assert(KBITREVERSE64(0x1ull) == 0x8000000000000000ull);
+    assert(KBIT_REVERSE_SIGNIFICANT(0u) == 0u);
+    assert(KBIT_REVERSE_SIGNIFICANT(0xAu) == 0x5u);
+
+    for (size_t i = 0; i < 5000; ++i)
+    {
+        uint64_t val = test_rand_next(&test_kbits_seed);
+
+        /* short numbers matter for significant version */
+        if (i % 2)
+            val >>= test_rand_next(&test_kbits_seed) % 64;
+
+        assert(KBITREVERSE8((uint8_t)val) == test_kbits_reverse_naive((uint8_t)val, 8));
+        assert(KBITREVERSE16((uint16_t)val) == test_kbits_reverse_naive((uint16_t)val, 16));
+        assert(KBITREVERSE32((uint32_t)val) == test_kbits_reverse_naive((uint32_t)val, 32));
+        assert(KBITREVERSE64(val) == test_kbits_reverse_naive(val, 64));
+
+        TEST_KBITS_REVERSE_TYPE(char, unsigned char, val);
+        TEST_KBITS_REVERSE_TYPE(signed char, unsigned char, val);
+        TEST_KBITS_REVERSE_TYPE(unsigned char, unsigned char, val);
+        TEST_KBITS_REVERSE_TYPE(short, unsigned short, val);
+        TEST_KBITS_REVERSE_TYPE(unsigned short, unsigned short, val);
+        TEST_KBITS_REVERSE_TYPE(int, unsigned int, val);
+        TEST_KBITS_REVERSE_TYPE(unsigned int, unsigned int, val);
+        TEST_KBITS_REVERSE_TYPE(long, unsigned long, val);
+        TEST_KBITS_REVERSE_TYPE(unsigned long, unsigned long, val);
+        TEST_KBITS_REVERSE_TYPE(long long, unsigned long long, val);
+        TEST_KBITS_REVERSE_TYPE(unsigned long long, unsigned long long, val);
+    }
+}
+
+static void test_kbits_reverse_array(void)
+{
+    int small[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    const int small_expected[8] = {0, 4, 2, 6, 1, 5, 3, 7};
+
+    KBIT_REVERSE_ARRAY(small, 8);
+    for (size_t i = 0; i < 8; ++i)
+        assert(small[i] == small_expected[i]);
+
+    /* Permutation is an involution: twice gives input back */
+    static uint64_t t64[1 << 12];
+    static struct { double re; double im; } tc[1 << 10];
+
+    for (size_t n = 1; n <= KARRAY_SIZE(t64); n <<= 1)
+    {
+        const unsigned int log = test_kbits_bit_length(n) - 1;
+
+        for (size_t i = 0; i < n; ++i)
+            t64[i] = i;
+
+        KBIT_REVERSE_ARRAY(t64, n);
+        for (size_t i = 0; i < n; ++i)
+            assert(t64[i] == test_kbits_reverse_naive(i, log));
+
+        KBIT_REVERSE_ARRAY(t64, n);
+        for (size_t i = 0; i < n; ++i)
+            assert(t64[i] == i);
+    }
+
+    for (size_t i = 0; i < KARRAY_SIZE(tc); ++i)
+    {
+        tc[i].re = (double)i;
+        tc[i].im = -(double)i;
+    }
+
+    KBIT_REVERSE_ARRAY(tc, KARRAY_SIZE(tc));
+    for (size_t i = 0; i < KARRAY_SIZE(tc); ++i)
+    {
+        const uint64_t j = test_kbits_reverse_naive(i, 10);
+        const double expected = (double)j;
+        assert(tc[i].re == expected && tc[i].im == -expected);
+    }
+}
+
+void test_kbits(void)
+{
+    test_kbits_popcount_buffer();
+    test_kbits_bswap_array();
+    test_kbits_endian_access();
+    test_kbits_extract_deposit();
+    test_kbits_reverse();
+    test_kbits_reverse_array();
+}
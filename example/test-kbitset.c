@@ -0,0 +1,267 @@
+#include <kmacros/kbitset.h>
+
+#include <assert.h>
+
+#include "test-rand.h"
+
+void test_kbitset(void);
+
+/* Reference model is a simple bool array */
+#define TEST_KBITSET_MAX_BITS 1000
+
+static void test_kbitset_compare(const kbitset_t *bs, const bool *model);
+static void test_kbitset_single(size_t nbits);
+static void test_kbitset_range(size_t nbits);
+static void test_kbitset_bulk(size_t nbits);
+static void test_kbitset_find(size_t nbits);
+
+static uint64_t test_kbitset_seed = 0x9E3779B97F4A7C15ull;
+
+static size_t test_kbitset_rand(size_t mod)
+{
+    return (size_t)(test_rand_next(&test_kbitset_seed) % mod);
+}
+
+static void test_kbitset_compare(const kbitset_t *bs, const bool *model)
+{
+    size_t ones = 0;
+
+    for (size_t i = 0; i < bs->nbits; ++i)
+    {
+        assert(kbitset_test(bs, i) == model[i]);
+        ones += model[i];
+    }
+
+    assert(kbitset_popcount(bs) == ones);
+
+    /* iterator has to visit exactly set bits in increasing order */
+    size_t visited = 0;
+    size_t prev = 0;
+    size_t bit;
+    KBITSET_FOR_EACH_SET(bs, bit)
+    {
+        assert(bit < bs->nbits);
+        assert(model[bit]);
+        assert(visited == 0 || bit > prev);
+        prev = bit;
+        ++visited;
+    }
+
+    assert(visited == ones);
+}
+
+static void test_kbitset_single(size_t nbits)
+{
+    bool model[TEST_KBITSET_MAX_BITS] = {0};
+    kbitset_t *bs = kbitset_create(nbits);
+    assert(bs != NULL);
+
+    test_kbitset_compare(bs, model);
+
+    for (size_t i = 0; i < nbits * 2; ++i)
+    {
+        const size_t bit = test_kbitset_rand(nbits);
+
+        switch (test_kbitset_rand(3))
+        {
+            case 0: kbitset_set(bs, bit); model[bit] = true; break;
+            case 1: kbitset_clear(bs, bit); model[bit] = false; break;
+            default: kbitset_toggle(bs, bit); model[bit] = !model[bit]; break;
+        }
+    }
+
+    test_kbitset_compare(bs, model);
+
+    kbitset_set_all(bs);
+    for (size_t i = 0; i < nbits; ++i)
+        model[i] = true;
+
+    test_kbitset_compare(bs, model);
+
+    kbitset_clear_all(bs);
+    for (size_t i = 0; i < nbits; ++i)
+        model[i] = false;
+
+    test_kbitset_compare(bs, model);
+
+    kbitset_destroy(bs);
+}
+
+static void test_kbitset_range(size_t nbits)
+{
+    bool model[TEST_KBITSET_MAX_BITS] = {0};
+    kbitset_t *bs = kbitset_create(nbits);
+    assert(bs != NULL);
+
+    for (size_t i = 0; i < 100; ++i)
+    {
+        size_t s = test_kbitset_rand(nbits);
+        size_t e = test_kbitset_rand(nbits);
+        if (s > e)
+            KSWAP(s, e);
+
+        bool all = true;
+        bool any = false;
+        for (size_t k = s; k <= e; ++k)
+        {
+            all = all && model[k];
+            any = any || model[k];
+        }
+
+        assert(kbitset_test_range_all(bs, s, e) == all);
+        assert(kbitset_test_range_any(bs, s, e) == any);
+
+        const bool value = test_kbitset_rand(2) == 0;
+        if (value)
+            kbitset_set_range(bs, s, e);
+        else
+            kbitset_clear_range(bs, s, e);
+
+        for (size_t k = s; k <= e; ++k)
+            model[k] = value;
+
+        assert(kbitset_test_range_all(bs, s, e) == value);
+        assert(kbitset_test_range_any(bs, s, e) == value);
+
+        test_kbitset_compare(bs, model);
+    }
+
+    kbitset_destroy(bs);
+}
+
+static void test_kbitset_bulk(size_t nbits)
+{
+    bool model_a[TEST_KBITSET_MAX_BITS] = {0};
+    bool model_b[TEST_KBITSET_MAX_BITS] = {0};
+    kbitset_t *a = kbitset_create(nbits);
+    kbitset_t *b = kbitset_create(nbits);
+    kbitset_t *other = kbitset_create(nbits + 1);
+    assert(a != NULL && b != NULL && other != NULL);
+
+    for (int op = 0; op < 4; ++op)
+    {
+        for (size_t i = 0; i < nbits; ++i)
+        {
+            model_a[i] = test_kbitset_rand(2) == 0;
+            model_b[i] = test_kbitset_rand(2) == 0;
+
+            if (model_a[i])
+                kbitset_set(a, i);
+            else
+                kbitset_clear(a, i);
+
+            if (model_b[i])
+                kbitset_set(b, i);
+            else
+                kbitset_clear(b, i);
+        }
+
+        switch (op)
+        {
+            case 0: assert(kbitset_and(a, b)); break;
+            case 1: assert(kbitset_or(a, b)); break;
+            case 2: assert(kbitset_xor(a, b)); break;
+            default: assert(kbitset_andnot(a, b)); break;
+        }
+
+        for (size_t i = 0; i < nbits; ++i)
+            switch (op)
+            {
+                case 0: model_a[i] = model_a[i] && model_b[i]; break;
+                case 1: model_a[i] = model_a[i] || model_b[i]; break;
+                case 2: model_a[i] = model_a[i] != model_b[i]; break;
+                default: model_a[i] = model_a[i] && !model_b[i]; break;
+            }
+
+        test_kbitset_compare(a, model_a);
+        test_kbitset_compare(b, model_b);
+    }
+
+    /* Different sizes are rejected */
+    assert(kbitset_or(a, other) == false);
+    test_kbitset_compare(a, model_a);
+
+    /* dst == src: and / or keep the set, xor / andnot clear it */
+    assert(kbitset_and(a, a) && kbitset_or(a, a));
+    test_kbitset_compare(a, model_a);
+    assert(kbitset_xor(a, a));
+    assert(kbitset_popcount(a) == 0);
+    assert(kbitset_or(a, b) && kbitset_andnot(b, b));
+    test_kbitset_compare(a, model_b);
+    assert(kbitset_popcount(b) == 0);
+
+    kbitset_destroy(other);
+    kbitset_destroy(b);
+    kbitset_destroy(a);
+}
+
+static void test_kbitset_find(size_t nbits)
+{
+    bool model[TEST_KBITSET_MAX_BITS] = {0};
+    kbitset_t *bs = kbitset_create(nbits);
+    assert(bs != NULL);
+
+    /* Sparse and dense sets */
+    for (size_t density = 1; density <= 4; density *= 2)
+    {
+        for (size_t i = 0; i < nbits; ++i)
+        {
+            model[i] = test_kbitset_rand(8) < density;
+            if (density == 4)
+                model[i] = !model[i];
+
+            if (model[i])
+                kbitset_set(bs, i);
+            else
+                kbitset_clear(bs, i);
+        }
+
+        for (size_t from = 0; from <= nbits; ++from)
+        {
+            size_t next_set = from;
+            while (next_set < nbits && !model[next_set])
+                ++next_set;
+
+            size_t next_clear = from;
+            while (next_clear < nbits && model[next_clear])
+                ++next_clear;
+
+            assert(kbitset_find_next_set(bs, from) == next_set);
+            assert(kbitset_find_next_clear(bs, from) == next_clear);
+        }
+    }
+
+    kbitset_set_all(bs);
+    assert(kbitset_find_next_clear(bs, 0) == nbits);
+
+    kbitset_clear_all(bs);
+    assert(kbitset_find_next_set(bs, 0) == nbits);
+
+    kbitset_destroy(bs);
+}
+
+void test_kbitset(void)
+{
+    const size_t sizes[] = {1, 7, 63, 64, 65, 127, 128, 129, 500, TEST_KBITSET_MAX_BITS};
+
+    for (size_t i = 0; i < KARRAY_SIZE(sizes); ++i)
+    {
+        test_kbitset_single(sizes[i]);
+        test_kbitset_range(sizes[i]);
+        test_kbitset_bulk(sizes[i]);
+        test_kbitset_find(sizes[i]);
+    }
+
+    /* Empty bitset is valid, but there is nothing to iterate */
+    kbitset_t *bs = kbitset_create(0);
+    assert(bs != NULL);
+    assert(kbitset_popcount(bs) == 0);
+    assert(kbitset_find_next_set(bs, 0) == 0);
+    assert(kbitset_find_next_clear(bs, 0) == 0);
+
+    size_t bit;
+    KBITSET_FOR_EACH_SET(bs, bit)
+        assert(0);
+
+    kbitset_destroy(bs);
+}
@@ -0,0 +1,131 @@
+#include <kmacros/kbuddy.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "test-rand.h"
+
+void test_kbuddy(void);
+
+#define TEST_KBUDDY_OBJECTS 512
+
+static uint64_t test_kbuddy_seed = 0x853C49E6748FEA9Bull;
+
+static void test_kbuddy_order(void)
+{
+    assert(kbuddy_order(0) == 0 && kbuddy_order(1) == 0 && kbuddy_order(KBUDDY_PAGE_SIZE) == 0);
+    assert(kbuddy_order(KBUDDY_PAGE_SIZE + 1) == 1 && kbuddy_order(3 * KBUDDY_PAGE_SIZE) == 2);
+    assert(kbuddy_order(KBUDDY_BLOCK_SIZE_MAX) == KBUDDY_MAX_ORDER && kbuddy_order(KBUDDY_BLOCK_SIZE_MAX + 1) > KBUDDY_MAX_ORDER);
+}
+
+static void test_kbuddy_split_merge(void)
+{
+    kbuddy_t buddy;
+    kbuddy_init(&buddy);
+    assert(kbuddy_add_arena(&buddy, KBUDDY_BLOCK_SIZE_MAX, 0) == 0);
+
+    const char *base = buddy.arenas[0].base;
+
+    /* first page splits the whole arena, second page is its buddy */
+    char *a = kbuddy_alloc(&buddy, KBUDDY_PAGE_SIZE);
+    char *b = kbuddy_alloc(&buddy, KBUDDY_PAGE_SIZE);
+    char *c = kbuddy_alloc(&buddy, 2 * KBUDDY_PAGE_SIZE);
+    assert(a == base && b == base + KBUDDY_PAGE_SIZE && c == base + 2 * KBUDDY_PAGE_SIZE);
+    assert(kbuddy_free_size(&buddy) == KBUDDY_BLOCK_SIZE_MAX - 4 * KBUDDY_PAGE_SIZE);
+
+    /* arena is full when the biggest block is requested */
+    assert(kbuddy_alloc(&buddy, KBUDDY_BLOCK_SIZE_MAX) == NULL);
+
+    kbuddy_free(&buddy, a);
+    kbuddy_free(&buddy, c);
+    assert(kbuddy_alloc(&buddy, KBUDDY_BLOCK_SIZE_MAX) == NULL);
+
+    /* last free merges everything back into one block */
+    kbuddy_free(&buddy, b);
+    assert(kbuddy_free_size(&buddy) == KBUDDY_BLOCK_SIZE_MAX);
+
+    char *all = kbuddy_alloc(&buddy, KBUDDY_BLOCK_SIZE_MAX);
+    assert(all == base);
+    all[0] = 1;
+    all[KBUDDY_BLOCK_SIZE_MAX - 1] = 1;
+    kbuddy_free(&buddy, all);
+
+    kbuddy_destroy(&buddy);
+}
+
+static void test_kbuddy_random(void)
+{
+    static char *objs[TEST_KBUDDY_OBJECTS];
+    static unsigned int orders[TEST_KBUDDY_OBJECTS];
+    kbuddy_t buddy;
+
+    kbuddy_init(&buddy);
+    assert(kbuddy_add_arena(&buddy, KBUDDY_BLOCK_SIZE_MAX, KBUDDY_ARENA_THP) == 0);
+
+    /* size which cannot be rounded does not take arena slot */
+    assert(kbuddy_add_arena(&buddy, SIZE_MAX, KBUDDY_ARENA_THP) == -1);
+    assert(kbuddy_add_arena(&buddy, SIZE_MAX - KBUDDY_BLOCK_SIZE_MAX, 0) == -1);
+    assert(buddy.narenas == 1);
+
+    assert(kbuddy_add_arena(&buddy, 1, 0) == 0);
+    assert(buddy.arenas[1].size == KBUDDY_BLOCK_SIZE_MAX);
+    assert((uintptr_t)buddy.arenas[0].base % KBUDDY_THP_SIZE == 0);
+
+    const size_t total = 2 * KBUDDY_BLOCK_SIZE_MAX;
+
+    for (size_t step = 0; step < 20000; ++step)
+    {
+        const size_t i = (size_t)(test_rand_next(&test_kbuddy_seed) % TEST_KBUDDY_OBJECTS);
+
+        if (objs[i] != NULL)
+        {
+            /* first and last byte of block keep owner, so overlapping blocks are detected */
+            assert(objs[i][0] == (char)i && objs[i][KBUDDY_BLOCK_SIZE(orders[i]) - 1] == (char)i);
+            kbuddy_free(&buddy, objs[i]);
+            objs[i] = NULL;
+            continue;
+        }
+
+        orders[i] = (unsigned int)(test_rand_next(&test_kbuddy_seed) % 8);
+        const size_t size = KBUDDY_BLOCK_SIZE(orders[i]) - (size_t)(test_rand_next(&test_kbuddy_seed) % KBUDDY_PAGE_SIZE);
+        assert(kbuddy_order(size) == orders[i]);
+
+        objs[i] = kbuddy_alloc(&buddy, size);
+        if (objs[i] == NULL)
+            continue;
+
+        /* block is aligned to its size inside arena */
+        const kbuddy_arena_t *arena = &buddy.arenas[objs[i] >= buddy.arenas[1].base && objs[i] < buddy.arenas[1].base + buddy.arenas[1].size];
+        assert((size_t)(objs[i] - arena->base) % KBUDDY_BLOCK_SIZE(orders[i]) == 0);
+        assert(objs[i] >= arena->base && objs[i] + KBUDDY_BLOCK_SIZE(orders[i]) <= arena->base + arena->size);
+
+        objs[i][0] = (char)i;
+        objs[i][KBUDDY_BLOCK_SIZE(orders[i]) - 1] = (char)i;
+    }
+
+    size_t used = 0;
+    for (size_t i = 0; i < TEST_KBUDDY_OBJECTS; ++i)
+        if (objs[i] != NULL)
+            used += KBUDDY_BLOCK_SIZE(orders[i]);
+
+    assert(kbuddy_free_size(&buddy) == total - used);
+
+    for (size_t i = 0; i < TEST_KBUDDY_OBJECTS; ++i)
+        kbuddy_free(&buddy, objs[i]);
+
+    /* both arenas are merged back into the biggest blocks */
+    assert(kbuddy_free_size(&buddy) == total);
+    assert(kbuddy_alloc(&buddy, KBUDDY_BLOCK_SIZE_MAX) == buddy.arenas[0].base);
+    assert(kbuddy_alloc(&buddy, KBUDDY_BLOCK_SIZE_MAX) == buddy.arenas[1].base);
+    assert(kbuddy_alloc(&buddy, KBUDDY_PAGE_SIZE) == NULL);
+
+    kbuddy_destroy(&buddy);
+}
+
+void test_kbuddy(void)
+{
+    test_kbuddy_order();
+    test_kbuddy_split_merge();
+    test_kbuddy_random();
+}
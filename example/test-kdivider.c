@@ -0,0 +1,108 @@
+#include <kmacros/kdivider.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "test-rand.h"
+
+void test_kdivider(void);
+
+#define TEST_KDIVIDER_N 256
+
+static uint64_t test_kdivider_seed = 0x853C49E6748FEA9Bull;
+
+/* Edge values first, then random values with random number of bits */
+static uint64_t test_kdivider_value(size_t i)
+{
+    const uint64_t edges[] = {0, 1, 2, 3, 5, 7, 10, 641, UINT32_MAX / 2, (uint64_t)UINT32_MAX / 2 + 1, UINT32_MAX - 1, UINT32_MAX,
+                              (uint64_t)UINT32_MAX + 1, UINT64_MAX / 2, UINT64_MAX / 2 + 1, UINT64_MAX - 1, UINT64_MAX};
+
+    if (i < sizeof(edges) / sizeof(edges[0]))
+        return edges[i];
+
+    const uint64_t r = test_rand_next(&test_kdivider_seed);
+    return r >> (test_rand_next(&test_kdivider_seed) % 64);
+}
+
+static void test_kdivider_unsigned(void)
+{
+    static uint32_t src32[TEST_KDIVIDER_N];
+    static uint32_t dst32[TEST_KDIVIDER_N];
+    static uint64_t src64[TEST_KDIVIDER_N];
+    static uint64_t dst64[TEST_KDIVIDER_N];
+
+    for (size_t i = 0; i < 300; ++i)
+    {
+        const uint64_t v = test_kdivider_value(i);
+        const uint64_t d64 = v != 0 ? v : 1;
+        const uint32_t d32 = (uint32_t)d64 != 0 ? (uint32_t)d64 : 1;
+        const kdivider_u32_t div32 = kdivider_u32_create(d32);
+        const kdivider_u64_t div64 = kdivider_u64_create(d64);
+
+        for (size_t j = 0; j < TEST_KDIVIDER_N; ++j)
+        {
+            src64[j] = test_kdivider_value(j);
+            src32[j] = (uint32_t)src64[j];
+
+            assert(KDIV_U32(src32[j], &div32) == src32[j] / d32);
+            assert(KMOD_U32(src32[j], &div32) == src32[j] % d32);
+            assert(KDIV_U64(src64[j], &div64) == src64[j] / d64);
+            assert(KMOD_U64(src64[j], &div64) == src64[j] % d64);
+        }
+
+        KDIV_U32_ARRAY(dst32, src32, TEST_KDIVIDER_N, &div32);
+        KDIV_U64_ARRAY(dst64, src64, TEST_KDIVIDER_N, &div64);
+        for (size_t j = 0; j < TEST_KDIVIDER_N; ++j)
+            assert(dst32[j] == src32[j] / d32 && dst64[j] == src64[j] / d64);
+
+        KMOD_U32_ARRAY(dst32, src32, TEST_KDIVIDER_N, &div32);
+        KMOD_U64_ARRAY(dst64, src64, TEST_KDIVIDER_N, &div64);
+        for (size_t j = 0; j < TEST_KDIVIDER_N; ++j)
+            assert(dst32[j] == src32[j] % d32 && dst64[j] == src64[j] % d64);
+    }
+}
+
+static void test_kdivider_signed(void)
+{
+    for (size_t i = 0; i < 600; ++i)
+    {
+        const uint64_t v = test_kdivider_value(i / 2);
+        /* every value is used with both signs */
+        const int64_t d64 = (int64_t)((i & 1) ? 0 - v : v) != 0 ? (int64_t)((i & 1) ? 0 - v : v) : 1;
+        const int32_t d32 = (int32_t)(uint32_t)d64 != 0 ? (int32_t)(uint32_t)d64 : -1;
+        const kdivider_s32_t div32 = kdivider_s32_create(d32);
+        const kdivider_s64_t div64 = kdivider_s64_create(d64);
+
+        for (size_t j = 0; j < 2 * TEST_KDIVIDER_N; ++j)
+        {
+            const uint64_t u = test_kdivider_value(j / 2);
+            const int64_t n64 = (int64_t)((j & 1) ? 0 - u : u);
+            const int32_t n32 = (int32_t)(uint32_t)n64;
+
+            if (!(n32 == INT32_MIN && d32 == -1))
+            {
+                assert(KDIV_S32(n32, &div32) == n32 / d32);
+                assert(KMOD_S32(n32, &div32) == n32 % d32);
+            }
+
+            if (!(n64 == INT64_MIN && d64 == -1))
+            {
+                assert(KDIV_S64(n64, &div64) == n64 / d64);
+                assert(KMOD_S64(n64, &div64) == n64 % d64);
+            }
+        }
+    }
+
+    const kdivider_s32_t min32 = kdivider_s32_create(INT32_MIN);
+    assert(KDIV_S32(INT32_MIN, &min32) == 1 && KDIV_S32(INT32_MAX, &min32) == 0 && KDIV_S32(-5, &min32) == 0);
+
+    const kdivider_s64_t min64 = kdivider_s64_create(INT64_MIN);
+    assert(KDIV_S64(INT64_MIN, &min64) == 1 && KDIV_S64(INT64_MAX, &min64) == 0 && KMOD_S64(-5, &min64) == -5);
+}
+
+void test_kdivider(void)
+{
+    test_kdivider_unsigned();
+    test_kdivider_signed();
+}
@@ -0,0 +1,139 @@
+#include <kmacros/kfutex.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <sched.h>
+
+void test_kfutex(void);
+
+#define TEST_KFUTEX_THREADS     4
+#define TEST_KFUTEX_ITERS       20000
+
+static kfutex_mutex_t test_kfutex_mutex = KFUTEX_MUTEX_INIT;
+static uint64_t test_kfutex_counter;
+
+static kfutex_event_t test_kfutex_event = KFUTEX_EVENT_INIT;
+static kfutex_latch_t test_kfutex_started = KFUTEX_LATCH_INIT(TEST_KFUTEX_THREADS);
+static kfutex_latch_t test_kfutex_done = KFUTEX_LATCH_INIT(TEST_KFUTEX_THREADS);
+static KATOMIC(uint32_t) test_kfutex_woken;
+
+static void test_kfutex_single(void)
+{
+    kfutex_mutex_t mutex;
+    kfutex_event_t event;
+    kfutex_latch_t latch;
+
+    assert(sizeof(mutex) == sizeof(uint32_t) && sizeof(event) == sizeof(uint32_t));
+
+    kfutex_mutex_init(&mutex);
+    assert(kfutex_mutex_trylock(&mutex) && !kfutex_mutex_trylock(&mutex));
+    kfutex_mutex_unlock(&mutex);
+    kfutex_mutex_lock(&mutex);
+    assert(mutex.state == 1 && !kfutex_mutex_trylock(&mutex));
+    kfutex_mutex_unlock(&mutex);
+    assert(mutex.state == 0);
+
+    /* set event does not sleep */
+    kfutex_event_init(&event);
+    assert(!kfutex_event_is_set(&event));
+    kfutex_event_set(&event);
+    assert(kfutex_event_is_set(&event));
+    kfutex_event_wait(&event);
+    kfutex_event_wait(&event);
+    kfutex_event_reset(&event);
+    assert(!kfutex_event_is_set(&event));
+
+    kfutex_latch_init(&latch, 3);
+    assert(!kfutex_latch_try_wait(&latch));
+    kfutex_latch_count_down(&latch, 2);
+    assert(!kfutex_latch_try_wait(&latch));
+    kfutex_latch_count_down(&latch, 1);
+    assert(kfutex_latch_try_wait(&latch));
+    kfutex_latch_wait(&latch);
+
+    kfutex_latch_init(&latch, 0);
+    kfutex_latch_wait(&latch);
+}
+
+static void *test_kfutex_counter_thread(void *arg)
+{
+    (void)arg;
+    for (size_t i = 0; i < TEST_KFUTEX_ITERS; ++i)
+    {
+        kfutex_mutex_lock(&test_kfutex_mutex);
+        ++test_kfutex_counter;
+
+        /* give CPU away inside critical section, so others have to sleep in kernel */
+        if ((i & 255) == 0)
+            (void)sched_yield();
+
+        kfutex_mutex_unlock(&test_kfutex_mutex);
+    }
+
+    return NULL;
+}
+
+static void *test_kfutex_waiter_thread(void *arg)
+{
+    (void)arg;
+    kfutex_latch_count_down(&test_kfutex_started, 1);
+
+    kfutex_event_wait(&test_kfutex_event);
+    (void)KATOMIC_FETCH_ADD(&test_kfutex_woken, 1, KATOMIC_RELAXED);
+
+    kfutex_latch_count_down(&test_kfutex_done, 1);
+
+    return NULL;
+}
+
+static void test_kfutex_threads(void)
+{
+    pthread_t threads[TEST_KFUTEX_THREADS];
+    int ret;
+
+    for (size_t i = 0; i < TEST_KFUTEX_THREADS; ++i)
+    {
+        ret = pthread_create(&threads[i], NULL, test_kfutex_counter_thread, NULL);
+        assert(ret == 0);
+    }
+
+    for (size_t i = 0; i < TEST_KFUTEX_THREADS; ++i)
+    {
+        ret = pthread_join(threads[i], NULL);
+        assert(ret == 0);
+    }
+
+    assert(test_kfutex_counter == TEST_KFUTEX_THREADS * TEST_KFUTEX_ITERS);
+    assert(test_kfutex_mutex.state == 0);
+
+    for (size_t i = 0; i < TEST_KFUTEX_THREADS; ++i)
+    {
+        ret = pthread_create(&threads[i], NULL, test_kfutex_waiter_thread, NULL);
+        assert(ret == 0);
+    }
+
+    /* all waiters are running, but nobody passes event before set */
+    kfutex_latch_wait(&test_kfutex_started);
+    (void)sched_yield();
+    assert(KATOMIC_LOAD(&test_kfutex_woken, KATOMIC_RELAXED) == 0);
+
+    kfutex_event_set(&test_kfutex_event);
+    kfutex_latch_wait(&test_kfutex_done);
+    assert(KATOMIC_LOAD(&test_kfutex_woken, KATOMIC_RELAXED) == TEST_KFUTEX_THREADS);
+
+    for (size_t i = 0; i < TEST_KFUTEX_THREADS; ++i)
+    {
+        ret = pthread_join(threads[i], NULL);
+        assert(ret == 0);
+    }
+
+    (void)ret; /* only checked by assert */
+}
+
+void test_kfutex(void)
+{
+    test_kfutex_single();
+    test_kfutex_threads();
+}
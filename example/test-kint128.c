@@ -0,0 +1,128 @@
+/* Native path is only a wrapper for operators, so limbs are tested against unsigned __int128 */
+#define KINT128_PORTABLE
+#include <kmacros/kint128.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "test-rand.h"
+
+void test_kint128(void);
+
+static uint64_t test_kint128_seed = 0x2545F4914F6CDD1Dull;
+
+static uint64_t test_kint128_edge(size_t i)
+{
+    const uint64_t edges[] = {0, 1, 2, UINT32_MAX, (uint64_t)UINT32_MAX + 1, UINT64_MAX, UINT64_MAX - 1, UINT64_MAX / 2, UINT64_C(1) << 63};
+
+    return i < sizeof(edges) / sizeof(edges[0]) ? edges[i] : test_rand_next(&test_kint128_seed);
+}
+
+static void test_kint128_fixed(void)
+{
+    const kuint128_t max = kuint128_make(UINT64_MAX, UINT64_MAX);
+    const kuint128_t one = kuint128_from64(1);
+    bool carry;
+
+    assert(kuint128_eq(kuint128_add(max, one), kuint128_from64(0)));
+    assert(kuint128_eq(kuint128_sub(kuint128_from64(0), one), max));
+    assert(kuint128_eq(kuint128_add(kuint128_from64(UINT64_MAX), one), kuint128_make(1, 0)));
+
+    assert(kuint128_eq(kuint128_add_carry(max, kuint128_from64(0), true, &carry), kuint128_from64(0)) && carry);
+    assert(kuint128_eq(kuint128_add_carry(max, max, true, &carry), max) && carry);
+    assert(kuint128_eq(kuint128_add_carry(one, one, false, &carry), kuint128_from64(2)) && !carry);
+    assert(kuint128_eq(kuint128_sub_borrow(kuint128_from64(0), kuint128_from64(0), true, &carry), max) && carry);
+    assert(kuint128_eq(kuint128_sub_borrow(one, one, false, &carry), kuint128_from64(0)) && !carry);
+
+    assert(kuint128_eq(kuint128_mul64(UINT64_MAX, UINT64_MAX), kuint128_make(UINT64_MAX - 1, 1)));
+    assert(kuint128_mulhi64(UINT64_C(1) << 63, 4) == 2);
+    assert(kuint128_eq(kuint128_mulhi(max, max), kuint128_sub(max, one)));
+
+    uint64_t rem;
+    assert(kuint128_divrem64(kuint128_make(6, 7), 10, &rem) == 0x999999999999999Aull && rem == 3);
+    assert(kuint128_divrem64(kuint128_make(UINT64_MAX - 1, UINT64_MAX), UINT64_MAX, &rem) == UINT64_MAX && rem == UINT64_MAX - 1);
+
+    assert(kuint128_clz(one) == 127 && kuint128_ctz(one) == 0);
+    assert(kuint128_clz(max) == 0 && kuint128_ctz(kuint128_make(1, 0)) == 64);
+    assert(kuint128_eq(kuint128_shl(one, 127), kuint128_make(UINT64_C(1) << 63, 0)));
+    assert(kuint128_eq(kuint128_shr(max, 127), one));
+
+    assert(kuint128_cmp(one, max) == -1 && kuint128_cmp(max, one) == 1 && kuint128_cmp(max, max) == 0);
+    assert(kuint128_lt(kuint128_make(0, UINT64_MAX), kuint128_make(1, 0)));
+}
+
+static void test_kint128_random(void)
+{
+#ifdef KCOMPILER_HAS_INT128
+    __extension__ typedef unsigned __int128 ref_t;
+
+    for (size_t i = 0; i < 2000; ++i)
+    {
+        const uint64_t a_hi = test_kint128_edge(i % 16);
+        const uint64_t a_lo = test_kint128_edge(i / 16 % 16);
+        const uint64_t b_hi = test_kint128_edge((i + 5) % 16);
+        const uint64_t b_lo = test_kint128_edge(i / 7 % 16);
+
+        const kuint128_t a = kuint128_make(a_hi, a_lo);
+        const kuint128_t b = kuint128_make(b_hi, b_lo);
+        const ref_t ra = ((ref_t)a_hi << 64) | a_lo;
+        const ref_t rb = ((ref_t)b_hi << 64) | b_lo;
+
+#define TEST_KINT128_EQ(k, r) assert(kuint128_lo(k) == (uint64_t)(r) && kuint128_hi(k) == (uint64_t)((r) >> 64))
+
+        TEST_KINT128_EQ(kuint128_add(a, b), ra + rb);
+        TEST_KINT128_EQ(kuint128_sub(a, b), ra - rb);
+        TEST_KINT128_EQ(kuint128_mul(a, b), ra * rb);
+        TEST_KINT128_EQ(kuint128_mul64(a_lo, b_lo), (ref_t)a_lo * b_lo);
+        assert(kuint128_mulhi64(a_hi, b_lo) == (uint64_t)(((ref_t)a_hi * b_lo) >> 64));
+
+        /* high part of 256-bit product from 4 partial products of reference */
+        const ref_t ll = (ref_t)a_lo * b_lo;
+        const ref_t lh = (ref_t)a_lo * b_hi;
+        const ref_t hl = (ref_t)a_hi * b_lo;
+        const ref_t hh = (ref_t)a_hi * b_hi;
+        const ref_t mid = (ll >> 64) + (uint64_t)lh + (uint64_t)hl;
+        TEST_KINT128_EQ(kuint128_mulhi(a, b), hh + (lh >> 64) + (hl >> 64) + (mid >> 64));
+
+        bool carry;
+        TEST_KINT128_EQ(kuint128_add_carry(a, b, i & 1, &carry), ra + rb + (i & 1));
+        assert(carry == (ra + rb < ra || ra + rb + (i & 1) < ra + rb));
+        TEST_KINT128_EQ(kuint128_sub_borrow(a, b, i & 1, &carry), ra - rb - (i & 1));
+        assert(carry == (ra < rb || ra - rb < (ref_t)(i & 1)));
+
+        const unsigned int shift = (unsigned int)(test_rand_next(&test_kint128_seed) % 128);
+        TEST_KINT128_EQ(kuint128_shl(a, shift), ra << shift);
+        TEST_KINT128_EQ(kuint128_shr(a, shift), ra >> shift);
+
+        if (ra != 0)
+        {
+            const int clz = kuint128_clz(a);
+            const int ctz = kuint128_ctz(a);
+            assert(clz >= 0 && clz < 128 && (ra >> (127 - clz)) == 1);
+            assert(ctz >= 0 && ctz < 128 && ((ra >> ctz) & 1) == 1 && (ra & (((ref_t)1 << ctz) - 1)) == 0);
+        }
+
+        assert(kuint128_cmp(a, b) == (ra < rb ? -1 : ra > rb ? 1 : 0));
+        assert(kuint128_eq(a, b) == (ra == rb));
+
+        if (b_lo != 0)
+        {
+            /* make quotient fit into 64 bits */
+            const kuint128_t n = kuint128_make(a_hi % b_lo, a_lo);
+            const ref_t rn = ((ref_t)(a_hi % b_lo) << 64) | a_lo;
+            uint64_t rem;
+            assert(kuint128_divrem64(n, b_lo, &rem) == (uint64_t)(rn / b_lo));
+            assert(rem == (uint64_t)(rn % b_lo));
+        }
+
+#undef TEST_KINT128_EQ
+    }
+#endif
+}
+
+void test_kint128(void)
+{
+    test_kint128_fixed();
+    test_kint128_random();
+}
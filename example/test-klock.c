@@ -0,0 +1,172 @@
+#include <kmacros/klock.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+void test_klock(void);
+
+#define TEST_KLOCK_THREADS  4
+#define TEST_KLOCK_ITERS    20000
+#define TEST_KLOCK_WRITES   20000
+
+static kspinlock_t test_klock_spin = KSPINLOCK_INIT;
+static kticketlock_t test_klock_ticket = KTICKETLOCK_INIT;
+static uint64_t test_klock_spin_counter;
+static uint64_t test_klock_ticket_counter;
+
+typedef struct test_klock_stats
+{
+    KATOMIC(uint64_t) requests;
+    KATOMIC(uint64_t) bytes;     /* always 100 * requests */
+} test_klock_stats_t;
+
+static kseqlock_t test_klock_seq = KSEQLOCK_INIT;
+static test_klock_stats_t test_klock_stats;
+
+static void test_klock_single(void)
+{
+    kspinlock_t spin;
+    kticketlock_t ticket;
+    kseqlock_t seq;
+
+    assert(sizeof(spin) == KCACHE_LINE_SIZE && _Alignof(kspinlock_t) == KCACHE_LINE_SIZE);
+    assert(sizeof(ticket) == KCACHE_LINE_SIZE);
+    assert(sizeof(seq) == 2 * KCACHE_LINE_SIZE);
+
+    kspinlock_init(&spin);
+    assert(kspinlock_trylock(&spin) && !kspinlock_trylock(&spin));
+    kspinlock_unlock(&spin);
+    kspinlock_lock(&spin);
+    assert(!kspinlock_trylock(&spin));
+    kspinlock_unlock(&spin);
+
+    kticketlock_init(&ticket);
+    assert(kticketlock_trylock(&ticket) && !kticketlock_trylock(&ticket));
+    kticketlock_unlock(&ticket);
+    kticketlock_lock(&ticket);
+    assert(!kticketlock_trylock(&ticket));
+    kticketlock_unlock(&ticket);
+    assert(ticket.next == 2 && ticket.owner == 2);
+
+    kseqlock_init(&seq);
+    uint32_t s = kseqlock_read_begin(&seq);
+    assert(!kseqlock_read_retry(&seq, s));
+
+    /* write between begin and retry forces retry */
+    kseqlock_write_begin(&seq);
+    kseqlock_write_end(&seq);
+    assert(kseqlock_read_retry(&seq, s));
+
+    s = kseqlock_read_begin(&seq);
+    assert(s == 2 && !kseqlock_read_retry(&seq, s));
+}
+
+static void *test_klock_counter_thread(void *arg)
+{
+    (void)arg;
+    for (size_t i = 0; i < TEST_KLOCK_ITERS; ++i)
+    {
+        kspinlock_lock(&test_klock_spin);
+        ++test_klock_spin_counter;
+        kspinlock_unlock(&test_klock_spin);
+
+        kticketlock_lock(&test_klock_ticket);
+        ++test_klock_ticket_counter;
+        kticketlock_unlock(&test_klock_ticket);
+    }
+
+    return NULL;
+}
+
+static void *test_klock_seq_writer(void *arg)
+{
+    (void)arg;
+    for (uint64_t i = 1; i <= TEST_KLOCK_WRITES; ++i)
+    {
+        kseqlock_write_begin(&test_klock_seq);
+        KATOMIC_STORE(&test_klock_stats.requests, i, KATOMIC_RELAXED);
+        KATOMIC_STORE(&test_klock_stats.bytes, 100 * i, KATOMIC_RELAXED);
+        kseqlock_write_end(&test_klock_seq);
+    }
+
+    return NULL;
+}
+
+static void *test_klock_seq_reader(void *arg)
+{
+    uint64_t last = 0;
+
+    (void)arg;
+    while (last < TEST_KLOCK_WRITES)
+    {
+        uint64_t requests;
+        uint64_t bytes;
+        uint32_t seq;
+
+        do
+        {
+            seq = kseqlock_read_begin(&test_klock_seq);
+            requests = KATOMIC_LOAD(&test_klock_stats.requests, KATOMIC_RELAXED);
+            bytes = KATOMIC_LOAD(&test_klock_stats.bytes, KATOMIC_RELAXED);
+        } while (kseqlock_read_retry(&test_klock_seq, seq));
+
+        /* snapshot is never torn and never goes back */
+        assert(bytes == 100 * requests && requests >= last);
+        last = requests;
+
+        (void)sched_yield();
+    }
+
+    return NULL;
+}
+
+static void test_klock_threads(void)
+{
+    pthread_t threads[TEST_KLOCK_THREADS];
+    pthread_t writer;
+    int ret;
+
+    for (size_t i = 0; i < TEST_KLOCK_THREADS; ++i)
+    {
+        ret = pthread_create(&threads[i], NULL, test_klock_counter_thread, NULL);
+        assert(ret == 0);
+    }
+
+    for (size_t i = 0; i < TEST_KLOCK_THREADS; ++i)
+    {
+        ret = pthread_join(threads[i], NULL);
+        assert(ret == 0);
+    }
+
+    assert(test_klock_spin_counter == TEST_KLOCK_THREADS * TEST_KLOCK_ITERS);
+    assert(test_klock_ticket_counter == TEST_KLOCK_THREADS * TEST_KLOCK_ITERS);
+
+    for (size_t i = 0; i < TEST_KLOCK_THREADS; ++i)
+    {
+        ret = pthread_create(&threads[i], NULL, test_klock_seq_reader, NULL);
+        assert(ret == 0);
+    }
+
+    ret = pthread_create(&writer, NULL, test_klock_seq_writer, NULL);
+    assert(ret == 0);
+    ret = pthread_join(writer, NULL);
+    assert(ret == 0);
+
+    for (size_t i = 0; i < TEST_KLOCK_THREADS; ++i)
+    {
+        ret = pthread_join(threads[i], NULL);
+        assert(ret == 0);
+    }
+
+    assert(test_klock_seq.seq == 2 * TEST_KLOCK_WRITES);
+
+    (void)ret; /* only checked by assert */
+}
+
+void test_klock(void)
+{
+    test_klock_single();
+    test_klock_threads();
+}
@@ -0,0 +1,191 @@
+#include <kmacros/kmacros.h>
+#include <kmacros/kint128.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "test-rand.h"
+
+void test_kmacros_common(void);
+
+static void test_kmacros_common_const_ice(void);
+static void test_kmacros_common_const_values(void);
+static void test_kmacros_common_mask(void);
+static void test_kmacros_common_fastrange(void);
+static void test_kmacros_common_nested(void);
+
+/* _CONST versions are integer constant expressions, so they can size arrays at file scope */
+static uint8_t test_kmacros_common_ring[KROUND_POWER2_UP_CONST(1000u)];
+static uint32_t test_kmacros_common_table[KLOG2_CEIL_CONST(1000u) + 1];
+
+KSTATIC_ASSERT(sizeof(test_kmacros_common_ring) == 1024);
+KSTATIC_ASSERT(sizeof(test_kmacros_common_table) / sizeof(test_kmacros_common_table[0]) == 11);
+KSTATIC_ASSERT(KLOG2_FLOOR_CONST(sizeof(test_kmacros_common_ring)) == 10);
+KSTATIC_ASSERT(KIS_POWER2_CONST(sizeof(test_kmacros_common_ring)) && !KIS_POWER2_CONST(1000));
+KSTATIC_ASSERT(KROUND_POWER2_DOWN_CONST(UINT64_MAX) == UINT64_C(1) << 63);
+KSTATIC_ASSERT(KMASK(0, 63) == UINT64_MAX);
+
+static uint64_t test_kmacros_common_seed = 0x9E3779B97F4A7C15ull;
+
+/* Edge values first, then random values with random number of bits */
+static uint64_t test_kmacros_common_value(size_t i)
+{
+    const uint64_t edges[] = {0, 1, 2, 3, 5, 7, 10, 641, UINT32_MAX / 2, (uint64_t)UINT32_MAX / 2 + 1, UINT32_MAX - 1, UINT32_MAX,
+                              (uint64_t)UINT32_MAX + 1, UINT64_MAX / 2, UINT64_MAX / 2 + 1, UINT64_MAX - 1, UINT64_MAX};
+
+    if (i < sizeof(edges) / sizeof(edges[0]))
+        return edges[i];
+
+    const uint64_t r = test_rand_next(&test_kmacros_common_seed);
+    return r >> (test_rand_next(&test_kmacros_common_seed) % 64);
+}
+
+static void test_kmacros_common_const_ice(void)
+{
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        int log;
+
+        /* case labels need integer constant expressions */
+        switch (1u << i)
+        {
+            case KROUND_POWER2_DOWN_CONST(1u):   log = KLOG2_FLOOR_CONST(1u);   break;
+            case KROUND_POWER2_UP_CONST(2u):     log = KLOG2_FLOOR_CONST(2u);   break;
+            case KROUND_POWER2_UP_CONST(3u):     log = KLOG2_CEIL_CONST(3u);    break;
+            case KROUND_POWER2_DOWN_CONST(15u):  log = KLOG2_FLOOR_CONST(15u);  break;
+            case KROUND_POWER2_UP_CONST(9u):     log = KLOG2_CEIL_CONST(9u);    break;
+            case KROUND_POWER2_DOWN_CONST(63u):  log = KLOG2_FLOOR_CONST(63u);  break;
+            case KROUND_POWER2_UP_CONST(33u):    log = KLOG2_CEIL_CONST(33u);   break;
+            case KROUND_POWER2_DOWN_CONST(128u): log = KLOG2_FLOOR_CONST(128u); break;
+            default: log = -1; break;
+        }
+
+        assert(log == (int)i);
+    }
+
+    assert(sizeof(test_kmacros_common_ring) == KROUND_POWER2_UP(1000u));
+}
+
+/* Compare _CONST versions and front macros with function versions */
+static void test_kmacros_common_const_values(void)
+{
+    for (size_t i = 0; i < 3000; ++i)
+    {
+        uint64_t v;
+
+        if (i < 130)
+            v = i;
+        else if (i < 130 + 64 * 3)
+            v = (UINT64_C(1) << ((i - 130) / 3)) + (uint64_t)((i - 130) % 3) - 1;
+        else
+            v = test_rand_next(&test_kmacros_common_seed) >> (test_rand_next(&test_kmacros_common_seed) % 64);
+
+        const unsigned long long ull = v;
+        const unsigned int u = (unsigned int)v;
+
+        assert(KIS_POWER2_CONST(ull) == KIS_POWER2_TYPE(ull));
+        assert(KLOG2_FLOOR_CONST(ull) == KLOG2_FLOOR_TYPE(ull));
+        assert(KLOG2_CEIL_CONST(ull) == KLOG2_CEIL_TYPE(ull));
+        assert(KROUND_POWER2_DOWN_CONST(ull) == KROUND_POWER2_DOWN_TYPE(ull));
+
+        assert(KIS_POWER2_CONST(u) == KIS_POWER2_TYPE(u));
+        assert(KLOG2_FLOOR_CONST(u) == KLOG2_FLOOR_TYPE(u));
+        assert(KLOG2_CEIL_CONST(u) == KLOG2_CEIL_TYPE(u));
+        assert(KROUND_POWER2_DOWN_CONST(u) == KROUND_POWER2_DOWN_TYPE(u));
+
+        /* round up of value > highest power of 2 does not fit into type */
+        if (ull <= UINT64_C(1) << 63)
+            assert(KROUND_POWER2_UP_CONST(ull) == KROUND_POWER2_UP_TYPE(ull));
+
+        if (u <= UINT32_C(1) << 31)
+            assert(KROUND_POWER2_UP_CONST(u) == KROUND_POWER2_UP_TYPE(u));
+
+        assert(KLOG2_FLOOR(ull) == KLOG2_FLOOR_TYPE(ull) && KLOG2_CEIL(u) == KLOG2_CEIL_TYPE(u));
+        assert(KIS_POWER2(u) == KIS_POWER2_TYPE(u) && KROUND_POWER2_DOWN(ull) == KROUND_POWER2_DOWN_TYPE(ull));
+    }
+
+    /* constant arguments go through folded path of front macros */
+    assert(KLOG2_FLOOR(1ull << 40) == 40 && KLOG2_CEIL(1000ul) == 10 && KLOG2_FLOOR(0u) == -1);
+    assert(KROUND_POWER2_UP(1000u) == 1024 && KROUND_POWER2_DOWN(1000ul) == 512 && KIS_POWER2(4096u));
+}
+
+static void test_kmacros_common_mask(void)
+{
+    assert(KMASK(0, 63) == UINT64_MAX && KMASK(63, 63) == UINT64_C(1) << 63 && KMASK(1, 3) == 0xE);
+    assert(KMASK(0, 31) == UINT32_MAX && KMASK(32, 63) == (uint64_t)UINT32_MAX << 32);
+
+    for (unsigned int s = 0; s < 64; ++s)
+        for (unsigned int e = s; e < 64; ++e)
+        {
+            uint64_t ref = 0;
+            for (unsigned int k = s; k <= e; ++k)
+                ref |= UINT64_C(1) << k;
+
+            assert(KMASK(s, e) == ref);
+        }
+}
+
+static void test_kmacros_common_fastrange(void)
+{
+    /* Non constant n so both paths of KBUCKET_INDEX are compared */
+    volatile uint64_t n_runtime;
+
+    assert(KFASTRANGE32(UINT32_MAX, 10) == 9 && KFASTRANGE32(0, 10) == 0 && KFASTRANGE32(UINT32_MAX, 0) == 0);
+    assert(KFASTRANGE64(UINT64_MAX, 10) == 9 && KFASTRANGE64(UINT64_C(1) << 63, 10) == 5);
+    assert(KMOD_POW2(77u, 32u) == 13 && KMOD_POW2(UINT64_MAX, UINT64_C(1) << 40) == (UINT64_C(1) << 40) - 1);
+
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        const uint64_t h = test_rand_next(&test_kmacros_common_seed);
+        const uint64_t v = test_kmacros_common_value(i);
+        const uint64_t n = v != 0 ? v : 1;
+
+        assert(KFASTRANGE64(h, n) < n && KFASTRANGE64(h, n) == kuint128_mulhi64(h, n));
+        assert(KFASTRANGE32(h, n) < (uint32_t)n || (uint32_t)n == 0);
+        assert(KFASTRANGE32(h, n) == (uint32_t)(((h & UINT32_MAX) * (n & UINT32_MAX)) >> 32));
+
+        /* compile time power of 2 gives the same index as fastrange */
+        n_runtime = 1;
+        assert(KBUCKET_INDEX64(h, 1) == 0 && KBUCKET_INDEX64(h, 1) == KFASTRANGE64(h, n_runtime));
+        n_runtime = 1024;
+        assert(KBUCKET_INDEX64(h, 1024) == (h >> 54) && KBUCKET_INDEX64(h, 1024) == KBUCKET_INDEX64(h, n_runtime));
+        n_runtime = UINT64_C(1) << 63;
+        assert(KBUCKET_INDEX64(h, UINT64_C(1) << 63) == KBUCKET_INDEX64(h, n_runtime));
+        n_runtime = 4096;
+        assert(KBUCKET_INDEX32(h, 4096) == ((uint32_t)h >> 20) && KBUCKET_INDEX32(h, 4096) == KBUCKET_INDEX32(h, n_runtime));
+        n_runtime = UINT32_C(1) << 31;
+        assert(KBUCKET_INDEX32(h, UINT32_C(1) << 31) == KBUCKET_INDEX32(h, n_runtime));
+        assert(KBUCKET_INDEX32(h, 1000) == KFASTRANGE32(h, 1000) && KBUCKET_INDEX64(h, n) == KFASTRANGE64(h, n));
+    }
+}
+
+/* Front macros expand n only few times, so they can be nested */
+static void test_kmacros_common_nested(void)
+{
+    assert(KLOG2_CEIL(KROUND_POWER2_UP(KROUND_POWER2_DOWN(1000u))) == 9);
+    assert(KLOG2_FLOOR(KROUND_POWER2_DOWN(KROUND_POWER2_UP((1ull << 40) + 1))) == 41);
+    assert(KLOG2_CEIL(KROUND_POWER2_UP(KROUND_POWER2_DOWN(0ul))) == -1 && !KIS_POWER2(KROUND_POWER2_UP(KROUND_POWER2_DOWN(0u))));
+
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        const unsigned long long ull = test_kmacros_common_value(i);
+        const unsigned int u = (unsigned int)ull;
+
+        /* round down gives power of 2, so round up keeps it and ceil is the same as floor of n */
+        assert(KLOG2_CEIL(KROUND_POWER2_UP(KROUND_POWER2_DOWN(ull))) == KLOG2_FLOOR_TYPE(ull));
+        assert(KLOG2_CEIL(KROUND_POWER2_UP(KROUND_POWER2_DOWN(u))) == KLOG2_FLOOR_TYPE(u));
+        /* round up of value > highest power of 2 does not fit into type */
+        if (u <= UINT32_C(1) << 31)
+            assert(KIS_POWER2(KROUND_POWER2_DOWN(KROUND_POWER2_UP(u))) == (u != 0));
+    }
+}
+
+void test_kmacros_common(void)
+{
+    test_kmacros_common_const_ice();
+    test_kmacros_common_const_values();
+    test_kmacros_common_mask();
+    test_kmacros_common_fastrange();
+    test_kmacros_common_nested();
+}
@@ -0,0 +1,151 @@
+#define KPOOL_DEBUG
+#include <kmacros/kpool.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <pthread.h>
+
+void test_kpool(void);
+
+#define TEST_KPOOL_OBJECTS  1000
+#define TEST_KPOOL_THREADS  4
+
+typedef struct test_kpool_conn
+{
+    int          fd;
+    kpool_node_t node;
+    char         buf[40];
+} test_kpool_conn_t;
+
+typedef struct test_kpool_aligned
+{
+    kpool_node_t node;
+    _Alignas(64) uint64_t x;
+} test_kpool_aligned_t;
+
+KPOOL_DEFINE(test_kpool_conn_pool, test_kpool_conn_t, node)
+KPOOL_DEFINE(test_kpool_aligned_pool, test_kpool_aligned_t, node)
+
+static void test_kpool_alloc(void)
+{
+    static test_kpool_conn_t *objs[TEST_KPOOL_OBJECTS];
+    kpool_t pool;
+
+    assert(test_kpool_conn_pool_init(&pool, 100) == 0);
+
+    for (size_t i = 0; i < TEST_KPOOL_OBJECTS; ++i)
+    {
+        objs[i] = test_kpool_conn_pool_alloc(&pool);
+        assert(objs[i] != NULL && (uintptr_t)objs[i] % _Alignof(test_kpool_conn_t) == 0);
+
+        objs[i]->fd = (int)i;
+        memset(objs[i]->buf, (int)(i & 0xFF), sizeof(objs[i]->buf));
+    }
+
+    assert(pool.nslabs == TEST_KPOOL_OBJECTS / 100);
+
+    for (size_t i = 0; i < TEST_KPOOL_OBJECTS; ++i)
+        assert(objs[i]->fd == (int)i && objs[i]->buf[39] == (char)i);
+
+    /* free object is poisoned except node */
+    test_kpool_conn_t *last = objs[TEST_KPOOL_OBJECTS - 1];
+    test_kpool_conn_pool_free(&pool, last);
+    assert(last->buf[0] == (char)KPOOL_POISON_BYTE && last->fd == (int)0x6B6B6B6B);
+
+    /* free list is LIFO, the last freed object is reused first */
+    assert(test_kpool_conn_pool_alloc(&pool) == last);
+    test_kpool_conn_pool_free(&pool, NULL);
+
+    for (size_t i = 0; i < TEST_KPOOL_OBJECTS; ++i)
+        test_kpool_conn_pool_free(&pool, objs[i]);
+
+    /* steady state does not take new slabs */
+    for (size_t i = 0; i < TEST_KPOOL_OBJECTS; ++i)
+        objs[i] = test_kpool_conn_pool_alloc(&pool);
+
+    assert(pool.nslabs == TEST_KPOOL_OBJECTS / 100);
+    test_kpool_conn_pool_destroy(&pool);
+
+    assert(test_kpool_aligned_pool_init(&pool, 0) == 0);
+    for (size_t i = 0; i < 10; ++i)
+    {
+        test_kpool_aligned_t *obj = test_kpool_aligned_pool_alloc(&pool);
+        assert(obj != NULL && (uintptr_t)obj % 64 == 0);
+    }
+    test_kpool_aligned_pool_destroy(&pool);
+}
+
+static kpool_t test_kpool_shared;
+
+static void *test_kpool_thread(void *arg)
+{
+    test_kpool_conn_t *objs[64] = {NULL};
+    kpool_cache_t cache;
+    const int id = (int)(intptr_t)arg;
+
+    test_kpool_conn_pool_cache_init(&cache, &test_kpool_shared);
+    for (size_t step = 0; step < 20000; ++step)
+    {
+        const size_t i = (step * 7) % KARRAY_SIZE(objs);
+        if (objs[i] != NULL)
+        {
+            assert(objs[i]->fd == id && objs[i]->buf[0] == (char)i);
+            test_kpool_conn_pool_cache_free(&cache, objs[i]);
+            objs[i] = NULL;
+            continue;
+        }
+
+        objs[i] = test_kpool_conn_pool_cache_alloc(&cache);
+        assert(objs[i] != NULL);
+        objs[i]->fd = id;
+        objs[i]->buf[0] = (char)i;
+
+        /* cache never keeps more than 2 batches */
+        assert(cache.count <= 2 * KPOOL_CACHE_BATCH);
+    }
+
+    for (size_t i = 0; i < KARRAY_SIZE(objs); ++i)
+        test_kpool_conn_pool_cache_free(&cache, objs[i]);
+
+    test_kpool_conn_pool_cache_destroy(&cache);
+
+    return NULL;
+}
+
+static void test_kpool_cache(void)
+{
+    pthread_t threads[TEST_KPOOL_THREADS];
+    int ret;
+
+    assert(test_kpool_conn_pool_init(&test_kpool_shared, 0) == 0);
+
+    for (size_t i = 0; i < TEST_KPOOL_THREADS; ++i)
+    {
+        ret = pthread_create(&threads[i], NULL, test_kpool_thread, (void *)(intptr_t)(i + 1));
+        assert(ret == 0);
+    }
+
+    for (size_t i = 0; i < TEST_KPOOL_THREADS; ++i)
+    {
+        ret = pthread_join(threads[i], NULL);
+        assert(ret == 0);
+    }
+
+    /* every object is back in pool */
+    size_t free_objs = 0;
+    for (const kpool_node_t *node = test_kpool_shared.free_list; node != NULL; node = node->next)
+        ++free_objs;
+
+    assert(free_objs == test_kpool_shared.nslabs * test_kpool_shared.slab_objs - test_kpool_shared.bump_left);
+    test_kpool_conn_pool_destroy(&test_kpool_shared);
+
+    (void)ret; /* only checked by assert */
+}
+
+void test_kpool(void)
+{
+    test_kpool_alloc();
+    test_kpool_cache();
+}
@@ -0,0 +1,149 @@
+#include <kmacros/kqueue.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <sched.h>
+
+void test_kqueue(void);
+
+#define TEST_KQUEUE_PRODUCERS   4
+#define TEST_KQUEUE_CONSUMERS   4
+#define TEST_KQUEUE_ITEMS       50000
+
+KQUEUE_MPMC_DEFINE(test_kqueue_u64, uint64_t)
+
+static void test_kqueue_single(void)
+{
+    kqueue_mpmc_t queue;
+    int values[4];
+    void *out;
+
+    assert(kqueue_mpmc_init(&queue, 0) == -1);
+    assert(kqueue_mpmc_init(&queue, 1) == -1);
+    assert(kqueue_mpmc_init(&queue, 6) == -1);
+    assert(kqueue_mpmc_init(&queue, 4) == 0);
+    assert(kqueue_mpmc_capacity(&queue) == 4 && kqueue_mpmc_size(&queue) == 0);
+    assert((uintptr_t)&queue.dequeue_pos - (uintptr_t)&queue.enqueue_pos >= KCACHE_LINE_SIZE);
+
+    assert(!kqueue_mpmc_pop(&queue, &out));
+
+    for (size_t i = 0; i < 4; ++i)
+        assert(kqueue_mpmc_push(&queue, &values[i]));
+
+    assert(!kqueue_mpmc_push(&queue, &values[0]) && kqueue_mpmc_size(&queue) == 4);
+
+    /* FIFO order also after many laps */
+    for (size_t round = 0; round < 20; ++round)
+    {
+        assert(kqueue_mpmc_pop(&queue, &out) && out == &values[round % 4]);
+        assert(kqueue_mpmc_push(&queue, &values[round % 4]));
+    }
+
+    kqueue_mpmc_destroy(&queue);
+}
+
+static test_kqueue_u64_t test_kqueue_shared;
+static uint64_t test_kqueue_sums[TEST_KQUEUE_CONSUMERS];
+static KATOMIC(size_t) test_kqueue_popped;
+
+static void *test_kqueue_producer(void *arg)
+{
+    const uint64_t id = (uint64_t)(uintptr_t)arg;
+
+    for (uint64_t i = 0; i < TEST_KQUEUE_ITEMS; )
+    {
+        /* item keeps producer in high bits, so order of producer items is checked by consumers */
+        if (test_kqueue_u64_push(&test_kqueue_shared, (id << 32) | i))
+            ++i;
+        else
+            (void)sched_yield();
+    }
+
+    return NULL;
+}
+
+static void *test_kqueue_consumer(void *arg)
+{
+    const size_t id = (size_t)(uintptr_t)arg;
+    uint64_t last[TEST_KQUEUE_PRODUCERS];
+    bool seen[TEST_KQUEUE_PRODUCERS] = {false};
+
+    for (;;)
+    {
+        if (KATOMIC_LOAD(&test_kqueue_popped, KATOMIC_RELAXED) == TEST_KQUEUE_PRODUCERS * TEST_KQUEUE_ITEMS)
+            break;
+
+        uint64_t item;
+        if (!test_kqueue_u64_pop(&test_kqueue_shared, &item))
+        {
+            (void)sched_yield();
+            continue;
+        }
+
+        const size_t producer = (size_t)(item >> 32);
+        const uint64_t seq = item & 0xFFFFFFFFu;
+
+        /* items of one producer are popped in push order */
+        assert(producer < TEST_KQUEUE_PRODUCERS && (!seen[producer] || seq > last[producer]));
+        seen[producer] = true;
+        last[producer] = seq;
+
+        test_kqueue_sums[id] += seq;
+        (void)KATOMIC_FETCH_ADD(&test_kqueue_popped, 1, KATOMIC_RELAXED);
+    }
+
+    return NULL;
+}
+
+static void test_kqueue_threads(void)
+{
+    pthread_t producers[TEST_KQUEUE_PRODUCERS];
+    pthread_t consumers[TEST_KQUEUE_CONSUMERS];
+    int ret;
+
+    assert(test_kqueue_u64_init(&test_kqueue_shared, 64) == 0);
+
+    for (size_t i = 0; i < TEST_KQUEUE_CONSUMERS; ++i)
+    {
+        ret = pthread_create(&consumers[i], NULL, test_kqueue_consumer, (void *)(uintptr_t)i);
+        assert(ret == 0);
+    }
+
+    for (size_t i = 0; i < TEST_KQUEUE_PRODUCERS; ++i)
+    {
+        ret = pthread_create(&producers[i], NULL, test_kqueue_producer, (void *)(uintptr_t)i);
+        assert(ret == 0);
+    }
+
+    for (size_t i = 0; i < TEST_KQUEUE_PRODUCERS; ++i)
+    {
+        ret = pthread_join(producers[i], NULL);
+        assert(ret == 0);
+    }
+
+    for (size_t i = 0; i < TEST_KQUEUE_CONSUMERS; ++i)
+    {
+        ret = pthread_join(consumers[i], NULL);
+        assert(ret == 0);
+    }
+
+    /* every item is popped exactly once */
+    uint64_t sum = 0;
+    for (size_t i = 0; i < TEST_KQUEUE_CONSUMERS; ++i)
+        sum += test_kqueue_sums[i];
+
+    assert(sum == (uint64_t)TEST_KQUEUE_PRODUCERS * TEST_KQUEUE_ITEMS * (TEST_KQUEUE_ITEMS - 1) / 2);
+    assert(test_kqueue_u64_size(&test_kqueue_shared) == 0);
+
+    test_kqueue_u64_destroy(&test_kqueue_shared);
+
+    (void)ret; /* only checked by assert */
+}
+
+void test_kqueue(void)
+{
+    test_kqueue_single();
+    test_kqueue_threads();
+}
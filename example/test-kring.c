@@ -0,0 +1,141 @@
+#include <kmacros/kring.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <sched.h>
+
+void test_kring(void);
+
+#define TEST_KRING_ITEMS    200000
+
+KRING_SPSC_DEFINE(test_kring_u64, uint64_t)
+
+static void test_kring_single(void)
+{
+    kring_spsc_t ring;
+    int values[8];
+    void *out;
+
+    assert(kring_spsc_init(&ring, 0) == -1);
+    assert(kring_spsc_init(&ring, 5) == 0);
+    assert(kring_spsc_capacity(&ring) == 8 && kring_spsc_size(&ring) == 0);
+    assert((uintptr_t)&ring.tail - (uintptr_t)&ring.slots >= KCACHE_LINE_SIZE);
+    assert((uintptr_t)&ring.head - (uintptr_t)&ring.tail >= KCACHE_LINE_SIZE);
+
+    assert(!kring_spsc_pop(&ring, &out));
+
+    for (size_t i = 0; i < 8; ++i)
+        assert(kring_spsc_push(&ring, &values[i]));
+
+    assert(!kring_spsc_push(&ring, &values[0]) && kring_spsc_size(&ring) == 8);
+
+    /* FIFO order also after wrap around */
+    for (size_t round = 0; round < 20; ++round)
+    {
+        assert(kring_spsc_pop(&ring, &out) && out == &values[round % 8]);
+        assert(kring_spsc_push(&ring, &values[round % 8]));
+    }
+
+    kring_spsc_destroy(&ring);
+}
+
+static void test_kring_batch(void)
+{
+    test_kring_u64_t ring;
+    uint64_t in[100];
+    uint64_t out[100];
+
+    for (size_t i = 0; i < KARRAY_SIZE(in); ++i)
+        in[i] = i;
+
+    assert(test_kring_u64_init(&ring, 64) == 0);
+    assert(test_kring_u64_capacity(&ring) == 64);
+
+    /* batch is cut to free slots */
+    assert(test_kring_u64_push_batch(&ring, in, 100) == 64);
+    assert(test_kring_u64_push_batch(&ring, in, 1) == 0);
+
+    assert(test_kring_u64_pop_batch(&ring, out, 10) == 10);
+    for (size_t i = 0; i < 10; ++i)
+        assert(out[i] == i);
+
+    assert(test_kring_u64_push_batch(&ring, &in[64], 36) == 10);
+    assert(test_kring_u64_pop_batch(&ring, out, 100) == 64);
+    for (size_t i = 0; i < 64; ++i)
+        assert(out[i] == i + 10);
+
+    assert(test_kring_u64_pop_batch(&ring, out, 100) == 0);
+    test_kring_u64_destroy(&ring);
+}
+
+static test_kring_u64_t test_kring_shared;
+
+static void *test_kring_consumer(void *arg)
+{
+    uint64_t expected = 0;
+    uint64_t items[32];
+
+    (void)arg;
+    while (expected < TEST_KRING_ITEMS)
+    {
+        const size_t n = test_kring_u64_pop_batch(&test_kring_shared, items, KARRAY_SIZE(items));
+        if (n == 0)
+            (void)sched_yield();
+
+        for (size_t i = 0; i < n; ++i)
+            assert(items[i] == expected++);
+    }
+
+    return NULL;
+}
+
+static void test_kring_threads(void)
+{
+    pthread_t consumer;
+    int ret;
+
+    assert(test_kring_u64_init(&test_kring_shared, 256) == 0);
+    ret = pthread_create(&consumer, NULL, test_kring_consumer, NULL);
+    assert(ret == 0);
+
+    for (uint64_t i = 0; i < TEST_KRING_ITEMS; )
+    {
+        /* mix single and batch push */
+        if (i % 3 == 0)
+        {
+            if (test_kring_u64_push(&test_kring_shared, i))
+                ++i;
+            else
+                (void)sched_yield();
+
+            continue;
+        }
+
+        uint64_t items[16];
+        const size_t n = (size_t)KMIN((uint64_t)KARRAY_SIZE(items), TEST_KRING_ITEMS - i);
+        for (size_t j = 0; j < n; ++j)
+            items[j] = i + j;
+
+        const size_t pushed = test_kring_u64_push_batch(&test_kring_shared, items, n);
+        if (pushed == 0)
+            (void)sched_yield();
+
+        i += pushed;
+    }
+
+    ret = pthread_join(consumer, NULL);
+    assert(ret == 0);
+    assert(test_kring_u64_size(&test_kring_shared) == 0);
+    test_kring_u64_destroy(&test_kring_shared);
+
+    (void)ret; /* only checked by assert */
+}
+
+void test_kring(void)
+{
+    test_kring_single();
+    test_kring_batch();
+    test_kring_threads();
+}
@@ -0,0 +1,115 @@
+#include <kmacros/kslab.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "test-rand.h"
+
+void test_kslab(void);
+
+#define TEST_KSLAB_OBJECTS 5000
+
+typedef struct test_kslab_node
+{
+    uint64_t key;
+    uint64_t value[5];
+} test_kslab_node_t;
+
+static uint64_t test_kslab_seed = 0x9E3779B97F4A7C15ull;
+
+static void test_kslab_classes(void)
+{
+    assert(kslab_class_index(0) == 0 && kslab_class_index(1) == 0 && kslab_class_index(KSLAB_MIN_SIZE) == 0);
+    assert(kslab_class_index(KSLAB_MIN_SIZE + 1) == 1 && kslab_class_index(64) == 2 && kslab_class_index(65) == 3);
+    assert(kslab_class_index(KSLAB_MAX_SIZE) == KSLAB_CLASSES - 1);
+
+    for (size_t size = 0; size <= KSLAB_MAX_SIZE; ++size)
+    {
+        const size_t class_size = kslab_class_size(kslab_class_index(size));
+        assert(class_size >= size && (class_size == KSLAB_MIN_SIZE || class_size / 2 < size));
+    }
+}
+
+static void test_kslab_alloc_free(void)
+{
+    static void *objs[TEST_KSLAB_OBJECTS];
+    static size_t sizes[TEST_KSLAB_OBJECTS];
+    kslab_t slab;
+
+    kslab_init(&slab);
+
+    /* every object is filled with own pattern, overlapping objects would break patterns */
+    for (size_t round = 0; round < 3; ++round)
+    {
+        for (size_t i = 0; i < TEST_KSLAB_OBJECTS; ++i)
+        {
+            sizes[i] = (size_t)(test_rand_next(&test_kslab_seed) % (i % 100 == 0 ? 3 * KSLAB_MAX_SIZE : 512));
+            objs[i] = kslab_alloc(&slab, sizes[i]);
+            assert(objs[i] != NULL);
+
+            const size_t class_size = kslab_class_size(kslab_class_index(KMIN(sizes[i], KSLAB_MAX_SIZE)));
+            const size_t align = KMIN(class_size, (size_t)KCACHE_LINE_SIZE);
+            assert(sizes[i] > KSLAB_MAX_SIZE || (uintptr_t)objs[i] % align == 0);
+            memset(objs[i], (int)(i & 0xFF), sizes[i]);
+        }
+
+        for (size_t i = 0; i < TEST_KSLAB_OBJECTS; ++i)
+        {
+            const unsigned char *p = objs[i];
+            for (size_t j = 0; j < sizes[i]; ++j)
+                assert(p[j] == (unsigned char)(i & 0xFF));
+        }
+
+        /* free half, then reuse */
+        for (size_t i = round & 1; i < TEST_KSLAB_OBJECTS; i += 2)
+            kslab_free(&slab, objs[i], sizes[i]);
+
+        for (size_t i = 1 - (round & 1); i < TEST_KSLAB_OBJECTS; i += 2)
+            kslab_free(&slab, objs[i], sizes[i]);
+    }
+
+    /* all objects are on free lists, so next allocations do not need new slabs */
+    const size_t nslabs = slab.nslabs;
+    for (size_t i = 0; i < TEST_KSLAB_OBJECTS; ++i)
+        objs[i] = kslab_alloc(&slab, sizes[i]);
+
+    assert(slab.nslabs == nslabs);
+
+    for (size_t i = 0; i < TEST_KSLAB_OBJECTS; ++i)
+        if (sizes[i] > KSLAB_MAX_SIZE)
+            kslab_free(&slab, objs[i], sizes[i]);
+
+    kslab_free(&slab, NULL, 10);
+    kslab_destroy(&slab);
+    assert(slab.nslabs == 0 && slab.slabs == NULL);
+}
+
+static void test_kslab_typed(void)
+{
+    kslab_t slab;
+    kslab_init(&slab);
+
+    test_kslab_node_t *a = KSLAB_NEW(&slab, test_kslab_node_t);
+    test_kslab_node_t *b = KSLAB_NEW(&slab, test_kslab_node_t);
+    assert(a != NULL && b != NULL && a != b);
+    assert((uintptr_t)a % KCACHE_LINE_SIZE == 0 && (uintptr_t)b % KCACHE_LINE_SIZE == 0);
+
+    a->key = 1;
+    b->key = 2;
+    assert(a->key == 1 && b->key == 2);
+
+    /* free list is LIFO, the last freed object is reused first */
+    KSLAB_DELETE(&slab, a);
+    assert(KSLAB_NEW(&slab, test_kslab_node_t) == a);
+
+    kslab_destroy(&slab);
+}
+
+void test_kslab(void)
+{
+    test_kslab_classes();
+    test_kslab_alloc_free();
+    test_kslab_typed();
+}
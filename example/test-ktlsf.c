@@ -0,0 +1,188 @@
+#include <kmacros/ktlsf.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test-rand.h"
+
+void test_ktlsf(void);
+
+#define TEST_KTLSF_POOL     (1u << 20)
+#define TEST_KTLSF_OBJECTS  1000
+
+static uint64_t test_ktlsf_seed = 0x2545F4914F6CDD1Dull;
+
+/* Every byte of pool is in exactly one block (header + payload) or in sentinel header */
+static void test_ktlsf_check(const ktlsf_t *tlsf)
+{
+    ktlsf_stats_t stats;
+    ktlsf_stats(tlsf, &stats);
+
+    assert(stats.pool_size == stats.used_size + stats.free_size + (stats.used_blocks + stats.free_blocks + 1) * KTLSF_HEADER_SIZE);
+    assert(stats.largest_free <= stats.largest_block && stats.largest_block <= stats.free_size);
+    assert(stats.fragmentation >= 0.0 && stats.fragmentation <= 1.0);
+}
+
+/* largest_free is exactly the biggest size which ktlsf_alloc can return */
+static void test_ktlsf_largest_alloc(ktlsf_t *tlsf)
+{
+    ktlsf_stats_t stats;
+    ktlsf_stats(tlsf, &stats);
+
+    void *ptr = ktlsf_alloc(tlsf, stats.largest_free);
+    assert(ptr != NULL);
+    ktlsf_free(tlsf, ptr);
+
+    assert(ktlsf_alloc(tlsf, stats.largest_free + KTLSF_ALIGN_SIZE) == NULL);
+}
+
+static void test_ktlsf_mapping(void)
+{
+    for (size_t size = KTLSF_ALIGN_SIZE; size < ((size_t)1 << 24); size += size / 7 + KTLSF_ALIGN_SIZE)
+    {
+        unsigned int fl;
+        unsigned int sl;
+        unsigned int fl_search;
+        unsigned int sl_search;
+
+        __ktlsf_mapping_insert(size, &fl, &sl);
+        __ktlsf_mapping_search(size, &fl_search, &sl_search);
+
+        assert(fl < KTLSF_FL_COUNT && sl < KTLSF_SL_COUNT);
+        /* searched list is never below list of size */
+        assert(fl_search > fl || (fl_search == fl && sl_search >= sl));
+    }
+}
+
+static void test_ktlsf_random(void)
+{
+    static unsigned char pool[TEST_KTLSF_POOL];
+    static unsigned char *objs[TEST_KTLSF_OBJECTS];
+    static size_t sizes[TEST_KTLSF_OBJECTS];
+
+    assert(ktlsf_create(pool, 64) == NULL);
+
+    ktlsf_t *tlsf = ktlsf_create(pool + 1, sizeof(pool) - 1);
+    assert(tlsf != NULL);
+    test_ktlsf_check(tlsf);
+
+    ktlsf_stats_t stats;
+    ktlsf_stats(tlsf, &stats);
+    const size_t initial_free = stats.free_size;
+    assert(stats.free_blocks == 1 && stats.largest_block == initial_free && stats.fragmentation == 0.0);
+
+    assert(ktlsf_alloc(tlsf, 0) == NULL && ktlsf_alloc(tlsf, sizeof(pool)) == NULL);
+
+    for (size_t step = 0; step < 20000; ++step)
+    {
+        const size_t i = (size_t)(test_rand_next(&test_ktlsf_seed) % TEST_KTLSF_OBJECTS);
+
+        if (objs[i] != NULL)
+        {
+            for (size_t j = 0; j < sizes[i]; ++j)
+                assert(objs[i][j] == (unsigned char)i);
+
+            ktlsf_free(tlsf, objs[i]);
+            objs[i] = NULL;
+        }
+        else
+        {
+            sizes[i] = 1 + (size_t)(test_rand_next(&test_ktlsf_seed) % (step % 10 == 0 ? 16384 : 256));
+            objs[i] = ktlsf_alloc(tlsf, sizes[i]);
+            if (objs[i] == NULL)
+                continue;
+
+            assert((uintptr_t)objs[i] % KTLSF_ALIGN_SIZE == 0 && ktlsf_usable_size(objs[i]) >= sizes[i]);
+            assert(objs[i] >= pool && objs[i] + sizes[i] <= pool + sizeof(pool));
+            memset(objs[i], (int)(unsigned char)i, sizes[i]);
+        }
+
+        if (step % 1000 == 0)
+            test_ktlsf_check(tlsf);
+    }
+
+    test_ktlsf_check(tlsf);
+
+    for (size_t i = 0; i < TEST_KTLSF_OBJECTS; ++i)
+        ktlsf_free(tlsf, objs[i]);
+
+    /* every block is merged back into one */
+    ktlsf_stats(tlsf, &stats);
+    assert(stats.used_blocks == 0 && stats.used_size == 0 && stats.free_blocks == 1);
+    assert(stats.free_size == initial_free && stats.fragmentation == 0.0);
+
+    /* good fit rounds size up to next list, so half of single free block always fits */
+    void *half = ktlsf_alloc(tlsf, initial_free / 2);
+    assert(half != NULL);
+    ktlsf_free(tlsf, half);
+}
+
+static void test_ktlsf_fragmentation(void)
+{
+    static unsigned char pool[64 * 1024];
+    void *objs[64];
+
+    ktlsf_t *tlsf = ktlsf_create(pool, sizeof(pool));
+    assert(tlsf != NULL);
+
+    for (size_t i = 0; i < KARRAY_SIZE(objs); ++i)
+        objs[i] = ktlsf_alloc(tlsf, 256);
+
+    /* free every second object, holes cannot be merged */
+    for (size_t i = 0; i < KARRAY_SIZE(objs); i += 2)
+        ktlsf_free(tlsf, objs[i]);
+
+    ktlsf_stats_t stats;
+    ktlsf_stats(tlsf, &stats);
+    assert(stats.free_blocks == KARRAY_SIZE(objs) / 2 + 1 && stats.fragmentation > 0.0);
+    test_ktlsf_check(tlsf);
+    test_ktlsf_largest_alloc(tlsf);
+
+    /* hole is reused for the same size */
+    void *reused = ktlsf_alloc(tlsf, 256);
+    bool is_hole = false;
+    for (size_t i = 0; i < KARRAY_SIZE(objs); i += 2)
+        is_hole |= reused == objs[i];
+
+    assert(is_hole);
+}
+
+static void test_ktlsf_largest(void)
+{
+    const size_t max_pool = (size_t)8 << 20;
+    unsigned char *pool = malloc(max_pool);
+    assert(pool != NULL);
+
+    for (size_t bytes = sizeof(ktlsf_t) + 1024; bytes <= max_pool; bytes += bytes / 3)
+    {
+        ktlsf_t *tlsf = ktlsf_create(pool, bytes);
+        assert(tlsf != NULL);
+        test_ktlsf_largest_alloc(tlsf);
+
+        ktlsf_stats_t stats;
+        ktlsf_stats(tlsf, &stats);
+
+        /* largest block is split, so the biggest allocation comes from lower list */
+        void *ptr = ktlsf_alloc(tlsf, stats.largest_free / 3);
+        assert(ptr != NULL);
+        test_ktlsf_largest_alloc(tlsf);
+        ktlsf_free(tlsf, ptr);
+    }
+
+    ktlsf_t *tlsf = ktlsf_create(pool, max_pool);
+    assert(tlsf != NULL);
+    test_ktlsf_largest_alloc(tlsf);
+
+    free(pool);
+}
+
+void test_ktlsf(void)
+{
+    test_ktlsf_mapping();
+    test_ktlsf_random();
+    test_ktlsf_fragmentation();
+    test_ktlsf_largest();
+}
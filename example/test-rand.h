@@ -0,0 +1,24 @@
+#ifndef TEST_RAND_H
+#define TEST_RAND_H
+
+/*
+    Pseudo random generator for tests (xorshift64).
+    Every test file keeps own state, so sequences do not depend on order of tests.
+
+    state cannot be 0
+*/
+
+#include <stdint.h>
+
+static inline uint64_t test_rand_next(uint64_t *state);
+
+static inline uint64_t test_rand_next(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+
+    return *state;
+}
+
+#endif
@@ -0,0 +1,254 @@
+#ifndef KARENA_H
+#define KARENA_H
+
+/*
+    This is the public header for the KArena.
+
+    KArena is a linear (bump) allocator. Allocation moves pointer in current chunk,
+    new chunk is taken from malloc only when current chunk is full. There is no free of single object,
+    memory is released by rewinding to mark (checkpoint) or by reset, so hundreds of malloc / free calls
+    for temporary objects become one rewind. Objects allocated one after another lie one after another in memory.
+
+    Chunks released by rewind are kept and reused, so arena in steady state does not call malloc at all.
+
+    KARENA_SCOPE rewinds arena at the end of block (KATTR_VAR_CLEANUP). It is defined only when compiler
+    supports cleanup attribute (KATTR_VAR_CLEANUP_SUPPORTED), otherwise use karena_mark / karena_rewind.
+
+    KArena is not thread safe.
+
+    Include it directly: #include <kmacros/karena.h>
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE: GPL3
+*/
+
+#include "kmacros.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/* Default size of chunk for karena_init(arena, 0) */
+#ifndef KARENA_CHUNK_SIZE
+#define KARENA_CHUNK_SIZE       ((size_t)64 * 1024)
+#endif
+
+typedef struct karena_chunk
+{
+    struct karena_chunk *prev;
+    size_t               capacity;
+    max_align_t          data[];
+} karena_chunk_t;
+
+typedef struct karena
+{
+    karena_chunk_t *chunk;          /* current chunk, NULL before first allocation */
+    size_t          used;           /* bytes used in current chunk */
+    karena_chunk_t *spare;          /* chunks released by rewind, ready for reuse */
+    size_t          chunk_size;
+} karena_t;
+
+/* Position in arena, see karena_mark */
+typedef struct karena_mark
+{
+    karena_chunk_t *chunk;
+    size_t          used;
+} karena_mark_t;
+
+typedef struct karena_scope
+{
+    karena_t      *arena;
+    karena_mark_t  mark;
+} karena_scope_t;
+
+/**
+ * Every allocation from arena after KARENA_SCOPE is released at the end of current block
+ *
+ * Example:
+ * {
+ *     KARENA_SCOPE(&arena);
+ *     char *tmp = karena_alloc(&arena, 100);
+ * } <- tmp is released here
+ */
+#ifdef KATTR_VAR_CLEANUP_SUPPORTED
+#define KARENA_SCOPE(arena) \
+    karena_scope_t KVAR_ALMOST_UNIQUE_NAME(karena_scope) KATTR_VAR_CLEANUP(karena_scope_end) = karena_scope_begin(arena)
+#endif
+
+/**
+ * Allocate object of type with alignment of type
+ */
+#define KARENA_NEW(arena, type) ((type *)karena_alloc_aligned(arena, sizeof(type), _Alignof(type)))
+
+static inline void karena_init(karena_t *arena, size_t chunk_size);
+static inline void karena_destroy(karena_t *arena);
+
+static inline void *karena_alloc(karena_t *arena, size_t size) KATTR_FUNC_MALLOC;
+static inline void *karena_alloc_aligned(karena_t *arena, size_t size, size_t align) KATTR_FUNC_MALLOC;
+
+static inline karena_mark_t karena_mark(const karena_t *arena);
+static inline void karena_rewind(karena_t *arena, karena_mark_t mark);
+static inline void karena_reset(karena_t *arena);
+
+static inline karena_scope_t karena_scope_begin(karena_t *arena);
+static inline void karena_scope_end(karena_scope_t *scope);
+
+/* Private helpers, do not use */
+static inline void *__karena_grow(karena_t *arena, size_t size, size_t align);
+
+/**
+ * Init empty arena, no memory is allocated until first allocation
+ *
+ * @param[in] arena - arena
+ * @param[in] chunk_size - size of single chunk, 0 means KARENA_CHUNK_SIZE. Bigger allocations get own chunk
+ */
+static inline void karena_init(karena_t *arena, size_t chunk_size)
+{
+    arena->chunk = NULL;
+    arena->used = 0;
+    arena->spare = NULL;
+    arena->chunk_size = chunk_size == 0 ? KARENA_CHUNK_SIZE : chunk_size;
+}
+
+/**
+ * Free every chunk, all objects from arena become invalid
+ */
+static inline void karena_destroy(karena_t *arena)
+{
+    karena_reset(arena);
+
+    karena_chunk_t *chunk = arena->spare;
+    while (chunk != NULL)
+    {
+        karena_chunk_t *prev = chunk->prev;
+        free(chunk);
+        chunk = prev;
+    }
+
+    karena_init(arena, arena->chunk_size);
+}
+
+/* Start new chunk and carve object from its beginning, NULL when size cannot fit into any chunk */
+static inline void *__karena_grow(karena_t *arena, size_t size, size_t align)
+{
+    if (KUNLIKELY(size > SIZE_MAX - align))
+        return NULL;
+
+    /* object at the beginning of chunk needs padding only for align > alignof(max_align_t) */
+    const size_t needed = size + (align > _Alignof(max_align_t) ? align : 0);
+
+    karena_chunk_t *chunk = arena->spare;
+    if (chunk != NULL && chunk->capacity >= needed)
+    {
+        arena->spare = chunk->prev;
+    }
+    else
+    {
+        const size_t capacity = KMAX(arena->chunk_size, needed);
+        if (KUNLIKELY(capacity > SIZE_MAX - sizeof(*chunk)))
+            return NULL;
+
+        chunk = malloc(sizeof(*chunk) + capacity);
+        if (chunk == NULL)
+            return NULL;
+
+        chunk->capacity = capacity;
+    }
+
+    const size_t padding = (size_t)((0 - (uintptr_t)chunk->data) & (align - 1));
+
+    chunk->prev = arena->chunk;
+    arena->chunk = chunk;
+    arena->used = padding + size;
+
+    return (char *)chunk->data + padding;
+}
+
+/**
+ * Allocate memory aligned to alignof(max_align_t)
+ *
+ * @return pointer to memory or NULL on failure
+ */
+static inline void *karena_alloc(karena_t *arena, size_t size)
+{
+    return karena_alloc_aligned(arena, size, _Alignof(max_align_t));
+}
+
+/**
+ * Allocate memory with given alignment
+ *
+ * @param[in] arena - arena
+ * @param[in] size - bytes to allocate
+ * @param[in] align - alignment, not power of 2 is rounded up by KALLIGN_POWER2
+ *
+ * @return pointer to memory or NULL on failure
+ */
+static inline void *karena_alloc_aligned(karena_t *arena, size_t size, size_t align)
+{
+    align = align <= 1 ? 1 : KALLIGN_POWER2(align);
+
+    if (KLIKELY(arena->chunk != NULL))
+    {
+        const uintptr_t ptr = (uintptr_t)((char *)arena->chunk->data + arena->used);
+        const size_t padding = (size_t)((0 - ptr) & (align - 1));
+
+        if (KLIKELY(size <= arena->chunk->capacity - arena->used && padding <= arena->chunk->capacity - arena->used - size))
+        {
+            char *obj = (char *)arena->chunk->data + arena->used + padding;
+            arena->used += padding + size;
+
+            return obj;
+        }
+    }
+
+    return __karena_grow(arena, size, align);
+}
+
+/**
+ * Get current position in arena
+ */
+static inline karena_mark_t karena_mark(const karena_t *arena)
+{
+    return (karena_mark_t){.chunk = arena->chunk, .used = arena->used};
+}
+
+/**
+ * Release every allocation done after mark. Released chunks are kept for reuse
+ *
+ * @param[in] arena - arena
+ * @param[in] mark - position from karena_mark, marks taken later than this one become invalid
+ */
+static inline void karena_rewind(karena_t *arena, karena_mark_t mark)
+{
+    while (arena->chunk != mark.chunk)
+    {
+        karena_chunk_t *chunk = arena->chunk;
+        arena->chunk = chunk->prev;
+
+        chunk->prev = arena->spare;
+        arena->spare = chunk;
+    }
+
+    arena->used = mark.used;
+}
+
+/**
+ * Release every allocation, chunks are kept for reuse
+ */
+static inline void karena_reset(karena_t *arena)
+{
+    karena_rewind(arena, (karena_mark_t){.chunk = NULL, .used = 0});
+}
+
+static inline karena_scope_t karena_scope_begin(karena_t *arena)
+{
+    return (karena_scope_t){.arena = arena, .mark = karena_mark(arena)};
+}
+
+static inline void karena_scope_end(karena_scope_t *scope)
+{
+    karena_rewind(scope->arena, scope->mark);
+}
+
+#endif
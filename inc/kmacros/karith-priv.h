@@ -0,0 +1,370 @@
+#ifndef KARITH_PRIV_H
+#define KARITH_PRIV_H
+
+/*
+    This is the private header for the Karith.
+
+    This header constains arithmetic kernels working on whole arrays
+
+    Do not include it directly
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE: GPL3
+*/
+
+#ifndef KMACROS_H
+#error "Never include <kmacros/karith-priv.h> directly, use <kmacros/karith.h> instead."
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+
+#include "kcompiler-detect.h"
+#include "kcompiler.h"
+
+/*
+    Checked reductions are computed per block.
+
+    For every block positive and negative parts are summed separately in 64-bit lanes (loop without branches,
+    so compiler can vectorize it). Every prefix sum of the block lies in [acc - neg; acc + pos],
+    so when this range fits into type, scalar chain of K*_OVERFLOW could not overflow in this block.
+    Otherwise block is computed again by scalar chain, so result and overflow flag are always the same as
+    for the chain. After first overflow only wrapped sum is needed, so block is not checked any more.
+*/
+#define KARITH_PRIV_BLOCK_SIZE 1024
+
+typedef struct __karith_priv_sums
+{
+    uint64_t pos;  /* sum of positive values (mod 2^64) */
+    uint64_t neg;  /* sum of magnitudes of negative values (mod 2^64) */
+    bool     wrap; /* pos or neg does not fit into 64 bits */
+} __karith_priv_sums_t;
+
+/* Join 2 accumulators of 32-bit halves into 64-bit sum */
+static inline uint64_t __karith_priv_join64(uint64_t lo, uint64_t hi, bool *wrap);
+static inline uint64_t __karith_priv_join64(uint64_t lo, uint64_t hi, bool *wrap)
+{
+    hi += lo >> 32;
+    *wrap |= (hi >> 32) != 0;
+
+    return (hi << 32) | (lo & UINT32_MAX);
+}
+
+/* acc + pos <= max and acc - neg >= min, differences are computed mod 2^64 but they are always in [0; 2^64 - 1] */
+static inline bool __karith_priv_sums_fit(const __karith_priv_sums_t *sums, uint64_t acc, uint64_t min, uint64_t max);
+static inline bool __karith_priv_sums_fit(const __karith_priv_sums_t *sums, uint64_t acc, uint64_t min, uint64_t max)
+{
+    return !sums->wrap && sums->pos <= max - acc && sums->neg <= acc - min;
+}
+
+/*
+    All ones when 64-bit value u (as uint64_t) is negative, zero otherwise.
+    Sign is taken from the top bit, so there is no x < 0 for unsigned types.
+    Masks instead of ?: keep block loops without branches (compiler can vectorize them).
+*/
+#define KARITH_PRIV_NEG_MASK(u, is_signed) ((is_signed) ? 0 - ((u) >> 63) : 0)
+
+/*
+    Block sums of 32-bit type (or 32-bit products) do not need carry (pos = sum + neg),
+    64-bit types are summed by 32-bit halves to detect carry
+*/
+#define KARITH_PRIV_BLOCK_SUMS(sums, type, is_signed, len, value_expr) \
+    do { \
+        if (sizeof(type) < sizeof(uint64_t)) \
+        { \
+            uint64_t __sum = 0; \
+            uint64_t __neg = 0; \
+            for (size_t i = 0; i < (len); ++i) \
+            { \
+                const uint64_t __v = (uint64_t)(int64_t)(value_expr); \
+                __sum += __v; \
+                __neg += (0 - __v) & KARITH_PRIV_NEG_MASK(__v, true); \
+            } \
+            (sums)->pos = __sum + __neg; \
+            (sums)->neg = __neg; \
+            (sums)->wrap = false; \
+        } \
+        else \
+        { \
+            uint64_t __pos_lo = 0; \
+            uint64_t __pos_hi = 0; \
+            uint64_t __neg_lo = 0; \
+            uint64_t __neg_hi = 0; \
+            for (size_t i = 0; i < (len); ++i) \
+            { \
+                const uint64_t __v = (uint64_t)(type)(value_expr); \
+                const uint64_t __m = KARITH_PRIV_NEG_MASK(__v, is_signed); \
+                const uint64_t __p = __v & ~__m; \
+                const uint64_t __n = (0 - __v) & __m; \
+                __pos_lo += __p & UINT32_MAX; \
+                __pos_hi += __p >> 32; \
+                __neg_lo += __n & UINT32_MAX; \
+                __neg_hi += __n >> 32; \
+            } \
+            (sums)->wrap = false; \
+            (sums)->pos = __karith_priv_join64(__pos_lo, __pos_hi, &(sums)->wrap); \
+            (sums)->neg = __karith_priv_join64(__neg_lo, __neg_hi, &(sums)->wrap); \
+        } \
+    } while (0)
+
+/* Minimum of type as uint64_t, signed minimum is sign extended */
+#define KARITH_PRIV_MIN_AS_U64(tmin, is_signed) ((is_signed) ? (uint64_t)(int64_t)(tmin) : 0)
+
+/* After first overflow only wrapped result is needed, unsigned lanes do not need any checks */
+#define KARITH_PRIV_WRAPPED_BLOCK(acc, type, utype, len, value_expr) \
+    do { \
+        utype __wsum = (utype)(acc); \
+        for (size_t i = 0; i < (len); ++i) \
+            __wsum += (utype)(value_expr); \
+        (acc) = (type)__wsum; \
+    } while (0)
+
+#define KARITH_PRIV_CREATE_SUM_OVERFLOW_ARRAY(type, utype, suffix, tmin, tmax, is_signed) \
+    static inline bool __karith_priv_sum_overflow_array_ ## suffix(const type *arr, size_t n, type *res); \
+    static inline bool __karith_priv_sum_overflow_array_ ## suffix(const type *arr, size_t n, type *res) \
+    { \
+        type acc = 0; \
+        bool overflow = false; \
+        \
+        for (size_t start = 0; start < n; start += KARITH_PRIV_BLOCK_SIZE) \
+        { \
+            const type *block = &arr[start]; \
+            const size_t len = n - start < KARITH_PRIV_BLOCK_SIZE ? n - start : KARITH_PRIV_BLOCK_SIZE; \
+            __karith_priv_sums_t sums; \
+            \
+            if (overflow) \
+            { \
+                KARITH_PRIV_WRAPPED_BLOCK(acc, type, utype, len, block[i]); \
+                continue; \
+            } \
+            \
+            KARITH_PRIV_BLOCK_SUMS(&sums, type, is_signed, len, block[i]); \
+            \
+            const uint64_t acc64 = (uint64_t)acc; \
+            if (__karith_priv_sums_fit(&sums, acc64, KARITH_PRIV_MIN_AS_U64(tmin, is_signed), (uint64_t)(tmax))) \
+            { \
+                const uint64_t sum = acc64 + sums.pos - sums.neg; \
+                acc = (type)(utype)sum; \
+            } \
+            else \
+            { \
+                for (size_t i = 0; i < len; ++i) \
+                    overflow |= KADD_OVERFLOW(acc, block[i], &acc); \
+            } \
+        } \
+        \
+        *res = acc; \
+        return overflow; \
+    }
+
+/*
+    32-bit products are exact in 64 bits, so block is checked as for the sum.
+    Block with product out of type range is computed again by scalar chain.
+    64-bit products need wide multiplication per element (there is no such SIMD lane),
+    so 64-bit types use scalar chain until first overflow.
+*/
+#define KARITH_PRIV_CREATE_DOT_OVERFLOW_ARRAY(type, utype, wtype, suffix, tmin, tmax, is_signed) \
+    static inline bool __karith_priv_dot_overflow_array_ ## suffix(const type *a, const type *b, size_t n, type *res); \
+    static inline bool __karith_priv_dot_overflow_array_ ## suffix(const type *a, const type *b, size_t n, type *res) \
+    { \
+        type acc = 0; \
+        bool overflow = false; \
+        \
+        for (size_t start = 0; start < n; start += KARITH_PRIV_BLOCK_SIZE) \
+        { \
+            const type *block_a = &a[start]; \
+            const type *block_b = &b[start]; \
+            const size_t len = n - start < KARITH_PRIV_BLOCK_SIZE ? n - start : KARITH_PRIV_BLOCK_SIZE; \
+            \
+            if (overflow) \
+            { \
+                KARITH_PRIV_WRAPPED_BLOCK(acc, type, utype, len, (utype)block_a[i] * (utype)block_b[i]); \
+                continue; \
+            } \
+            \
+            if (sizeof(type) < sizeof(uint64_t)) \
+            { \
+                /* p in [min; max] <=> p - min in [0; max - min] */ \
+                const uint64_t min64 = KARITH_PRIV_MIN_AS_U64(tmin, is_signed); \
+                const uint64_t range = (uint64_t)(tmax) - min64; \
+                unsigned int out_of_range = 0; \
+                __karith_priv_sums_t sums; \
+                \
+                for (size_t i = 0; i < len; ++i) \
+                { \
+                    const wtype p = (wtype)block_a[i] * (wtype)block_b[i]; \
+                    out_of_range |= (unsigned int)((uint64_t)p - min64 > range); \
+                } \
+                KARITH_PRIV_BLOCK_SUMS(&sums, type, is_signed, len, (wtype)block_a[i] * (wtype)block_b[i]); \
+                \
+                const uint64_t acc64 = (uint64_t)acc; \
+                if (out_of_range == 0 && __karith_priv_sums_fit(&sums, acc64, min64, (uint64_t)(tmax))) \
+                { \
+                    /* pos - neg is sum of products mod 2^64, so also mod 2^width */ \
+                    const uint64_t sum = acc64 + sums.pos - sums.neg; \
+                    acc = (type)(utype)sum; \
+                    continue; \
+                } \
+            } \
+            \
+            for (size_t i = 0; i < len; ++i) \
+            { \
+                type p; \
+                overflow |= KMUL_OVERFLOW(block_a[i], block_b[i], &p); \
+                overflow |= KADD_OVERFLOW(acc, p, &acc); \
+            } \
+        } \
+        \
+        *res = acc; \
+        return overflow; \
+    }
+
+KARITH_PRIV_CREATE_SUM_OVERFLOW_ARRAY(int, unsigned int, int, INT_MIN, INT_MAX, true)
+KARITH_PRIV_CREATE_SUM_OVERFLOW_ARRAY(unsigned int, unsigned int, unsigned_int, 0, UINT_MAX, false)
+KARITH_PRIV_CREATE_SUM_OVERFLOW_ARRAY(long, unsigned long, long, LONG_MIN, LONG_MAX, true)
+KARITH_PRIV_CREATE_SUM_OVERFLOW_ARRAY(unsigned long, unsigned long, unsigned_long, 0, ULONG_MAX, false)
+KARITH_PRIV_CREATE_SUM_OVERFLOW_ARRAY(long long, unsigned long long, long_long, LLONG_MIN, LLONG_MAX, true)
+KARITH_PRIV_CREATE_SUM_OVERFLOW_ARRAY(unsigned long long, unsigned long long, unsigned_long_long, 0, ULLONG_MAX, false)
+
+KARITH_PRIV_CREATE_DOT_OVERFLOW_ARRAY(int, unsigned int, int64_t, int, INT_MIN, INT_MAX, true)
+KARITH_PRIV_CREATE_DOT_OVERFLOW_ARRAY(unsigned int, unsigned int, uint64_t, unsigned_int, 0, UINT_MAX, false)
+KARITH_PRIV_CREATE_DOT_OVERFLOW_ARRAY(long, unsigned long, int64_t, long, LONG_MIN, LONG_MAX, true)
+KARITH_PRIV_CREATE_DOT_OVERFLOW_ARRAY(unsigned long, unsigned long, uint64_t, unsigned_long, 0, ULONG_MAX, false)
+KARITH_PRIV_CREATE_DOT_OVERFLOW_ARRAY(long long, unsigned long long, int64_t, long_long, LLONG_MIN, LLONG_MAX, true)
+KARITH_PRIV_CREATE_DOT_OVERFLOW_ARRAY(unsigned long long, unsigned long long, uint64_t, unsigned_long_long, 0, ULLONG_MAX, false)
+
+#define KARITH_PRIV_SUM_OVERFLOW_ARRAY(arr, n, res) \
+    _Generic((res), \
+        int *:                __karith_priv_sum_overflow_array_int, \
+        unsigned int *:       __karith_priv_sum_overflow_array_unsigned_int, \
+        long *:               __karith_priv_sum_overflow_array_long, \
+        unsigned long *:      __karith_priv_sum_overflow_array_unsigned_long, \
+        long long *:          __karith_priv_sum_overflow_array_long_long, \
+        unsigned long long *: __karith_priv_sum_overflow_array_unsigned_long_long \
+    )(arr, n, res)
+
+#define KARITH_PRIV_DOT_OVERFLOW_ARRAY(a, b, n, res) \
+    _Generic((res), \
+        int *:                __karith_priv_dot_overflow_array_int, \
+        unsigned int *:       __karith_priv_dot_overflow_array_unsigned_int, \
+        long *:               __karith_priv_dot_overflow_array_long, \
+        unsigned long *:      __karith_priv_dot_overflow_array_unsigned_long, \
+        long long *:          __karith_priv_dot_overflow_array_long_long, \
+        unsigned long long *: __karith_priv_dot_overflow_array_unsigned_long_long \
+    )(a, b, n, res)
+
+/*
+    Saturating arithmetic.
+
+    Result is computed mod 2^width and overflow is detected from sign bits (add / sub) or by KMUL_OVERFLOW,
+    then saturated value is selected by mask. 32-bit products are clamped in 64 bits. There are no branches
+    so the same functions are vectorized in array loops (compare + blend, min / max).
+    paddus / padds exist only for 8 / 16-bit lanes, so for 32 / 64-bit types compiler uses such sequences.
+    Signed saturation value is max + sign bit (in unsigned arithmetic max + 1 = min).
+*/
+#define KARITH_PRIV_SIGN_BIT(ux, type) ((ux) >> (sizeof(type) * CHAR_BIT - 1))
+
+#define KARITH_PRIV_SAT_SELECT(type, utype, ur, sat, overflow) \
+    ((type)(((ur) & ~(0 - (utype)(overflow))) | ((sat) & (0 - (utype)(overflow)))))
+
+#define KARITH_PRIV_CREATE_SAT(type, utype, wtype, suffix, tmin, tmax, is_signed) \
+    static inline type __karith_priv_add_sat_ ## suffix(type x, type y); \
+    static inline type __karith_priv_add_sat_ ## suffix(type x, type y) \
+    { \
+        const utype ux = (utype)x; \
+        const utype uy = (utype)y; \
+        const utype ur = ux + uy; \
+        const utype overflow = (is_signed) ? KARITH_PRIV_SIGN_BIT((ux ^ ur) & (uy ^ ur), type) : (utype)(ur < ux); \
+        const utype sat = (utype)(tmax) + ((is_signed) ? KARITH_PRIV_SIGN_BIT(ux, type) : 0); \
+        \
+        return KARITH_PRIV_SAT_SELECT(type, utype, ur, sat, overflow); \
+    } \
+    \
+    static inline type __karith_priv_sub_sat_ ## suffix(type x, type y); \
+    static inline type __karith_priv_sub_sat_ ## suffix(type x, type y) \
+    { \
+        const utype ux = (utype)x; \
+        const utype uy = (utype)y; \
+        const utype ur = ux - uy; \
+        const utype overflow = (is_signed) ? KARITH_PRIV_SIGN_BIT((ux ^ uy) & (ux ^ ur), type) : (utype)(ux < uy); \
+        const utype sat = (is_signed) ? (utype)(tmax) + KARITH_PRIV_SIGN_BIT(ux, type) : 0; \
+        \
+        return KARITH_PRIV_SAT_SELECT(type, utype, ur, sat, overflow); \
+    } \
+    \
+    static inline type __karith_priv_mul_sat_ ## suffix(type x, type y); \
+    static inline type __karith_priv_mul_sat_ ## suffix(type x, type y) \
+    { \
+        if (sizeof(type) < sizeof(uint64_t)) \
+        { \
+            /* 32-bit product is exact in 64 bits, so it is only clamped (cmov or min / max in vectors) */ \
+            const wtype p = (wtype)x * (wtype)y; \
+            const int64_t min64 = (int64_t)KARITH_PRIV_MIN_AS_U64(tmin, is_signed); \
+            wtype r = p > (wtype)(tmax) ? (wtype)(tmax) : p; \
+            r = (is_signed) && (int64_t)r < min64 ? (wtype)min64 : r; \
+            \
+            return (type)r; \
+        } \
+        \
+        const utype ux = (utype)x; \
+        const utype uy = (utype)y; \
+        const utype sat = (utype)(tmax) + ((is_signed) ? KARITH_PRIV_SIGN_BIT(ux ^ uy, type) : 0); \
+        type r; \
+        const bool overflow = KMUL_OVERFLOW(x, y, &r); \
+        \
+        return KARITH_PRIV_SAT_SELECT(type, utype, (utype)r, sat, overflow); \
+    } \
+    \
+    static inline void __karith_priv_add_sat_array_ ## suffix(type *dst, const type *a, const type *b, size_t n); \
+    static inline void __karith_priv_add_sat_array_ ## suffix(type *dst, const type *a, const type *b, size_t n) \
+    { \
+        for (size_t i = 0; i < n; ++i) \
+            dst[i] = __karith_priv_add_sat_ ## suffix(a[i], b[i]); \
+    } \
+    \
+    static inline void __karith_priv_sub_sat_array_ ## suffix(type *dst, const type *a, const type *b, size_t n); \
+    static inline void __karith_priv_sub_sat_array_ ## suffix(type *dst, const type *a, const type *b, size_t n) \
+    { \
+        for (size_t i = 0; i < n; ++i) \
+            dst[i] = __karith_priv_sub_sat_ ## suffix(a[i], b[i]); \
+    } \
+    \
+    static inline void __karith_priv_mul_sat_array_ ## suffix(type *dst, const type *a, const type *b, size_t n); \
+    static inline void __karith_priv_mul_sat_array_ ## suffix(type *dst, const type *a, const type *b, size_t n) \
+    { \
+        for (size_t i = 0; i < n; ++i) \
+            dst[i] = __karith_priv_mul_sat_ ## suffix(a[i], b[i]); \
+    }
+
+KARITH_PRIV_CREATE_SAT(int, unsigned int, int64_t, int, INT_MIN, INT_MAX, true)
+KARITH_PRIV_CREATE_SAT(unsigned int, unsigned int, uint64_t, unsigned_int, 0, UINT_MAX, false)
+KARITH_PRIV_CREATE_SAT(long, unsigned long, int64_t, long, LONG_MIN, LONG_MAX, true)
+KARITH_PRIV_CREATE_SAT(unsigned long, unsigned long, uint64_t, unsigned_long, 0, ULONG_MAX, false)
+KARITH_PRIV_CREATE_SAT(long long, unsigned long long, int64_t, long_long, LLONG_MIN, LLONG_MAX, true)
+KARITH_PRIV_CREATE_SAT(unsigned long long, unsigned long long, uint64_t, unsigned_long_long, 0, ULLONG_MAX, false)
+
+/* Type of x + y (after usual arithmetic conversions) chooses function */
+#define KARITH_PRIV_SAT(op, x, y) \
+    _Generic((x) + (y), \
+        int:                KCONCAT(KCONCAT(__karith_priv_, op), _sat_int), \
+        unsigned int:       KCONCAT(KCONCAT(__karith_priv_, op), _sat_unsigned_int), \
+        long:               KCONCAT(KCONCAT(__karith_priv_, op), _sat_long), \
+        unsigned long:      KCONCAT(KCONCAT(__karith_priv_, op), _sat_unsigned_long), \
+        long long:          KCONCAT(KCONCAT(__karith_priv_, op), _sat_long_long), \
+        unsigned long long: KCONCAT(KCONCAT(__karith_priv_, op), _sat_unsigned_long_long) \
+    )(x, y)
+
+#define KARITH_PRIV_SAT_ARRAY(op, dst, a, b, n) \
+    _Generic((dst), \
+        int *:                KCONCAT(KCONCAT(__karith_priv_, op), _sat_array_int), \
+        unsigned int *:       KCONCAT(KCONCAT(__karith_priv_, op), _sat_array_unsigned_int), \
+        long *:               KCONCAT(KCONCAT(__karith_priv_, op), _sat_array_long), \
+        unsigned long *:      KCONCAT(KCONCAT(__karith_priv_, op), _sat_array_unsigned_long), \
+        long long *:          KCONCAT(KCONCAT(__karith_priv_, op), _sat_array_long_long), \
+        unsigned long long *: KCONCAT(KCONCAT(__karith_priv_, op), _sat_array_unsigned_long_long) \
+    )(dst, a, b, n)
+
+#endif
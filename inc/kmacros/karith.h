@@ -0,0 +1,106 @@
+#ifndef KARITH_H
+#define KARITH_H
+
+/*
+    This is the private header for the KMacros.
+
+    This header constains arithmetic macros working on whole arrays
+
+    Do not include it directly
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE: GPL3
+*/
+
+#ifndef KMACROS_H
+#error "Never include <kmacros/karith.h> directly, use <kmacros/kmacros.h> instead."
+#endif
+
+#include "karith-priv.h"
+
+/**
+ * Sum of array with overflow detection.
+ * Result and overflow flag are the same as for chain of KADD_OVERFLOW(acc, arr[i], &acc) started from acc = 0,
+ * but overflow is checked once per block, so sum is computed by vectorized loop.
+ *
+ * Supported types (like in KADD_OVERFLOW): int, long, long long and unsigned versions
+ *
+ * @param[in] arr - array of n elements
+ * @param[in] n - number of elements
+ * @param[out] res - pointer to the result (sum mod 2^width when overflow occurs), type of *res chooses kernel
+ *
+ * @return true when overflow occurs, false otherwise
+ *
+ * Example
+ * long long bill[1000] = { ... };
+ * long long total;
+ * if (KSUM_OVERFLOW_ARRAY(bill, 1000, &total))
+ *     printf("Overflow\n");
+ */
+#define KSUM_OVERFLOW_ARRAY(arr, n, res)       KARITH_PRIV_SUM_OVERFLOW_ARRAY(arr, n, res)
+
+/**
+ * Dot product of 2 arrays with overflow detection.
+ * Result and overflow flag are the same as for chain of KMUL_OVERFLOW(a[i], b[i], &p) and KADD_OVERFLOW(acc, p, &acc)
+ * started from acc = 0, but overflow is checked once per block.
+ *
+ * Supported types (like in KMUL_OVERFLOW): int, long, long long and unsigned versions
+ *
+ * @param[in] a - array of n elements
+ * @param[in] b - array of n elements
+ * @param[in] n - number of elements
+ * @param[out] res - pointer to the result (dot mod 2^width when overflow occurs), type of *res chooses kernel
+ *
+ * @return true when overflow occurs, false otherwise
+ *
+ * Example
+ * unsigned int price[100] = { ... };
+ * unsigned int quantity[100] = { ... };
+ * unsigned int total;
+ * bool overflow = KDOT_OVERFLOW_ARRAY(price, quantity, 100, &total);
+ */
+#define KDOT_OVERFLOW_ARRAY(a, b, n, res)      KARITH_PRIV_DOT_OVERFLOW_ARRAY(a, b, n, res)
+
+/**
+ * Saturating addition, subtraction and multiplication (result is clamped to [min; max] of type instead of wrapping).
+ * Computed without branches.
+ *
+ * Supported types (like in K*_OVERFLOW): int, long, long long and unsigned versions,
+ * type of x + y (after usual arithmetic conversions) chooses function
+ *
+ * @param[in] x - first operand
+ * @param[in] y - second operand
+ *
+ * @return saturated x op y
+ *
+ * Example
+ * KADD_SAT(INT_MAX, 5)  == INT_MAX
+ * KSUB_SAT(2u, 5u)      == 0
+ * KMUL_SAT(INT_MIN, 2)  == INT_MIN
+ */
+#define KADD_SAT(x, y)                    KARITH_PRIV_SAT(add, x, y)
+#define KSUB_SAT(x, y)                    KARITH_PRIV_SAT(sub, x, y)
+#define KMUL_SAT(x, y)                    KARITH_PRIV_SAT(mul, x, y)
+
+/**
+ * Saturating operation on whole arrays: dst[i] = K*_SAT(a[i], b[i]).
+ * Loops are vectorized by compiler. dst can be the same array as a or b.
+ *
+ * Supported types: int, long, long long and unsigned versions, type of dst chooses kernel
+ *
+ * @param[out] dst - output array of n elements
+ * @param[in] a - array of n elements
+ * @param[in] b - array of n elements
+ * @param[in] n - number of elements
+ *
+ * Example
+ * int samples[256] = { ... };
+ * int gain[256] = { ... };
+ * KMUL_SAT_ARRAY(samples, samples, gain, 256);
+ */
+#define KADD_SAT_ARRAY(dst, a, b, n)      KARITH_PRIV_SAT_ARRAY(add, dst, a, b, n)
+#define KSUB_SAT_ARRAY(dst, a, b, n)      KARITH_PRIV_SAT_ARRAY(sub, dst, a, b, n)
+#define KMUL_SAT_ARRAY(dst, a, b, n)      KARITH_PRIV_SAT_ARRAY(mul, dst, a, b, n)
+
+#endif
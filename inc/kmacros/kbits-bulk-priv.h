@@ -0,0 +1,444 @@
+#ifndef KBITS_BULK_PRIV_H
+#define KBITS_BULK_PRIV_H
+
+/*
+    This is the private header for the Kbits.
+
+    This header constains bits kernels working on whole buffers (not single variables)
+    and unaligned endian accessors
+
+    Do not include it directly
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE: GPL3
+*/
+
+#ifndef KMACROS_H
+#error "Never include <kmacros/kbits-bulk-priv.h> directly, use <kmacros/kbits.h> instead."
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "kcompiler-detect.h"
+#include "kcompiler.h"
+
+#if defined(KCOMPILER_TARGET_SSSE3) || defined(KCOMPILER_TARGET_AVX2) || defined(KCOMPILER_TARGET_AVX512_VPOPCNTDQ)
+#include <immintrin.h>
+#endif
+
+/* Unaligned load, compiler replaces memcpy with single mov */
+static inline uint64_t __kbit_priv_load64(const uint8_t *ptr);
+static inline uint64_t __kbit_priv_load64(const uint8_t *ptr)
+{
+    uint64_t word;
+    (void)memcpy(&word, ptr, sizeof(word));
+
+    return word;
+}
+
+/*
+    Carry-save adder: h:l = a + b + c (bit by bit)
+    See: Harley-Seal popcount, "Faster Population Counts Using AVX2 Instructions" (W. Mula, N. Kurz, D. Lemire)
+*/
+static inline void __kbit_priv_csa64(uint64_t *h, uint64_t *l, uint64_t a, uint64_t b, uint64_t c);
+static inline void __kbit_priv_csa64(uint64_t *h, uint64_t *l, uint64_t a, uint64_t b, uint64_t c)
+{
+    const uint64_t u = a ^ b;
+
+    *h = (a & b) | (u & c);
+    *l = u ^ c;
+}
+
+/* Harley-Seal over 16 words, only 1 popcount per block, nwords % 16 words are not counted */
+static inline uint64_t __kbit_priv_popcount_harley_seal64(const uint8_t *ptr, size_t nwords);
+static inline uint64_t __kbit_priv_popcount_harley_seal64(const uint8_t *ptr, size_t nwords)
+{
+    uint64_t total = 0;
+    uint64_t ones = 0;
+    uint64_t twos = 0;
+    uint64_t fours = 0;
+    uint64_t eights = 0;
+    uint64_t sixteens;
+    uint64_t twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
+
+#define __KBIT_PRIV_W(i) __kbit_priv_load64(ptr + (i) * sizeof(uint64_t))
+
+    for (size_t i = 0; i + 16 <= nwords; i += 16, ptr += 16 * sizeof(uint64_t))
+    {
+        __kbit_priv_csa64(&twos_a, &ones, ones, __KBIT_PRIV_W(0), __KBIT_PRIV_W(1));
+        __kbit_priv_csa64(&twos_b, &ones, ones, __KBIT_PRIV_W(2), __KBIT_PRIV_W(3));
+        __kbit_priv_csa64(&fours_a, &twos, twos, twos_a, twos_b);
+        __kbit_priv_csa64(&twos_a, &ones, ones, __KBIT_PRIV_W(4), __KBIT_PRIV_W(5));
+        __kbit_priv_csa64(&twos_b, &ones, ones, __KBIT_PRIV_W(6), __KBIT_PRIV_W(7));
+        __kbit_priv_csa64(&fours_b, &twos, twos, twos_a, twos_b);
+        __kbit_priv_csa64(&eights_a, &fours, fours, fours_a, fours_b);
+        __kbit_priv_csa64(&twos_a, &ones, ones, __KBIT_PRIV_W(8), __KBIT_PRIV_W(9));
+        __kbit_priv_csa64(&twos_b, &ones, ones, __KBIT_PRIV_W(10), __KBIT_PRIV_W(11));
+        __kbit_priv_csa64(&fours_a, &twos, twos, twos_a, twos_b);
+        __kbit_priv_csa64(&twos_a, &ones, ones, __KBIT_PRIV_W(12), __KBIT_PRIV_W(13));
+        __kbit_priv_csa64(&twos_b, &ones, ones, __KBIT_PRIV_W(14), __KBIT_PRIV_W(15));
+        __kbit_priv_csa64(&fours_b, &twos, twos, twos_a, twos_b);
+        __kbit_priv_csa64(&eights_b, &fours, fours, fours_a, fours_b);
+        __kbit_priv_csa64(&sixteens, &eights, eights, eights_a, eights_b);
+
+        total += (uint64_t)KPOPCOUNTLL(sixteens);
+    }
+
+#undef __KBIT_PRIV_W
+
+    return 16 * total +
+           8 * (uint64_t)KPOPCOUNTLL(eights) +
+           4 * (uint64_t)KPOPCOUNTLL(fours) +
+           2 * (uint64_t)KPOPCOUNTLL(twos) +
+           (uint64_t)KPOPCOUNTLL(ones);
+}
+
+#if defined(KCOMPILER_TARGET_AVX2) || defined(KCOMPILER_TARGET_AVX512_VPOPCNTDQ)
+
+/* Sum of 4 64bit lanes */
+static inline uint64_t __kbit_priv_hsum256(__m256i v);
+static inline uint64_t __kbit_priv_hsum256(__m256i v)
+{
+    return (uint64_t)_mm256_extract_epi64(v, 0) +
+           (uint64_t)_mm256_extract_epi64(v, 1) +
+           (uint64_t)_mm256_extract_epi64(v, 2) +
+           (uint64_t)_mm256_extract_epi64(v, 3);
+}
+
+#endif
+
+#ifdef KCOMPILER_TARGET_AVX2
+
+static inline void __kbit_priv_csa256(__m256i *h, __m256i *l, __m256i a, __m256i b, __m256i c);
+static inline void __kbit_priv_csa256(__m256i *h, __m256i *l, __m256i a, __m256i b, __m256i c)
+{
+    const __m256i u = _mm256_xor_si256(a, b);
+
+    *h = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c));
+    *l = _mm256_xor_si256(u, c);
+}
+
+/* Popcount of every 64-bit lane, nibble lookup by pshufb (Mula) */
+static inline __m256i __kbit_priv_popcount256(__m256i v);
+static inline __m256i __kbit_priv_popcount256(__m256i v)
+{
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0F);
+    const __m256i lo = _mm256_and_si256(v, low_mask);
+    const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    const __m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+
+    return _mm256_sad_epu8(cnt, _mm256_setzero_si256());
+}
+
+/* Harley-Seal over 16 vectors (512 bytes), nvectors % 16 vectors are not counted */
+static inline uint64_t __kbit_priv_popcount_harley_seal256(const uint8_t *ptr, size_t nvectors);
+static inline uint64_t __kbit_priv_popcount_harley_seal256(const uint8_t *ptr, size_t nvectors)
+{
+    __m256i total = _mm256_setzero_si256();
+    __m256i ones = _mm256_setzero_si256();
+    __m256i twos = _mm256_setzero_si256();
+    __m256i fours = _mm256_setzero_si256();
+    __m256i eights = _mm256_setzero_si256();
+    __m256i sixteens;
+    __m256i twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
+
+#define __KBIT_PRIV_V(i) _mm256_loadu_si256((const __m256i *)(const void *)(ptr + (i) * sizeof(__m256i)))
+
+    for (size_t i = 0; i + 16 <= nvectors; i += 16, ptr += 16 * sizeof(__m256i))
+    {
+        __kbit_priv_csa256(&twos_a, &ones, ones, __KBIT_PRIV_V(0), __KBIT_PRIV_V(1));
+        __kbit_priv_csa256(&twos_b, &ones, ones, __KBIT_PRIV_V(2), __KBIT_PRIV_V(3));
+        __kbit_priv_csa256(&fours_a, &twos, twos, twos_a, twos_b);
+        __kbit_priv_csa256(&twos_a, &ones, ones, __KBIT_PRIV_V(4), __KBIT_PRIV_V(5));
+        __kbit_priv_csa256(&twos_b, &ones, ones, __KBIT_PRIV_V(6), __KBIT_PRIV_V(7));
+        __kbit_priv_csa256(&fours_b, &twos, twos, twos_a, twos_b);
+        __kbit_priv_csa256(&eights_a, &fours, fours, fours_a, fours_b);
+        __kbit_priv_csa256(&twos_a, &ones, ones, __KBIT_PRIV_V(8), __KBIT_PRIV_V(9));
+        __kbit_priv_csa256(&twos_b, &ones, ones, __KBIT_PRIV_V(10), __KBIT_PRIV_V(11));
+        __kbit_priv_csa256(&fours_a, &twos, twos, twos_a, twos_b);
+        __kbit_priv_csa256(&twos_a, &ones, ones, __KBIT_PRIV_V(12), __KBIT_PRIV_V(13));
+        __kbit_priv_csa256(&twos_b, &ones, ones, __KBIT_PRIV_V(14), __KBIT_PRIV_V(15));
+        __kbit_priv_csa256(&fours_b, &twos, twos, twos_a, twos_b);
+        __kbit_priv_csa256(&eights_b, &fours, fours, fours_a, fours_b);
+        __kbit_priv_csa256(&sixteens, &eights, eights, eights_a, eights_b);
+
+        total = _mm256_add_epi64(total, __kbit_priv_popcount256(sixteens));
+    }
+
+#undef __KBIT_PRIV_V
+
+    total = _mm256_slli_epi64(total, 4);
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(__kbit_priv_popcount256(eights), 3));
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(__kbit_priv_popcount256(fours), 2));
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(__kbit_priv_popcount256(twos), 1));
+    total = _mm256_add_epi64(total, __kbit_priv_popcount256(ones));
+
+    return __kbit_priv_hsum256(total);
+}
+
+#endif /* #ifdef KCOMPILER_TARGET_AVX2 */
+
+#ifdef KCOMPILER_TARGET_AVX512_VPOPCNTDQ
+
+/* Hardware popcount of 8 lanes at once, nvectors % 4 vectors are not counted */
+static inline uint64_t __kbit_priv_popcount512(const uint8_t *ptr, size_t nvectors);
+static inline uint64_t __kbit_priv_popcount512(const uint8_t *ptr, size_t nvectors)
+{
+    __m512i acc0 = _mm512_setzero_si512();
+    __m512i acc1 = _mm512_setzero_si512();
+    __m512i acc2 = _mm512_setzero_si512();
+    __m512i acc3 = _mm512_setzero_si512();
+
+    /* 4 accumulators to hide latency of vpopcntq */
+    for (size_t i = 0; i + 4 <= nvectors; i += 4, ptr += 4 * sizeof(__m512i))
+    {
+        acc0 = _mm512_add_epi64(acc0, _mm512_popcnt_epi64(_mm512_loadu_si512((const void *)(ptr + 0 * sizeof(__m512i)))));
+        acc1 = _mm512_add_epi64(acc1, _mm512_popcnt_epi64(_mm512_loadu_si512((const void *)(ptr + 1 * sizeof(__m512i)))));
+        acc2 = _mm512_add_epi64(acc2, _mm512_popcnt_epi64(_mm512_loadu_si512((const void *)(ptr + 2 * sizeof(__m512i)))));
+        acc3 = _mm512_add_epi64(acc3, _mm512_popcnt_epi64(_mm512_loadu_si512((const void *)(ptr + 3 * sizeof(__m512i)))));
+    }
+
+    acc0 = _mm512_add_epi64(_mm512_add_epi64(acc0, acc1), _mm512_add_epi64(acc2, acc3));
+
+    /*
+        Fold to 256 bits by hand. _mm512_reduce_add_epi64 and the unmasked extracts start from
+        _mm256_undefined_si256 and trigger -Wmaybe-uninitialized in gcc 12 headers, zero masked extracts do not
+    */
+    const __m256i lo = _mm512_maskz_extracti64x4_epi64(0xFF, acc0, 0);
+    const __m256i hi = _mm512_maskz_extracti64x4_epi64(0xFF, acc0, 1);
+
+    return __kbit_priv_hsum256(_mm256_add_epi64(lo, hi));
+}
+
+#endif /* #ifdef KCOMPILER_TARGET_AVX512_VPOPCNTDQ */
+
+static inline uint64_t __kbit_priv_popcount_buffer(const void *ptr, size_t nbytes);
+static inline uint64_t __kbit_priv_popcount_buffer(const void *ptr, size_t nbytes)
+{
+    const uint8_t *bytes = (const uint8_t *)ptr;
+    uint64_t total = 0;
+    size_t done;
+
+#if defined(KCOMPILER_TARGET_AVX512_VPOPCNTDQ)
+    done = (nbytes / (4 * sizeof(__m512i))) * (4 * sizeof(__m512i));
+    total += __kbit_priv_popcount512(bytes, done / sizeof(__m512i));
+    bytes += done;
+    nbytes -= done;
+#elif defined(KCOMPILER_TARGET_AVX2)
+    done = (nbytes / (16 * sizeof(__m256i))) * (16 * sizeof(__m256i));
+    total += __kbit_priv_popcount_harley_seal256(bytes, done / sizeof(__m256i));
+    bytes += done;
+    nbytes -= done;
+#elif !defined(KCOMPILER_TARGET_POPCNT)
+    /* Without popcount instruction every KPOPCOUNTLL is expensive, so reduce number of calls */
+    done = (nbytes / (16 * sizeof(uint64_t))) * (16 * sizeof(uint64_t));
+    total += __kbit_priv_popcount_harley_seal64(bytes, done / sizeof(uint64_t));
+    bytes += done;
+    nbytes -= done;
+#endif
+
+    /* Tail (or whole buffer when popcnt is available): word by word */
+    done = (nbytes / sizeof(uint64_t)) * sizeof(uint64_t);
+    for (size_t i = 0; i < done; i += sizeof(uint64_t))
+        total += (uint64_t)KPOPCOUNTLL(__kbit_priv_load64(bytes + i));
+
+    for (size_t i = done; i < nbytes; ++i)
+        total += (uint64_t)KPOPCOUNT((unsigned int)bytes[i]);
+
+    return total;
+}
+
+
+/*
+    Unaligned endian accessors.
+    When byte order is known: memcpy + bswap, so compiler emits single mov or movbe (-mmovbe)
+    When byte order is unknown: byte by byte composition
+*/
+#if defined(KCOMPILER_LITTLE_ENDIAN) || defined(KCOMPILER_BIG_ENDIAN)
+
+#ifdef KCOMPILER_LITTLE_ENDIAN
+#define __KBIT_PRIV_TO_LE(bits, x) (x)
+#define __KBIT_PRIV_TO_BE(bits, x) KBSWAP##bits(x)
+#else
+#define __KBIT_PRIV_TO_LE(bits, x) KBSWAP##bits(x)
+#define __KBIT_PRIV_TO_BE(bits, x) (x)
+#endif
+
+#define __KBIT_PRIV_ENDIAN_ACCESS_GEN(bits, order, ORDER) \
+    static inline uint##bits##_t __kbit_priv_load_##order##bits(const void *ptr); \
+    static inline uint##bits##_t __kbit_priv_load_##order##bits(const void *ptr) \
+    { \
+        uint##bits##_t val; \
+        (void)memcpy(&val, ptr, sizeof(val)); \
+        return (uint##bits##_t)__KBIT_PRIV_TO_##ORDER(bits, val); \
+    } \
+    static inline void __kbit_priv_store_##order##bits(void *ptr, uint##bits##_t val); \
+    static inline void __kbit_priv_store_##order##bits(void *ptr, uint##bits##_t val) \
+    { \
+        val = (uint##bits##_t)__KBIT_PRIV_TO_##ORDER(bits, val); \
+        (void)memcpy(ptr, &val, sizeof(val)); \
+    }
+
+#else /* #if defined(KCOMPILER_LITTLE_ENDIAN) || defined(KCOMPILER_BIG_ENDIAN) */
+
+/* Byte with index i (counted from memory start) has weight of (i)th or (n - 1 - i)th byte */
+#define __KBIT_PRIV_BYTE_SHIFT_LE(bits, i) (8 * (i))
+#define __KBIT_PRIV_BYTE_SHIFT_BE(bits, i) ((bits) - 8 - 8 * (i))
+
+#define __KBIT_PRIV_ENDIAN_ACCESS_GEN(bits, order, ORDER) \
+    static inline uint##bits##_t __kbit_priv_load_##order##bits(const void *ptr); \
+    static inline uint##bits##_t __kbit_priv_load_##order##bits(const void *ptr) \
+    { \
+        const uint8_t *bytes = (const uint8_t *)ptr; \
+        uint##bits##_t val = 0; \
+        for (unsigned int i = 0; i < sizeof(val); ++i) \
+            val = (uint##bits##_t)(val | ((uint##bits##_t)bytes[i] << __KBIT_PRIV_BYTE_SHIFT_##ORDER(bits, i))); \
+        return val; \
+    } \
+    static inline void __kbit_priv_store_##order##bits(void *ptr, uint##bits##_t val); \
+    static inline void __kbit_priv_store_##order##bits(void *ptr, uint##bits##_t val) \
+    { \
+        uint8_t *bytes = (uint8_t *)ptr; \
+        for (unsigned int i = 0; i < sizeof(val); ++i) \
+            bytes[i] = (uint8_t)(val >> __KBIT_PRIV_BYTE_SHIFT_##ORDER(bits, i)); \
+    }
+
+#endif /* #if defined(KCOMPILER_LITTLE_ENDIAN) || defined(KCOMPILER_BIG_ENDIAN) */
+
+__KBIT_PRIV_ENDIAN_ACCESS_GEN(16, le, LE)
+__KBIT_PRIV_ENDIAN_ACCESS_GEN(32, le, LE)
+__KBIT_PRIV_ENDIAN_ACCESS_GEN(64, le, LE)
+__KBIT_PRIV_ENDIAN_ACCESS_GEN(16, be, BE)
+__KBIT_PRIV_ENDIAN_ACCESS_GEN(32, be, BE)
+__KBIT_PRIV_ENDIAN_ACCESS_GEN(64, be, BE)
+
+/*
+    Byte swap of every element, dst == src is allowed (in place), other overlaps are not.
+    Buffers do not need to be aligned.
+*/
+static inline void __kbit_priv_bswap32_array(void *dst, const void *src, size_t n);
+static inline void __kbit_priv_bswap32_array(void *dst, const void *src, size_t n)
+{
+    uint8_t *d = (uint8_t *)dst;
+    const uint8_t *s = (const uint8_t *)src;
+    size_t i = 0;
+
+#ifdef KCOMPILER_TARGET_AVX2
+    const __m256i shuf256 = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                             3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m256i v = _mm256_loadu_si256((const __m256i *)(const void *)(s + i * sizeof(uint32_t)));
+        _mm256_storeu_si256((__m256i *)(void *)(d + i * sizeof(uint32_t)), _mm256_shuffle_epi8(v, shuf256));
+    }
+#endif
+
+#ifdef KCOMPILER_TARGET_SSSE3
+    const __m128i shuf128 = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i *)(const void *)(s + i * sizeof(uint32_t)));
+        _mm_storeu_si128((__m128i *)(void *)(d + i * sizeof(uint32_t)), _mm_shuffle_epi8(v, shuf128));
+    }
+#endif
+
+    for (; i < n; ++i)
+    {
+        uint32_t v;
+        (void)memcpy(&v, s + i * sizeof(v), sizeof(v));
+        v = KBSWAP32(v);
+        (void)memcpy(d + i * sizeof(v), &v, sizeof(v));
+    }
+}
+
+static inline void __kbit_priv_bswap64_array(void *dst, const void *src, size_t n);
+static inline void __kbit_priv_bswap64_array(void *dst, const void *src, size_t n)
+{
+    uint8_t *d = (uint8_t *)dst;
+    const uint8_t *s = (const uint8_t *)src;
+    size_t i = 0;
+
+#ifdef KCOMPILER_TARGET_AVX2
+    const __m256i shuf256 = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                             7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m256i v = _mm256_loadu_si256((const __m256i *)(const void *)(s + i * sizeof(uint64_t)));
+        _mm256_storeu_si256((__m256i *)(void *)(d + i * sizeof(uint64_t)), _mm256_shuffle_epi8(v, shuf256));
+    }
+#endif
+
+#ifdef KCOMPILER_TARGET_SSSE3
+    const __m128i shuf128 = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+
+    for (; i + 2 <= n; i += 2)
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i *)(const void *)(s + i * sizeof(uint64_t)));
+        _mm_storeu_si128((__m128i *)(void *)(d + i * sizeof(uint64_t)), _mm_shuffle_epi8(v, shuf128));
+    }
+#endif
+
+    for (; i < n; ++i)
+    {
+        uint64_t v;
+        (void)memcpy(&v, s + i * sizeof(v), sizeof(v));
+        v = KBSWAP64(v);
+        (void)memcpy(d + i * sizeof(v), &v, sizeof(v));
+    }
+}
+
+
+/* Swap 2 not overlapping memory blocks, size is known in compile time in most cases, so memcpy is inlined */
+static inline void __kbit_priv_swap_bytes(uint8_t *a, uint8_t *b, size_t size);
+static inline void __kbit_priv_swap_bytes(uint8_t *a, uint8_t *b, size_t size)
+{
+    uint8_t tmp[64];
+
+    while (size > 0)
+    {
+        const size_t chunk = size < sizeof(tmp) ? size : sizeof(tmp);
+
+        (void)memcpy(tmp, a, chunk);
+        (void)memcpy(a, b, chunk);
+        (void)memcpy(b, tmp, chunk);
+
+        a += chunk;
+        b += chunk;
+        size -= chunk;
+    }
+}
+
+/*
+    Bit reversal permutation (FFT order) of n elements, n has to be a power of 2.
+    Reversed index is computed in constant time by KBITREVERSE64, every pair is swapped once.
+*/
+static inline void __kbit_priv_reverse_array(void *arr, size_t n, size_t size);
+static inline void __kbit_priv_reverse_array(void *arr, size_t n, size_t size)
+{
+    uint8_t *bytes = (uint8_t *)arr;
+
+    if (n < 2)
+        return;
+
+    /* 64 - log2(n) */
+    const unsigned int shift = (unsigned int)KCLZLL((unsigned long long)n) + 1;
+
+    /* first and last elements are always in place */
+    for (size_t i = 1; i < n - 1; ++i)
+    {
+        const size_t j = (size_t)(KBITREVERSE64((uint64_t)i) >> shift);
+
+        if (i < j)
+            __kbit_priv_swap_bytes(bytes + i * size, bytes + j * size, size);
+    }
+}
+
+#endif
@@ -18,12 +18,18 @@
 #endif
 
 #include <stddef.h>
+#include <stdint.h>
 #include <limits.h>
 
 #include "kcompiler-detect.h"
 #include "kcompiler.h"
 
-#define KMASK_PRIV(s, e, type)           ((type)(((1ull << ((e) - (s) + 1)) - 1) << (s)))
+#ifdef KCOMPILER_TARGET_BMI2
+#include <immintrin.h>
+#endif
+
+/* All ones shifted right, so mask of full 64 bits does not need shift by 64 */
+#define KMASK_PRIV(s, e, type)           ((type)((~0ull >> (63 - ((e) - (s)))) << (s)))
 #define KMASK_PRIV_GET(n, s, e, type)    ((type)(((n) & (KMASK_PRIV(s, e, type))) >> s))
 #define KMASK_PRIV_SET(n, s, e, type)    ((type)((n) | (KMASK_PRIV(s, e, type))))
 #define KMASK_PRIV_CLEAR(n, s, e, type)  ((type)((n) & ~(KMASK_PRIV(s, e, type))))
@@ -164,20 +170,27 @@ KMASK_PRIV_CREATE_FUNCTION_TYPE(TOGGLE, unsigned long long, unsigned_long_long)
 
 #endif
 
+/*
+    Reverse is constant time: KBITREVERSE (swap network or clang builtin) on 32 or 64 bits
+    and then shift to drop bits which are not a part of type (or leading zeros for significant version).
+    n | 1 does not change clz for n != 0 and protects clz from 0 (reverse of 0 is 0 anyway).
+*/
 #define KBIT_PRIV_CREATE_FUNCTION_REVERSE_SIGNIFICANT_BITS_TYPE(rettype, type, suffix) \
     static inline rettype __kbit_priv_function_type_reverse_significant_ ## suffix(type n); \
     static inline rettype __kbit_priv_function_type_reverse_significant_ ## suffix(type n) \
     { \
-        type reversed = 0; \
-        \
-        while (n > 0) \
+        if (sizeof(type) <= sizeof(uint32_t)) \
+        { \
+            const uint32_t x = (uint32_t)n; \
+            const uint32_t reversed = KBITREVERSE32(x) >> KCLZ(x | 1u); \
+            return (rettype)reversed; \
+        } \
+        else \
         { \
-            reversed = (type)(reversed << 1); \
-            if (n & 1) \
-                reversed ^= 1; \
-            n >>= 1; \
+            const uint64_t x = (uint64_t)n; \
+            const uint64_t reversed = KBITREVERSE64(x) >> KCLZLL(x | 1u); \
+            return (rettype)reversed; \
         } \
-        return (rettype)reversed; \
     }
 
 KBIT_PRIV_CREATE_FUNCTION_REVERSE_SIGNIFICANT_BITS_TYPE(char, unsigned char, char)
@@ -211,14 +224,17 @@ KBIT_PRIV_CREATE_FUNCTION_REVERSE_SIGNIFICANT_BITS_TYPE(unsigned long long, unsi
     static inline rettype __kbit_priv_function_type_reverse_ ## suffix(type n); \
     static inline rettype __kbit_priv_function_type_reverse_ ## suffix(type n) \
     { \
-        type reversed = 0; \
-        \
-        for (size_t i = 0; i < sizeof(n) * CHAR_BIT; ++i) \
+        if (sizeof(type) <= sizeof(uint32_t)) \
         { \
-            reversed = (type)((reversed << 1) | (n & 1)); \
-            n >>= 1; \
+            /* & 31 only to silence shift warning in dead branch of 64-bit types */ \
+            const uint32_t reversed = KBITREVERSE32((uint32_t)n) >> (((sizeof(uint32_t) - sizeof(type)) * CHAR_BIT) & 31); \
+            return (rettype)reversed; \
+        } \
+        else \
+        { \
+            const uint64_t reversed = KBITREVERSE64((uint64_t)n) >> ((sizeof(uint64_t) - sizeof(type)) * CHAR_BIT); \
+            return (rettype)reversed; \
         } \
-        return (rettype)reversed; \
     }
 
 KBIT_PRIV_CREATE_FUNCTION_REVERSE_BITS_TYPE(char, unsigned char, char)
@@ -311,4 +327,134 @@ KBIT_PRIV_CREATE_FUNCTION_REVERSE_BITS_TYPE(unsigned long long, unsigned long lo
         unsigned long long: KPARITYLL((unsigned long long)n) \
     )
 
+
+/*
+    Bit gather (extract) and scatter (deposit).
+    BMI2: single pext / pdep instruction
+    Fallback: loop over set bits of mask, so cost depends on popcount(mask) not on type width
+*/
+static inline uint32_t __kbit_priv_extract32(uint32_t n, uint32_t mask);
+static inline uint32_t __kbit_priv_extract32(uint32_t n, uint32_t mask)
+{
+#ifdef KCOMPILER_TARGET_BMI2
+    return _pext_u32(n, mask);
+#else
+    uint32_t res = 0;
+
+    for (uint32_t bit = 1; mask != 0; bit <<= 1)
+    {
+        /* branchless, result of test is not predictable */
+        res |= bit & (0u - (uint32_t)((n & mask & (0u - mask)) != 0));
+        mask &= mask - 1;
+    }
+
+    return res;
+#endif
+}
+
+static inline uint64_t __kbit_priv_extract64(uint64_t n, uint64_t mask);
+static inline uint64_t __kbit_priv_extract64(uint64_t n, uint64_t mask)
+{
+#if defined(KCOMPILER_TARGET_BMI2) && defined(KCOMPILER_TARGET_X86_64)
+    return (uint64_t)_pext_u64(n, mask);
+#else
+    uint64_t res = 0;
+
+    for (uint64_t bit = 1; mask != 0; bit <<= 1)
+    {
+        /* branchless, result of test is not predictable */
+        res |= bit & (0ull - (uint64_t)((n & mask & (0ull - mask)) != 0));
+        mask &= mask - 1;
+    }
+
+    return res;
+#endif
+}
+
+static inline uint32_t __kbit_priv_deposit32(uint32_t n, uint32_t mask);
+static inline uint32_t __kbit_priv_deposit32(uint32_t n, uint32_t mask)
+{
+#ifdef KCOMPILER_TARGET_BMI2
+    return _pdep_u32(n, mask);
+#else
+    uint32_t res = 0;
+
+    for (uint32_t bit = 1; mask != 0; bit <<= 1)
+    {
+        res |= mask & (0u - mask) & (0u - (uint32_t)((n & bit) != 0));
+        mask &= mask - 1;
+    }
+
+    return res;
+#endif
+}
+
+static inline uint64_t __kbit_priv_deposit64(uint64_t n, uint64_t mask);
+static inline uint64_t __kbit_priv_deposit64(uint64_t n, uint64_t mask)
+{
+#if defined(KCOMPILER_TARGET_BMI2) && defined(KCOMPILER_TARGET_X86_64)
+    return (uint64_t)_pdep_u64(n, mask);
+#else
+    uint64_t res = 0;
+
+    for (uint64_t bit = 1; mask != 0; bit <<= 1)
+    {
+        res |= mask & (0ull - mask) & (0ull - (uint64_t)((n & bit) != 0));
+        mask &= mask - 1;
+    }
+
+    return res;
+#endif
+}
+
+#define KBIT_PRIV_CREATE_FUNCTION_EXTRACT_DEPOSIT_TYPE(name, rettype, type, suffix) \
+    static inline rettype __kbit_priv_function_type_ ## name ## _ ## suffix(type n, type mask); \
+    static inline rettype __kbit_priv_function_type_ ## name ## _ ## suffix(type n, type mask) \
+    { \
+        if (sizeof(type) <= sizeof(uint32_t)) \
+        { \
+            const uint32_t res = __kbit_priv_ ## name ## 32((uint32_t)n, (uint32_t)mask); \
+            return (rettype)res; \
+        } \
+        else \
+        { \
+            const uint64_t res = __kbit_priv_ ## name ## 64((uint64_t)n, (uint64_t)mask); \
+            return (rettype)res; \
+        } \
+    }
+
+KBIT_PRIV_CREATE_FUNCTION_EXTRACT_DEPOSIT_TYPE(extract, int, unsigned int, int)
+KBIT_PRIV_CREATE_FUNCTION_EXTRACT_DEPOSIT_TYPE(extract, unsigned int, unsigned int, unsigned_int)
+KBIT_PRIV_CREATE_FUNCTION_EXTRACT_DEPOSIT_TYPE(extract, long, unsigned long, long)
+KBIT_PRIV_CREATE_FUNCTION_EXTRACT_DEPOSIT_TYPE(extract, unsigned long, unsigned long, unsigned_long)
+KBIT_PRIV_CREATE_FUNCTION_EXTRACT_DEPOSIT_TYPE(extract, long long, unsigned long long, long_long)
+KBIT_PRIV_CREATE_FUNCTION_EXTRACT_DEPOSIT_TYPE(extract, unsigned long long, unsigned long long, unsigned_long_long)
+
+KBIT_PRIV_CREATE_FUNCTION_EXTRACT_DEPOSIT_TYPE(deposit, int, unsigned int, int)
+KBIT_PRIV_CREATE_FUNCTION_EXTRACT_DEPOSIT_TYPE(deposit, unsigned int, unsigned int, unsigned_int)
+KBIT_PRIV_CREATE_FUNCTION_EXTRACT_DEPOSIT_TYPE(deposit, long, unsigned long, long)
+KBIT_PRIV_CREATE_FUNCTION_EXTRACT_DEPOSIT_TYPE(deposit, unsigned long, unsigned long, unsigned_long)
+KBIT_PRIV_CREATE_FUNCTION_EXTRACT_DEPOSIT_TYPE(deposit, long long, unsigned long long, long_long)
+KBIT_PRIV_CREATE_FUNCTION_EXTRACT_DEPOSIT_TYPE(deposit, unsigned long long, unsigned long long, unsigned_long_long)
+
+#define KBIT_PRIV_TYPE_EXTRACT(n, mask) \
+    _Generic((n), \
+        int:                __kbit_priv_function_type_extract_int((unsigned int)(n), (unsigned int)(mask)), \
+        unsigned int:       __kbit_priv_function_type_extract_unsigned_int((unsigned int)(n), (unsigned int)(mask)), \
+        long:               __kbit_priv_function_type_extract_long((unsigned long)(n), (unsigned long)(mask)), \
+        unsigned long:      __kbit_priv_function_type_extract_unsigned_long((unsigned long)(n), (unsigned long)(mask)), \
+        long long:          __kbit_priv_function_type_extract_long_long((unsigned long long)(n), (unsigned long long)(mask)), \
+        unsigned long long: __kbit_priv_function_type_extract_unsigned_long_long((unsigned long long)(n), (unsigned long long)(mask)) \
+    )
+
+#define KBIT_PRIV_TYPE_DEPOSIT(n, mask) \
+    _Generic((n), \
+        int:                __kbit_priv_function_type_deposit_int((unsigned int)(n), (unsigned int)(mask)), \
+        unsigned int:       __kbit_priv_function_type_deposit_unsigned_int((unsigned int)(n), (unsigned int)(mask)), \
+        long:               __kbit_priv_function_type_deposit_long((unsigned long)(n), (unsigned long)(mask)), \
+        unsigned long:      __kbit_priv_function_type_deposit_unsigned_long((unsigned long)(n), (unsigned long)(mask)), \
+        long long:          __kbit_priv_function_type_deposit_long_long((unsigned long long)(n), (unsigned long long)(mask)), \
+        unsigned long long: __kbit_priv_function_type_deposit_unsigned_long_long((unsigned long long)(n), (unsigned long long)(mask)) \
+    )
+
 #endif
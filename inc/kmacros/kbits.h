@@ -18,9 +18,11 @@
 #endif
 
 #include "kbits-priv.h"
+#include "kbits-bulk-priv.h"
 
 /**
- * Macro creates mask for at most long long type
+ * Macro creates mask for at most long long type.
+ * For constant s and e it is an integer constant expression (can be used in case labels, array sizes)
  *
  * @param[in] s - start pos of mask (first bit from right has pos 0)
  * @param[in] e - end pos of mask (last bit from right has pos sizeof(type) * CHAR_BIT - 1)
@@ -187,6 +189,19 @@
  */
 #define KBIT_REVERSE(n)                   KBIT_PRIV_TYPE_REVERSE(n)
 
+/**
+ * Bit reversal permutation of array (i.e. input / output order of radix-2 FFT).
+ * Element with index i is swapped with element with index KBIT_REVERSE(i) on log2(n) bits.
+ *
+ * @param[in, out] arr - array (not pointer to void)
+ * @param[in] n - number of elements, has to be a power of 2
+ *
+ * Example
+ * int t[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+ * KBIT_REVERSE_ARRAY(t, 8); // t = {0, 4, 2, 6, 1, 5, 3, 7}
+ */
+#define KBIT_REVERSE_ARRAY(arr, n)        __kbit_priv_reverse_array(arr, n, sizeof(*(arr)))
+
 /**
  * Returns one plus the index of the least significant 1-bit of n, or if n is zero, returns zero.
  */
@@ -220,4 +235,124 @@
  */
 #define KBIT_PARITY(n)                    KBIT_PRIV_TYPE_PARITY(n)
 
+/**
+ * Gather bits of n selected by mask and pack them into low bits of result (parallel bits extract).
+ * Generalization of KMASK_GET for not contiguous masks.
+ *
+ * With BMI2 (i.e -mbmi2 or -march=native) it is a single pext instruction,
+ * otherwise loop over set bits of mask.
+ *
+ * @param[in] n - number
+ * @param[in] mask - bits to gather
+ *
+ * @return gathered bits, result has the same type as n
+ *
+ * Example
+ * unsigned int a = 0xB4;                   // 1011 0100
+ * unsigned int b = KBIT_EXTRACT(a, 0xF0u); // 1011 (same as KMASK_GET(a, 4, 7))
+ * unsigned int c = KBIT_EXTRACT(a, 0x55u); // bits 0, 2, 4, 6 of a = 0110
+ */
+#define KBIT_EXTRACT(n, mask)             KBIT_PRIV_TYPE_EXTRACT(n, mask)
+
+/**
+ * Scatter low bits of n to positions of set bits in mask (parallel bits deposit).
+ * Inverse of KBIT_EXTRACT: KBIT_DEPOSIT(KBIT_EXTRACT(n, mask), mask) == n & mask
+ *
+ * With BMI2 (i.e -mbmi2 or -march=native) it is a single pdep instruction,
+ * otherwise loop over set bits of mask.
+ *
+ * @param[in] n - number
+ * @param[in] mask - target positions
+ *
+ * @return scattered bits, result has the same type as n
+ *
+ * Example
+ * // Morton code (Z-order) of 32-bit x and y
+ * uint64_t z = KBIT_DEPOSIT((uint64_t)x, 0x5555555555555555ull) | KBIT_DEPOSIT((uint64_t)y, 0xAAAAAAAAAAAAAAAAull);
+ */
+#define KBIT_DEPOSIT(n, mask)             KBIT_PRIV_TYPE_DEPOSIT(n, mask)
+
+/**
+ * Returns the number of 1-bits in whole buffer.
+ * Buffer does not need to be aligned.
+ *
+ * Kernel is chosen in compile time:
+ * AVX512 VPOPCNTDQ -> AVX2 Harley-Seal (pshufb nibble lookup) -> popcnt per word -> scalar Harley-Seal
+ *
+ * @param[in] ptr - pointer to the buffer
+ * @param[in] nbytes - size of the buffer in bytes
+ *
+ * @return number of 1-bits as uint64_t
+ *
+ * Example
+ * uint64_t t[128] = { ... };
+ * uint64_t ones = KPOPCOUNT_BUFFER(t, sizeof(t));
+ */
+#define KPOPCOUNT_BUFFER(ptr, nbytes)     __kbit_priv_popcount_buffer(ptr, nbytes)
+
+/**
+ * Swap bytes of every element from src and write them to dst.
+ * Buffers do not need to be aligned. dst == src is allowed, other overlaps are not.
+ *
+ * Kernel is chosen in compile time: AVX2 shuffle -> SSSE3 pshufb -> KBSWAP per element (tail)
+ *
+ * @param[out] dst - destination buffer (n elements)
+ * @param[in] src - source buffer (n elements)
+ * @param[in] n - number of elements (not bytes)
+ *
+ * Example
+ * uint32_t net[64] = { ... };
+ * uint32_t host[64];
+ * KBSWAP32_ARRAY(host, net, 64);
+ */
+#define KBSWAP32_ARRAY(dst, src, n)       __kbit_priv_bswap32_array(dst, src, n)
+#define KBSWAP64_ARRAY(dst, src, n)       __kbit_priv_bswap64_array(dst, src, n)
+
+/**
+ * Swap bytes of every element in place
+ *
+ * @param[in, out] arr - buffer (n elements)
+ * @param[in] n - number of elements (not bytes)
+ */
+#define KBSWAP32_ARRAY_INPLACE(arr, n)    __kbit_priv_bswap32_array(arr, arr, n)
+#define KBSWAP64_ARRAY_INPLACE(arr, n)    __kbit_priv_bswap64_array(arr, arr, n)
+
+/**
+ * Load big / little endian value from memory to host byte order.
+ * Pointer does not need to be aligned.
+ * When target has movbe (i.e -mmovbe or -march=native) load + bswap is a single movbe.
+ *
+ * @param[in] ptr - pointer to the value in memory
+ *
+ * @return value in host byte order
+ *
+ * Example
+ * const uint8_t *packet = ...;
+ * uint32_t len = KLOAD_BE32(&packet[2]);
+ */
+#define KLOAD_BE16(ptr)                   __kbit_priv_load_be16(ptr)
+#define KLOAD_BE32(ptr)                   __kbit_priv_load_be32(ptr)
+#define KLOAD_BE64(ptr)                   __kbit_priv_load_be64(ptr)
+#define KLOAD_LE16(ptr)                   __kbit_priv_load_le16(ptr)
+#define KLOAD_LE32(ptr)                   __kbit_priv_load_le32(ptr)
+#define KLOAD_LE64(ptr)                   __kbit_priv_load_le64(ptr)
+
+/**
+ * Store value in host byte order to memory as big / little endian.
+ * Pointer does not need to be aligned.
+ *
+ * @param[out] ptr - pointer to the memory
+ * @param[in] val - value in host byte order
+ *
+ * Example
+ * uint8_t header[8];
+ * KSTORE_LE64(header, size);
+ */
+#define KSTORE_BE16(ptr, val)             __kbit_priv_store_be16(ptr, val)
+#define KSTORE_BE32(ptr, val)             __kbit_priv_store_be32(ptr, val)
+#define KSTORE_BE64(ptr, val)             __kbit_priv_store_be64(ptr, val)
+#define KSTORE_LE16(ptr, val)             __kbit_priv_store_le16(ptr, val)
+#define KSTORE_LE32(ptr, val)             __kbit_priv_store_le32(ptr, val)
+#define KSTORE_LE64(ptr, val)             __kbit_priv_store_le64(ptr, val)
+
 #endif
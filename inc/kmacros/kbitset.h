@@ -0,0 +1,392 @@
+#ifndef KBITSET_H
+#define KBITSET_H
+
+/*
+    This is the public header for the KBitset.
+
+    KBitset is a multi-word bitmap backed by 64-bit words.
+    Bulk operations are simple loops over words, so compiler can vectorize them.
+    Bits from last word beyond nbits are always '0', so bulk operations do not need masking.
+
+    Include it directly: #include <kmacros/kbitset.h>
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE: GPL3
+*/
+
+#include "kmacros.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KBITSET_WORD_BITS                 64
+#define KBITSET_WORD_INDEX(bit)           ((bit) / KBITSET_WORD_BITS)
+#define KBITSET_BIT_INDEX(bit)            ((bit) % KBITSET_WORD_BITS)
+#define KBITSET_WORDS(nbits)              (((nbits) + KBITSET_WORD_BITS - 1) / KBITSET_WORD_BITS)
+
+typedef struct kbitset
+{
+    size_t   nbits;
+    size_t   nwords;
+    uint64_t words[];
+} kbitset_t;
+
+/* Use kbitset_iter_next or KBITSET_FOR_EACH_SET to iterate over set bits */
+typedef struct kbitset_iter
+{
+    const kbitset_t *bs;
+    size_t           word_index;
+    uint64_t         word;
+} kbitset_iter_t;
+
+/**
+ * Iterate over every set bit in increasing order
+ *
+ * @param[in] bs - pointer to bitset
+ * @param[out] idx - size_t variable, in loop body it contains index of set bit
+ *
+ * Example:
+ * size_t i;
+ * KBITSET_FOR_EACH_SET(bs, i)
+ *     printf("%zu\n", i);
+ */
+#define KBITSET_FOR_EACH_SET(bs, idx) \
+    for (kbitset_iter_t KVAR_ALMOST_UNIQUE_NAME(kbitset_iter) = kbitset_iter_init(bs); \
+         kbitset_iter_next(&KVAR_ALMOST_UNIQUE_NAME(kbitset_iter), &(idx)); )
+
+static inline kbitset_t *kbitset_create(size_t nbits);
+static inline void kbitset_destroy(kbitset_t *bs);
+
+static inline void kbitset_set(kbitset_t *bs, size_t bit);
+static inline void kbitset_clear(kbitset_t *bs, size_t bit);
+static inline void kbitset_toggle(kbitset_t *bs, size_t bit);
+static inline bool kbitset_test(const kbitset_t *bs, size_t bit);
+
+static inline void kbitset_set_range(kbitset_t *bs, size_t s, size_t e);
+static inline void kbitset_clear_range(kbitset_t *bs, size_t s, size_t e);
+static inline bool kbitset_test_range_all(const kbitset_t *bs, size_t s, size_t e);
+static inline bool kbitset_test_range_any(const kbitset_t *bs, size_t s, size_t e);
+
+static inline void kbitset_set_all(kbitset_t *bs);
+static inline void kbitset_clear_all(kbitset_t *bs);
+
+static inline bool kbitset_and(kbitset_t *dst, const kbitset_t *src);
+static inline bool kbitset_or(kbitset_t *dst, const kbitset_t *src);
+static inline bool kbitset_xor(kbitset_t *dst, const kbitset_t *src);
+static inline bool kbitset_andnot(kbitset_t *dst, const kbitset_t *src);
+
+static inline size_t kbitset_popcount(const kbitset_t *bs);
+static inline size_t kbitset_find_next_set(const kbitset_t *bs, size_t from);
+static inline size_t kbitset_find_next_clear(const kbitset_t *bs, size_t from);
+
+static inline kbitset_iter_t kbitset_iter_init(const kbitset_t *bs);
+static inline bool kbitset_iter_next(kbitset_iter_t *it, size_t *bit);
+
+/* Private helpers, do not use */
+static inline uint64_t __kbitset_mask_from(size_t bit);
+static inline uint64_t __kbitset_mask_to(size_t bit);
+static inline uint64_t __kbitset_tail_mask(const kbitset_t *bs);
+
+static inline uint64_t __kbitset_mask_from(size_t bit)
+{
+    /* '1' on positions [bit % 64; 63] */
+    return ~UINT64_C(0) << KBITSET_BIT_INDEX(bit);
+}
+
+static inline uint64_t __kbitset_mask_to(size_t bit)
+{
+    /* '1' on positions [0; bit % 64] */
+    return ~UINT64_C(0) >> (KBITSET_WORD_BITS - 1 - KBITSET_BIT_INDEX(bit));
+}
+
+static inline uint64_t __kbitset_tail_mask(const kbitset_t *bs)
+{
+    return bs->nbits % KBITSET_WORD_BITS == 0 ? ~UINT64_C(0) : __kbitset_mask_to(bs->nbits - 1);
+}
+
+/**
+ * Create bitset with nbits bits, all bits are cleared
+ *
+ * @param[in] nbits - number of bits
+ *
+ * @return new bitset or NULL on failure
+ */
+static inline kbitset_t *kbitset_create(size_t nbits)
+{
+    const size_t nwords = KBITSET_WORDS(nbits);
+    kbitset_t *bs = calloc(1, sizeof(*bs) + nwords * sizeof(bs->words[0]));
+    if (bs == NULL)
+        return NULL;
+
+    bs->nbits = nbits;
+    bs->nwords = nwords;
+
+    return bs;
+}
+
+/**
+ * Destroy bitset created by kbitset_create
+ */
+static inline void kbitset_destroy(kbitset_t *bs)
+{
+    free(bs);
+}
+
+/**
+ * Single bit operations, valid bit is [0; nbits - 1]
+ */
+static inline void kbitset_set(kbitset_t *bs, size_t bit)
+{
+    bs->words[KBITSET_WORD_INDEX(bit)] |= UINT64_C(1) << KBITSET_BIT_INDEX(bit);
+}
+
+static inline void kbitset_clear(kbitset_t *bs, size_t bit)
+{
+    bs->words[KBITSET_WORD_INDEX(bit)] &= ~(UINT64_C(1) << KBITSET_BIT_INDEX(bit));
+}
+
+static inline void kbitset_toggle(kbitset_t *bs, size_t bit)
+{
+    bs->words[KBITSET_WORD_INDEX(bit)] ^= UINT64_C(1) << KBITSET_BIT_INDEX(bit);
+}
+
+static inline bool kbitset_test(const kbitset_t *bs, size_t bit)
+{
+    return KCAST_TO_BOOL(bs->words[KBITSET_WORD_INDEX(bit)] & (UINT64_C(1) << KBITSET_BIT_INDEX(bit)));
+}
+
+/**
+ * Range operations on bits [s; e], valid range is 0 <= s <= e <= nbits - 1
+ */
+static inline void kbitset_set_range(kbitset_t *bs, size_t s, size_t e)
+{
+    const size_t first = KBITSET_WORD_INDEX(s);
+    const size_t last = KBITSET_WORD_INDEX(e);
+
+    if (first == last)
+    {
+        bs->words[first] |= __kbitset_mask_from(s) & __kbitset_mask_to(e);
+        return;
+    }
+
+    bs->words[first] |= __kbitset_mask_from(s);
+    for (size_t i = first + 1; i < last; ++i)
+        bs->words[i] = ~UINT64_C(0);
+    bs->words[last] |= __kbitset_mask_to(e);
+}
+
+static inline void kbitset_clear_range(kbitset_t *bs, size_t s, size_t e)
+{
+    const size_t first = KBITSET_WORD_INDEX(s);
+    const size_t last = KBITSET_WORD_INDEX(e);
+
+    if (first == last)
+    {
+        bs->words[first] &= ~(__kbitset_mask_from(s) & __kbitset_mask_to(e));
+        return;
+    }
+
+    bs->words[first] &= ~__kbitset_mask_from(s);
+    for (size_t i = first + 1; i < last; ++i)
+        bs->words[i] = 0;
+    bs->words[last] &= ~__kbitset_mask_to(e);
+}
+
+/**
+ * Returns true if all bits from [s; e] are set
+ */
+static inline bool kbitset_test_range_all(const kbitset_t *bs, size_t s, size_t e)
+{
+    const size_t first = KBITSET_WORD_INDEX(s);
+    const size_t last = KBITSET_WORD_INDEX(e);
+
+    if (first == last)
+    {
+        const uint64_t mask = __kbitset_mask_from(s) & __kbitset_mask_to(e);
+        return (bs->words[first] & mask) == mask;
+    }
+
+    uint64_t acc = bs->words[first] | ~__kbitset_mask_from(s);
+    for (size_t i = first + 1; i < last; ++i)
+        acc &= bs->words[i];
+    acc &= bs->words[last] | ~__kbitset_mask_to(e);
+
+    return acc == ~UINT64_C(0);
+}
+
+/**
+ * Returns true if at least one bit from [s; e] is set
+ */
+static inline bool kbitset_test_range_any(const kbitset_t *bs, size_t s, size_t e)
+{
+    const size_t first = KBITSET_WORD_INDEX(s);
+    const size_t last = KBITSET_WORD_INDEX(e);
+
+    if (first == last)
+        return KCAST_TO_BOOL(bs->words[first] & __kbitset_mask_from(s) & __kbitset_mask_to(e));
+
+    uint64_t acc = bs->words[first] & __kbitset_mask_from(s);
+    for (size_t i = first + 1; i < last; ++i)
+        acc |= bs->words[i];
+    acc |= bs->words[last] & __kbitset_mask_to(e);
+
+    return acc != 0;
+}
+
+static inline void kbitset_set_all(kbitset_t *bs)
+{
+    if (bs->nwords == 0)
+        return;
+
+    (void)memset(bs->words, 0xFF, bs->nwords * sizeof(bs->words[0]));
+    bs->words[bs->nwords - 1] &= __kbitset_tail_mask(bs);
+}
+
+static inline void kbitset_clear_all(kbitset_t *bs)
+{
+    (void)memset(bs->words, 0, bs->nwords * sizeof(bs->words[0]));
+}
+
+/**
+ * Whole set operations: dst = dst op src, dst and src can be the same bitset
+ *
+ * @return false when bitsets have different sizes (dst is not modified), true otherwise
+ */
+static inline bool kbitset_and(kbitset_t *dst, const kbitset_t *src)
+{
+    if (dst->nbits != src->nbits)
+        return false;
+
+    for (size_t i = 0; i < dst->nwords; ++i)
+        dst->words[i] &= src->words[i];
+
+    return true;
+}
+
+static inline bool kbitset_or(kbitset_t *dst, const kbitset_t *src)
+{
+    if (dst->nbits != src->nbits)
+        return false;
+
+    for (size_t i = 0; i < dst->nwords; ++i)
+        dst->words[i] |= src->words[i];
+
+    return true;
+}
+
+static inline bool kbitset_xor(kbitset_t *dst, const kbitset_t *src)
+{
+    if (dst->nbits != src->nbits)
+        return false;
+
+    for (size_t i = 0; i < dst->nwords; ++i)
+        dst->words[i] ^= src->words[i];
+
+    return true;
+}
+
+static inline bool kbitset_andnot(kbitset_t *dst, const kbitset_t *src)
+{
+    if (dst->nbits != src->nbits)
+        return false;
+
+    for (size_t i = 0; i < dst->nwords; ++i)
+        dst->words[i] &= ~src->words[i];
+
+    return true;
+}
+
+/**
+ * Returns number of set bits
+ */
+static inline size_t kbitset_popcount(const kbitset_t *bs)
+{
+    const uint64_t ones = KPOPCOUNT_BUFFER(bs->words, bs->nwords * sizeof(bs->words[0]));
+
+    return (size_t)ones;
+}
+
+/**
+ * Returns index of first set bit >= from or nbits when there is no such bit
+ */
+static inline size_t kbitset_find_next_set(const kbitset_t *bs, size_t from)
+{
+    if (from >= bs->nbits)
+        return bs->nbits;
+
+    size_t i = KBITSET_WORD_INDEX(from);
+    uint64_t word = bs->words[i] & __kbitset_mask_from(from);
+
+    while (word == 0)
+    {
+        if (++i == bs->nwords)
+            return bs->nbits;
+
+        word = bs->words[i];
+    }
+
+    return i * KBITSET_WORD_BITS + (size_t)KCTZLL(word);
+}
+
+/**
+ * Returns index of first cleared bit >= from or nbits when there is no such bit
+ */
+static inline size_t kbitset_find_next_clear(const kbitset_t *bs, size_t from)
+{
+    if (from >= bs->nbits)
+        return bs->nbits;
+
+    size_t i = KBITSET_WORD_INDEX(from);
+    uint64_t word = ~bs->words[i] & __kbitset_mask_from(from);
+
+    while (word == 0)
+    {
+        if (++i == bs->nwords)
+            return bs->nbits;
+
+        word = ~bs->words[i];
+    }
+
+    const size_t bit = i * KBITSET_WORD_BITS + (size_t)KCTZLL(word);
+
+    /* Bits beyond nbits are always '0', so they look like cleared */
+    return bit < bs->nbits ? bit : bs->nbits;
+}
+
+/**
+ * Iterator over set bits. It caches current word, so every step costs single ctz
+ *
+ * Example:
+ * kbitset_iter_t it = kbitset_iter_init(bs);
+ * size_t bit;
+ * while (kbitset_iter_next(&it, &bit))
+ *     printf("%zu\n", bit);
+ */
+static inline kbitset_iter_t kbitset_iter_init(const kbitset_t *bs)
+{
+    return (kbitset_iter_t){.bs = bs, .word_index = 0, .word = bs->nwords > 0 ? bs->words[0] : 0};
+}
+
+static inline bool kbitset_iter_next(kbitset_iter_t *it, size_t *bit)
+{
+    while (it->word == 0)
+    {
+        if (it->word_index + 1 >= it->bs->nwords)
+            return false;
+
+        it->word = it->bs->words[++it->word_index];
+    }
+
+    *bit = it->word_index * KBITSET_WORD_BITS + (size_t)KCTZLL(it->word);
+
+    /* clear lowest set bit */
+    it->word &= it->word - 1;
+
+    return true;
+}
+
+#endif
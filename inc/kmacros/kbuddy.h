@@ -0,0 +1,341 @@
+#ifndef KBUDDY_H
+#define KBUDDY_H
+
+/*
+    This is the public header for the KBuddy.
+
+    KBuddy is a buddy allocator for big page granular blocks [2^KBUDDY_PAGE_SHIFT; 2^(KBUDDY_PAGE_SHIFT + KBUDDY_MAX_ORDER)]
+    (4 KiB - 64 MiB by default) over arenas mapped by mmap.
+    Block of order k has 2^k pages, order of size is KLOG2_CEIL(size) - KBUDDY_PAGE_SHIFT.
+
+    Every order has own free bitmap (KBitset), bit i is set when i-th block of this order is free.
+    Buddy of block has index i ^ 1 (offset of block XOR block size), so free merges buddies
+    by clearing buddy bit and going one order up until buddy is not free.
+
+    Arena is mapped once and never returned to system until kbuddy_destroy, so there is no mmap / munmap
+    per block (no page fault storms from malloc mmap threshold). Arena can be backed by huge pages
+    (MAP_HUGETLB or transparent huge pages) and prefaulted (MAP_POPULATE).
+
+    KBuddy is not thread safe.
+
+    MAP_ANONYMOUS is hidden in strict ISO C mode (-std=c11), so compile with -std=gnu11 or newer
+    or define _DEFAULT_SOURCE for whole translation unit.
+
+    Include it directly: #include <kmacros/kbuddy.h>
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE: GPL3
+*/
+
+#include "kmacros.h"
+#include "kbitset.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#ifndef MAP_ANONYMOUS
+#error "KBuddy needs MAP_ANONYMOUS, compile with -std=gnu11 or define _DEFAULT_SOURCE"
+#endif
+
+/* Define before include to change the smallest block (order 0) */
+#ifndef KBUDDY_PAGE_SHIFT
+#define KBUDDY_PAGE_SHIFT       12
+#endif
+
+/* Define before include to change the biggest block (2^KBUDDY_MAX_ORDER pages) */
+#ifndef KBUDDY_MAX_ORDER
+#define KBUDDY_MAX_ORDER        14
+#endif
+
+#ifndef KBUDDY_MAX_ARENAS
+#define KBUDDY_MAX_ARENAS       16
+#endif
+
+#define KBUDDY_PAGE_SIZE        ((size_t)1 << KBUDDY_PAGE_SHIFT)
+#define KBUDDY_ORDERS           (KBUDDY_MAX_ORDER + 1)
+#define KBUDDY_BLOCK_SIZE(order) (KBUDDY_PAGE_SIZE << (order))
+#define KBUDDY_BLOCK_SIZE_MAX   KBUDDY_BLOCK_SIZE(KBUDDY_MAX_ORDER)
+
+/* Arena flags for kbuddy_add_arena */
+#define KBUDDY_ARENA_HUGETLB    (1u << 0) /* MAP_HUGETLB, fails when system has no free huge pages */
+#define KBUDDY_ARENA_THP        (1u << 1) /* align arena to 2 MiB and madvise(MADV_HUGEPAGE) */
+#define KBUDDY_ARENA_POPULATE   (1u << 2) /* MAP_POPULATE, prefault whole arena at creation */
+
+#define KBUDDY_THP_SIZE         ((size_t)2 * 1024 * 1024)
+
+typedef struct kbuddy_arena
+{
+    char      *base;
+    size_t     size;                    /* multiple of KBUDDY_BLOCK_SIZE_MAX */
+    void      *map;                     /* address and size passed to munmap */
+    size_t     map_size;
+    kbitset_t *free[KBUDDY_ORDERS];     /* free[k] has size / KBUDDY_BLOCK_SIZE(k) bits */
+    size_t     hint[KBUDDY_ORDERS];     /* there is no free block of order k below hint[k] */
+    uint8_t   *orders;                  /* order of allocated block, indexed by first page of block */
+    size_t     free_size;
+} kbuddy_arena_t;
+
+typedef struct kbuddy
+{
+    kbuddy_arena_t arenas[KBUDDY_MAX_ARENAS];
+    size_t         narenas;
+} kbuddy_t;
+
+static inline void kbuddy_init(kbuddy_t *buddy);
+static inline void kbuddy_destroy(kbuddy_t *buddy);
+static inline int kbuddy_add_arena(kbuddy_t *buddy, size_t size, unsigned int flags);
+
+static inline unsigned int kbuddy_order(size_t size);
+static inline void *kbuddy_alloc(kbuddy_t *buddy, size_t size) KATTR_FUNC_MALLOC;
+static inline void kbuddy_free(kbuddy_t *buddy, void *ptr);
+static inline size_t kbuddy_free_size(const kbuddy_t *buddy);
+
+/* Private helpers, do not use */
+static inline void __kbuddy_arena_destroy(kbuddy_arena_t *arena);
+static inline void *__kbuddy_arena_alloc(kbuddy_arena_t *arena, unsigned int order);
+static inline void __kbuddy_arena_free(kbuddy_arena_t *arena, size_t index, unsigned int order);
+static inline void __kbuddy_set_free(kbuddy_arena_t *arena, size_t index, unsigned int order);
+
+static inline void kbuddy_init(kbuddy_t *buddy)
+{
+    buddy->narenas = 0;
+}
+
+static inline void __kbuddy_arena_destroy(kbuddy_arena_t *arena)
+{
+    for (size_t k = 0; k < KBUDDY_ORDERS; ++k)
+        kbitset_destroy(arena->free[k]);
+
+    free(arena->orders);
+
+    if (arena->map != NULL)
+        munmap(arena->map, arena->map_size);
+}
+
+/**
+ * Unmap every arena, all blocks become invalid
+ */
+static inline void kbuddy_destroy(kbuddy_t *buddy)
+{
+    for (size_t i = 0; i < buddy->narenas; ++i)
+        __kbuddy_arena_destroy(&buddy->arenas[i]);
+
+    buddy->narenas = 0;
+}
+
+/**
+ * Map new arena, kbuddy_alloc uses arenas in order of adding
+ *
+ * @param[in] buddy - buddy allocator
+ * @param[in] size - size of arena, rounded up to multiple of KBUDDY_BLOCK_SIZE_MAX
+ * @param[in] flags - KBUDDY_ARENA_* flags
+ *
+ * @return 0 on success, -1 on failure (mmap failed, no memory, KBUDDY_MAX_ARENAS arenas or size cannot be rounded)
+ */
+static inline int kbuddy_add_arena(kbuddy_t *buddy, size_t size, unsigned int flags)
+{
+    if (buddy->narenas == KBUDDY_MAX_ARENAS || size == 0)
+        return -1;
+
+    /* rounded size and extra THP page have to fit into size_t */
+    if (size > SIZE_MAX - (KBUDDY_BLOCK_SIZE_MAX - 1) - KBUDDY_THP_SIZE)
+        return -1;
+
+    size = (size + KBUDDY_BLOCK_SIZE_MAX - 1) & ~(KBUDDY_BLOCK_SIZE_MAX - 1);
+
+    kbuddy_arena_t *arena = &buddy->arenas[buddy->narenas];
+    *arena = (kbuddy_arena_t){.base = NULL};
+
+    int map_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+    map_flags |= MAP_NORESERVE;
+#endif
+#ifdef MAP_HUGETLB
+    if (flags & KBUDDY_ARENA_HUGETLB)
+        map_flags |= MAP_HUGETLB;
+#else
+    if (flags & KBUDDY_ARENA_HUGETLB)
+        return -1;
+#endif
+
+#ifdef MAP_POPULATE
+    if (flags & KBUDDY_ARENA_POPULATE)
+        map_flags |= MAP_POPULATE;
+#endif
+
+    /* extra huge page to align arena for THP */
+    const bool thp = (flags & KBUDDY_ARENA_THP) && !(flags & KBUDDY_ARENA_HUGETLB);
+    arena->map_size = size + (thp ? KBUDDY_THP_SIZE : 0);
+    arena->map = mmap(NULL, arena->map_size, PROT_READ | PROT_WRITE, map_flags, -1, 0);
+    if (arena->map == MAP_FAILED)
+    {
+        arena->map = NULL;
+        return -1;
+    }
+
+    const uintptr_t addr = (uintptr_t)arena->map;
+    arena->base = thp ? (char *)((addr + KBUDDY_THP_SIZE - 1) & ~(uintptr_t)(KBUDDY_THP_SIZE - 1)) : (char *)arena->map;
+    arena->size = size;
+
+#ifdef MADV_HUGEPAGE
+    if (thp)
+        (void)madvise(arena->base, size, MADV_HUGEPAGE);
+#endif
+
+    arena->orders = calloc(size >> KBUDDY_PAGE_SHIFT, sizeof(arena->orders[0]));
+    bool ok = arena->orders != NULL;
+
+    for (size_t k = 0; k < KBUDDY_ORDERS && ok; ++k)
+    {
+        arena->free[k] = kbitset_create(size / KBUDDY_BLOCK_SIZE(k));
+        ok = arena->free[k] != NULL;
+    }
+
+    if (!ok)
+    {
+        __kbuddy_arena_destroy(arena);
+        return -1;
+    }
+
+    /* whole arena is a set of free blocks of the highest order */
+    kbitset_set_all(arena->free[KBUDDY_MAX_ORDER]);
+    arena->free_size = size;
+
+    ++buddy->narenas;
+
+    return 0;
+}
+
+/**
+ * Order of block for size, size > KBUDDY_BLOCK_SIZE_MAX gives order > KBUDDY_MAX_ORDER
+ */
+static inline unsigned int kbuddy_order(size_t size)
+{
+    if (size <= KBUDDY_PAGE_SIZE)
+        return 0;
+
+    const long log = KLOG2_CEIL(size);
+
+    return (unsigned int)log - KBUDDY_PAGE_SHIFT;
+}
+
+static inline void __kbuddy_set_free(kbuddy_arena_t *arena, size_t index, unsigned int order)
+{
+    kbitset_set(arena->free[order], index);
+    arena->hint[order] = KMIN(arena->hint[order], index);
+}
+
+static inline void *__kbuddy_arena_alloc(kbuddy_arena_t *arena, unsigned int order)
+{
+    for (unsigned int k = order; k < KBUDDY_ORDERS; ++k)
+    {
+        const size_t index = kbitset_find_next_set(arena->free[k], arena->hint[k]);
+        if (index == arena->free[k]->nbits)
+        {
+            arena->hint[k] = index;
+            continue;
+        }
+
+        kbitset_clear(arena->free[k], index);
+        arena->hint[k] = index + 1;
+
+        /* split: left half goes down, right half (buddy) is free */
+        size_t block = index;
+        for (unsigned int j = k; j > order; --j)
+        {
+            block <<= 1;
+            __kbuddy_set_free(arena, block + 1, j - 1);
+        }
+
+        const size_t offset = block << (order + KBUDDY_PAGE_SHIFT);
+        arena->orders[offset >> KBUDDY_PAGE_SHIFT] = (uint8_t)order;
+        arena->free_size -= KBUDDY_BLOCK_SIZE(order);
+
+        return arena->base + offset;
+    }
+
+    return NULL;
+}
+
+static inline void __kbuddy_arena_free(kbuddy_arena_t *arena, size_t index, unsigned int order)
+{
+    arena->free_size += KBUDDY_BLOCK_SIZE(order);
+
+    /* merge with buddy (index ^ 1) while buddy is free */
+    while (order < KBUDDY_MAX_ORDER && kbitset_test(arena->free[order], index ^ 1))
+    {
+        kbitset_clear(arena->free[order], index ^ 1);
+        index >>= 1;
+        ++order;
+    }
+
+    __kbuddy_set_free(arena, index, order);
+}
+
+/**
+ * Allocate block of 2^order pages, where order = kbuddy_order(size).
+ * Block is aligned to its size relative to arena base (arena base is page aligned, 2 MiB aligned with THP)
+ *
+ * @param[in] buddy - buddy allocator
+ * @param[in] size - bytes, at most KBUDDY_BLOCK_SIZE_MAX
+ *
+ * @return pointer to block or NULL when no arena has free block
+ */
+static inline void *kbuddy_alloc(kbuddy_t *buddy, size_t size)
+{
+    const unsigned int order = kbuddy_order(size);
+    if (KUNLIKELY(order > KBUDDY_MAX_ORDER))
+        return NULL;
+
+    for (size_t i = 0; i < buddy->narenas; ++i)
+    {
+        void *ptr = __kbuddy_arena_alloc(&buddy->arenas[i], order);
+        if (KLIKELY(ptr != NULL))
+            return ptr;
+    }
+
+    return NULL;
+}
+
+/**
+ * Free block allocated by kbuddy_alloc, free of NULL does nothing
+ */
+static inline void kbuddy_free(kbuddy_t *buddy, void *ptr)
+{
+    if (ptr == NULL)
+        return;
+
+    for (size_t i = 0; i < buddy->narenas; ++i)
+    {
+        kbuddy_arena_t *arena = &buddy->arenas[i];
+        const uintptr_t addr = (uintptr_t)ptr;
+        const uintptr_t base = (uintptr_t)arena->base;
+
+        if (addr >= base && addr - base < arena->size)
+        {
+            const size_t page = (size_t)(addr - base) >> KBUDDY_PAGE_SHIFT;
+            const unsigned int order = arena->orders[page];
+
+            __kbuddy_arena_free(arena, page >> order, order);
+            return;
+        }
+    }
+}
+
+/**
+ * Free bytes in all arenas (sum of free blocks, not the biggest possible allocation)
+ */
+static inline size_t kbuddy_free_size(const kbuddy_t *buddy)
+{
+    size_t sum = 0;
+    for (size_t i = 0; i < buddy->narenas; ++i)
+        sum += buddy->arenas[i].free_size;
+
+    return sum;
+}
+
+#endif
@@ -25,8 +25,8 @@
 #include <inttypes.h>
 #include <limits.h>
 
-/* Cannot implement it, so paste normal condition */
-#define kbuiltin_expect_impl(cond, value) ((cond) == value)
+/* Cannot implement it, so paste normal condition (like __builtin_expect it returns value of cond) */
+#define kbuiltin_expect_impl(cond, value) ((void)(value), (cond))
 #define kbuiltin_expect_with_probability_impl(cond, value, prob) kbuiltin_expect_impl(cond, value)
 
 /* Cannot implement it, so paste normal terary operator */
@@ -73,6 +73,12 @@
 #define kbuiltin_bswap32_impl(x)  __kbswap32(x)
 #define kbuiltin_bswap64_impl(x)  __kbswap64(x)
 
+/* Returns x with the order of the bits reversed; for example, 0x01 (8 bits) becomes 0x80. */
+#define kbuiltin_bitreverse8_impl(x)   __kbitreverse8(x)
+#define kbuiltin_bitreverse16_impl(x)  __kbitreverse16(x)
+#define kbuiltin_bitreverse32_impl(x)  __kbitreverse32(x)
+#define kbuiltin_bitreverse64_impl(x)  __kbitreverse64(x)
+
 #define kbuiltin_add_overflow_impl(x, y, res)    kadd_overflow_generic(x, y, res)
 #define kbuiltin_uadd_overflow_impl(x, y, res)   __kuadd_overflow(x, y, res)
 #define kbuiltin_uaddl_overflow_impl(x, y, res)  __kuaddl_overflow(x, y, res)
@@ -97,16 +103,114 @@
 #define kbuiltin_smull_overflow_impl(x, y, res)  __ksmull_overflow(x, y, res)
 #define kbuiltin_smulll_overflow_impl(x, y, res) __ksmulll_overflow(x, y, res)
 
+/*
+    Bit scan helpers used by the fallbacks below.
+    Every helper works on exact width (32 or 64 bits) in constant time (no loop over bits).
+    Bigger types are dispatched by sizeof, so compiler removes dead branch during compilation.
+*/
+
+/* See Hacker's Delight 5-1, SWAR popcount */
+static inline int __kpopcount32(uint32_t x)
+{
+    x = x - ((x >> 1) & UINT32_C(0x55555555));
+    x = (x & UINT32_C(0x33333333)) + ((x >> 2) & UINT32_C(0x33333333));
+    x = (x + (x >> 4)) & UINT32_C(0x0F0F0F0F);
+
+    return (int)((uint32_t)(x * UINT32_C(0x01010101)) >> 24);
+}
+
+static inline int __kpopcount64(uint64_t x)
+{
+    x = x - ((x >> 1) & UINT64_C(0x5555555555555555));
+    x = (x & UINT64_C(0x3333333333333333)) + ((x >> 2) & UINT64_C(0x3333333333333333));
+    x = (x + (x >> 4)) & UINT64_C(0x0F0F0F0F0F0F0F0F);
+
+    return (int)((uint64_t)(x * UINT64_C(0x0101010101010101)) >> 56);
+}
+
+/* Position of the only one 1-bit in x (x has to be a power of 2), de Bruijn multiplication */
+static inline int __kbit_index32(uint32_t x)
+{
+    static const uint8_t debruijn_index[32] =
+    {
+         0,  1, 28,  2, 29, 14, 24,  3, 30, 22, 20, 15, 25, 17,  4,  8,
+        31, 27, 13, 23, 21, 19, 16,  7, 26, 12, 18,  6, 11,  5, 10,  9
+    };
+
+    return debruijn_index[(uint32_t)(x * UINT32_C(0x077CB531)) >> 27];
+}
+
+static inline int __kbit_index64(uint64_t x)
+{
+    static const uint8_t debruijn_index[64] =
+    {
+         0,  1, 48,  2, 57, 49, 28,  3, 61, 58, 50, 42, 38, 29, 17,  4,
+        62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12,  5,
+        63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+        46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19,  9, 13,  8,  7,  6
+    };
+
+    return debruijn_index[(uint64_t)(x * UINT64_C(0x03F79D71B4CB0A89)) >> 58];
+}
+
+/* Index of the least significant 1-bit, x != 0 */
+static inline int __kctz32(uint32_t x)
+{
+    return __kbit_index32(x & (0u - x));
+}
+
+static inline int __kctz64(uint64_t x)
+{
+    return __kbit_index64(x & (0u - x));
+}
+
+/* Index of the most significant 1-bit, x != 0 */
+static inline int __kmsb32(uint32_t x)
+{
+    x |= x >> 1;
+    x |= x >> 2;
+    x |= x >> 4;
+    x |= x >> 8;
+    x |= x >> 16;
+
+    return __kbit_index32(x ^ (x >> 1));
+}
+
+static inline int __kmsb64(uint64_t x)
+{
+    x |= x >> 1;
+    x |= x >> 2;
+    x |= x >> 4;
+    x |= x >> 8;
+    x |= x >> 16;
+    x |= x >> 32;
+
+    return __kbit_index64(x ^ (x >> 1));
+}
+
+/* Fold word to 4 bits, then 0x6996 is a parity lookup table for nibbles */
+static inline int __kparity32(uint32_t x)
+{
+    x ^= x >> 16;
+    x ^= x >> 8;
+    x ^= x >> 4;
+
+    return (int)((UINT32_C(0x6996) >> (x & 0xF)) & 1);
+}
+
+static inline int __kparity64(uint64_t x)
+{
+    return __kparity32((uint32_t)(x ^ (x >> 32)));
+}
+
+#define __KBUILTIN_IS_64(x) (sizeof(x) == sizeof(uint64_t))
+
 static inline int __kffs(int x)
 {
     if (x == 0)
         return 0;
 
-    for (int pos = 0; pos < (int)(sizeof(x) * CHAR_BIT); ++pos)
-        if (x & (1 << pos))
-            return pos + 1;
-
-    return 0;
+    return (__KBUILTIN_IS_64(x) ? __kctz64((uint64_t)(unsigned int)x) : __kctz32((uint32_t)(unsigned int)x)) + 1;
 }
 
 static inline int __kffsl(long x)
@@ -114,11 +218,7 @@ static inline int __kffsl(long x)
     if (x == 0)
         return 0;
 
-    for (int pos = 0; pos < (int)(sizeof(x) * CHAR_BIT); ++pos)
-        if (x & (1l << pos))
-            return pos + 1;
-
-    return 0;
+    return (__KBUILTIN_IS_64(x) ? __kctz64((uint64_t)(unsigned long)x) : __kctz32((uint32_t)(unsigned long)x)) + 1;
 }
 
 static inline int __kffsll(long long x)
@@ -126,11 +226,7 @@ static inline int __kffsll(long long x)
     if (x == 0)
         return 0;
 
-    for (int pos = 0; pos < (int)(sizeof(x) * CHAR_BIT); ++pos)
-        if (x & (1ll << pos))
-            return pos + 1;
-
-    return 0;
+    return (__KBUILTIN_IS_64(x) ? __kctz64((uint64_t)(unsigned long long)x) : __kctz32((uint32_t)(unsigned long long)x)) + 1;
 }
 
 static inline int __kclz(unsigned int x)
@@ -139,14 +235,7 @@ static inline int __kclz(unsigned int x)
     if (x == 0)
         return -1;
 
-    int zeros = 0;
-    for (int pos = (int)((sizeof(x) * CHAR_BIT) - 1); pos > 0; --pos)
-        if ((x & (1u << pos)) == 0)
-            zeros++;
-        else
-            return zeros;
-
-    return zeros;
+    return (int)(sizeof(x) * CHAR_BIT) - 1 - (__KBUILTIN_IS_64(x) ? __kmsb64((uint64_t)x) : __kmsb32((uint32_t)x));
 }
 
 static inline int __kclzl(unsigned long x)
@@ -155,14 +244,7 @@ static inline int __kclzl(unsigned long x)
     if (x == 0)
         return -1;
 
-    int zeros = 0;
-    for (int pos = (int)((sizeof(x) * CHAR_BIT) - 1); pos > 0; --pos)
-        if ((x & (1ul << pos)) == 0)
-            zeros++;
-        else
-            return zeros;
-
-    return zeros;
+    return (int)(sizeof(x) * CHAR_BIT) - 1 - (__KBUILTIN_IS_64(x) ? __kmsb64((uint64_t)x) : __kmsb32((uint32_t)x));
 }
 
 static inline int __kclzll(unsigned long long x)
@@ -171,14 +253,7 @@ static inline int __kclzll(unsigned long long x)
     if (x == 0)
         return -1;
 
-    int zeros = 0;
-    for (int pos = (int)((sizeof(x) * CHAR_BIT) - 1); pos > 0; --pos)
-        if ((x & (1ull << pos)) == 0)
-            zeros++;
-        else
-            return zeros;
-
-    return zeros;
+    return (int)(sizeof(x) * CHAR_BIT) - 1 - (__KBUILTIN_IS_64(x) ? __kmsb64((uint64_t)x) : __kmsb32((uint32_t)x));
 }
 
 static inline int __kctz(unsigned int x)
@@ -187,14 +262,7 @@ static inline int __kctz(unsigned int x)
     if (x == 0)
         return -1;
 
-    int zeros = 0;
-    for (int pos = 0; pos < (int)(sizeof(x) * CHAR_BIT); ++pos)
-        if ((x & (1u << pos)) == 0)
-            zeros++;
-        else
-            return zeros;
-
-    return zeros;
+    return __KBUILTIN_IS_64(x) ? __kctz64((uint64_t)x) : __kctz32((uint32_t)x);
 }
 
 static inline int __kctzl(unsigned long x)
@@ -203,14 +271,7 @@ static inline int __kctzl(unsigned long x)
     if (x == 0)
         return -1;
 
-    int zeros = 0;
-    for (int pos = 0; pos < (int)(sizeof(x) * CHAR_BIT); ++pos)
-        if ((x & (1ul << pos)) == 0)
-            zeros++;
-        else
-            return zeros;
-
-    return zeros;
+    return __KBUILTIN_IS_64(x) ? __kctz64((uint64_t)x) : __kctz32((uint32_t)x);
 }
 
 static inline int __kctzll(unsigned long long x)
@@ -219,104 +280,65 @@ static inline int __kctzll(unsigned long long x)
     if (x == 0)
         return -1;
 
-    int zeros = 0;
-    for (int pos = 0; pos < (int)(sizeof(x) * CHAR_BIT); ++pos)
-        if ((x & (1ull << pos)) == 0)
-            zeros++;
-        else
-            return zeros;
-
-    return zeros;
+    return __KBUILTIN_IS_64(x) ? __kctz64((uint64_t)x) : __kctz32((uint32_t)x);
 }
 
+/*
+    Clear sign bits (xor with sign mask) and count leading zeros of (x << 1) | 1.
+    Last 1-bit guards zero, so there is no undefined case here.
+*/
 static inline int __kclrsb(int x)
 {
-    const int sign_bit = x < 0;
-    int lrsb = 0;
-
-    for (int pos = (int)((sizeof(x) * CHAR_BIT) - 2); pos >= 0; --pos)
-        if (((x & (1 << pos)) >> pos) == sign_bit)
-            ++lrsb;
-        else
-            return lrsb;
+    const unsigned int u = (unsigned int)x;
+    const unsigned int v = u ^ (0u - (u >> ((sizeof(x) * CHAR_BIT) - 1)));
 
-    return lrsb;
+    return __kclz((v << 1) | 1u);
 }
 
 static inline int __kclrsbl(long x)
 {
-    const int sign_bit = x < 0;
-    int lrsb = 0;
+    const unsigned long u = (unsigned long)x;
+    const unsigned long v = u ^ (0ul - (u >> ((sizeof(x) * CHAR_BIT) - 1)));
 
-    for (int pos = (int)((sizeof(x) * CHAR_BIT) - 2); pos >= 0; --pos)
-        if (((x & (1l << pos)) >> pos) == sign_bit)
-            ++lrsb;
-        else
-            return lrsb;
-
-    return lrsb;
+    return __kclzl((v << 1) | 1ul);
 }
 
 static inline int __kclrsbll(long long x)
 {
-    const int sign_bit = x < 0;
-    int lrsb = 0;
-
-    for (int pos = (int)((sizeof(x) * CHAR_BIT) - 2); pos >= 0; --pos)
-        if (((x & (1ll << pos)) >> pos) == sign_bit)
-            ++lrsb;
-        else
-            return lrsb;
+    const unsigned long long u = (unsigned long long)x;
+    const unsigned long long v = u ^ (0ull - (u >> ((sizeof(x) * CHAR_BIT) - 1)));
 
-    return lrsb;
+    return __kclzll((v << 1) | 1ull);
 }
 
 static inline int __kpopcount(unsigned int x)
 {
-    int ones = 0;
-
-    for (int pos = 0; pos < (int)(sizeof(x) * CHAR_BIT); ++pos)
-        if ((x & (1u << pos)))
-            ones++;
-
-    return ones;
+    return __KBUILTIN_IS_64(x) ? __kpopcount64((uint64_t)x) : __kpopcount32((uint32_t)x);
 }
 
 static inline int __kpopcountl(unsigned long x)
 {
-    int ones = 0;
-
-    for (int pos = 0; pos < (int)(sizeof(x) * CHAR_BIT); ++pos)
-        if ((x & (1ul << pos)))
-            ones++;
-
-    return ones;
+    return __KBUILTIN_IS_64(x) ? __kpopcount64((uint64_t)x) : __kpopcount32((uint32_t)x);
 }
 
 static inline int __kpopcountll(unsigned long long x)
 {
-    int ones = 0;
-
-    for (int pos = 0; pos < (int)(sizeof(x) * CHAR_BIT); ++pos)
-        if ((x & (1ull << pos)))
-            ones++;
-
-    return ones;
+    return __KBUILTIN_IS_64(x) ? __kpopcount64((uint64_t)x) : __kpopcount32((uint32_t)x);
 }
 
 static inline int __kparity(unsigned int x)
 {
-    return __kpopcount(x) % 2;
+    return __KBUILTIN_IS_64(x) ? __kparity64((uint64_t)x) : __kparity32((uint32_t)x);
 }
 
 static inline int __kparityl(unsigned long x)
 {
-    return __kpopcountl(x) % 2;
+    return __KBUILTIN_IS_64(x) ? __kparity64((uint64_t)x) : __kparity32((uint32_t)x);
 }
 
 static inline int __kparityll(unsigned long long x)
 {
-    return __kpopcountll(x) % 2;
+    return __KBUILTIN_IS_64(x) ? __kparity64((uint64_t)x) : __kparity32((uint32_t)x);
 }
 
 static inline uint16_t __kbswap16(uint16_t x)
@@ -344,6 +366,46 @@ static inline uint64_t __kbswap64(uint64_t x)
            (uint64_t)((x & 0xFF00000000000000ULL) >> 56);
 }
 
+/*
+    Bit reverse by log-step swap network: swap neighbour bits, pairs, nibbles and then bytes by bswap.
+    Constant time, no loop over bits.
+*/
+static inline uint8_t __kbitreverse8(uint8_t x)
+{
+    x = (uint8_t)(((x >> 1) & 0x55u) | ((x & 0x55u) << 1));
+    x = (uint8_t)(((x >> 2) & 0x33u) | ((x & 0x33u) << 2));
+    x = (uint8_t)((x >> 4) | (x << 4));
+
+    return x;
+}
+
+static inline uint16_t __kbitreverse16(uint16_t x)
+{
+    x = (uint16_t)(((x >> 1) & 0x5555u) | ((x & 0x5555u) << 1));
+    x = (uint16_t)(((x >> 2) & 0x3333u) | ((x & 0x3333u) << 2));
+    x = (uint16_t)(((x >> 4) & 0x0F0Fu) | ((x & 0x0F0Fu) << 4));
+
+    return __kbswap16(x);
+}
+
+static inline uint32_t __kbitreverse32(uint32_t x)
+{
+    x = ((x >> 1) & UINT32_C(0x55555555)) | ((x & UINT32_C(0x55555555)) << 1);
+    x = ((x >> 2) & UINT32_C(0x33333333)) | ((x & UINT32_C(0x33333333)) << 2);
+    x = ((x >> 4) & UINT32_C(0x0F0F0F0F)) | ((x & UINT32_C(0x0F0F0F0F)) << 4);
+
+    return __kbswap32(x);
+}
+
+static inline uint64_t __kbitreverse64(uint64_t x)
+{
+    x = ((x >> 1) & UINT64_C(0x5555555555555555)) | ((x & UINT64_C(0x5555555555555555)) << 1);
+    x = ((x >> 2) & UINT64_C(0x3333333333333333)) | ((x & UINT64_C(0x3333333333333333)) << 2);
+    x = ((x >> 4) & UINT64_C(0x0F0F0F0F0F0F0F0F)) | ((x & UINT64_C(0x0F0F0F0F0F0F0F0F)) << 4);
+
+    return __kbswap64(x);
+}
+
 #ifdef KCOMPILER_GNUC
 
 #define kadd_overflow_generic(x, y, res) \
@@ -451,23 +513,29 @@ static inline bool __kuaddll_overflow(unsigned long long x, unsigned long long y
 
 static inline bool __ksadd_overflow(int x, int y, int* res)
 {
-    *res = x + y;
+    const unsigned int r = (unsigned int)x + (unsigned int)y;
+    *res = (int)r;
 
-    return (y > 0 && (x > INT_MAX - y)) || (y < 0 && (x < INT_MIN - y));
+    /* overflow when x and y have the same sign and sign of result is different */
+    return (((r ^ (unsigned int)x) & (r ^ (unsigned int)y)) >> (sizeof(r) * CHAR_BIT - 1)) != 0;
 }
 
 static inline bool __ksaddl_overflow(long x, long y, long* res)
 {
-    *res = x + y;
+    const unsigned long r = (unsigned long)x + (unsigned long)y;
+    *res = (long)r;
 
-    return (y > 0 && (x > LONG_MAX - y)) || (y < 0 && (x < LONG_MIN - y));
+    /* overflow when x and y have the same sign and sign of result is different */
+    return (((r ^ (unsigned long)x) & (r ^ (unsigned long)y)) >> (sizeof(r) * CHAR_BIT - 1)) != 0;
 }
 
 static inline bool __ksaddll_overflow(long long x, long long y, long long* res)
 {
-    *res = x + y;
+    const unsigned long long r = (unsigned long long)x + (unsigned long long)y;
+    *res = (long long)r;
 
-    return (y > 0 && (x > LLONG_MAX - y)) || (y < 0 && (x < LLONG_MIN - y));
+    /* overflow when x and y have the same sign and sign of result is different */
+    return (((r ^ (unsigned long long)x) & (r ^ (unsigned long long)y)) >> (sizeof(r) * CHAR_BIT - 1)) != 0;
 }
 
 static inline bool __kusub_overflow(unsigned int x, unsigned int y, unsigned int* res)
@@ -493,68 +561,198 @@ static inline bool __kusubll_overflow(unsigned long long x, unsigned long long y
 
 static inline bool __kssub_overflow(int x, int y, int* res)
 {
-    *res = x - y;
+    const unsigned int r = (unsigned int)x - (unsigned int)y;
+    *res = (int)r;
 
-    return (y > 0 && (x < INT_MIN + y)) || (y < 0 && (x > INT_MAX + y));
+    /* overflow when x and y have different signs and sign of result is different than sign of x */
+    return ((((unsigned int)x ^ (unsigned int)y) & ((unsigned int)x ^ r)) >> (sizeof(r) * CHAR_BIT - 1)) != 0;
 }
 
 static inline bool __kssubl_overflow(long x, long y, long* res)
 {
-    *res = x - y;
+    const unsigned long r = (unsigned long)x - (unsigned long)y;
+    *res = (long)r;
 
-    return (y > 0 && (x < LONG_MIN + y)) || (y < 0 && (x > LONG_MAX + y));
+    /* overflow when x and y have different signs and sign of result is different than sign of x */
+    return ((((unsigned long)x ^ (unsigned long)y) & ((unsigned long)x ^ r)) >> (sizeof(r) * CHAR_BIT - 1)) != 0;
 }
 
 static inline bool __kssubll_overflow(long long x, long long y, long long* res)
 {
-    *res = x - y;
+    const unsigned long long r = (unsigned long long)x - (unsigned long long)y;
+    *res = (long long)r;
 
-    return (y > 0 && (x < LLONG_MIN + y)) || (y < 0 && (x > LLONG_MAX + y));
+    /* overflow when x and y have different signs and sign of result is different than sign of x */
+    return ((((unsigned long long)x ^ (unsigned long long)y) & ((unsigned long long)x ^ r)) >> (sizeof(r) * CHAR_BIT - 1)) != 0;
 }
 
-static inline bool __kumul_overflow(unsigned int x, unsigned int y, unsigned int* res)
+/*
+    Overflow of multiplication is detected by wide product (no division).
+    32-bit types use 64-bit product, 64-bit types use 64x64 -> 128 product:
+    unsigned __int128 when compiler supports it, schoolbook on 32-bit limbs otherwise.
+*/
+
+/* Low 64 bits of x * y are returned, high 64 bits are stored in hi */
+static inline uint64_t __kmul64_wide_limbs(uint64_t x, uint64_t y, uint64_t *hi);
+static inline uint64_t __kmul64_wide_limbs(uint64_t x, uint64_t y, uint64_t *hi)
 {
+    /* common case in size computations: both operands have only low limbs */
+    if (((x | y) >> 32) == 0)
+    {
+        *hi = 0;
+        return x * y;
+    }
+
+    const uint64_t x_lo = x & UINT32_MAX;
+    const uint64_t x_hi = x >> 32;
+    const uint64_t y_lo = y & UINT32_MAX;
+    const uint64_t y_hi = y >> 32;
+
+    const uint64_t ll = x_lo * y_lo;
+    const uint64_t lh = x_lo * y_hi;
+    const uint64_t hl = x_hi * y_lo;
+    const uint64_t hh = x_hi * y_hi;
+
+    /* sum of 3 values < 2^32 fits into 64 bits */
+    const uint64_t mid = (ll >> 32) + (lh & UINT32_MAX) + (hl & UINT32_MAX);
+
+    *hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+
+    return (mid << 32) | (ll & UINT32_MAX);
+}
+
+static inline uint64_t __kmul64_wide(uint64_t x, uint64_t y, uint64_t *hi);
+static inline uint64_t __kmul64_wide(uint64_t x, uint64_t y, uint64_t *hi)
+{
+#ifdef KCOMPILER_HAS_INT128
+    __extension__ const unsigned __int128 p = (unsigned __int128)x * y;
+
+    *hi = (uint64_t)(p >> 64);
+
+    return (uint64_t)p;
+#else
+    return __kmul64_wide_limbs(x, y, hi);
+#endif
+}
+
+/* Only overflow is needed, so high 64 bits are not computed when result is known from limbs */
+static inline bool __kumul64_overflow_limbs(uint64_t x, uint64_t y, uint64_t *res);
+static inline bool __kumul64_overflow_limbs(uint64_t x, uint64_t y, uint64_t *res)
+{
+    const uint64_t x_hi = x >> 32;
+    const uint64_t y_hi = y >> 32;
+
     *res = x * y;
-    return x > UINT_MAX / y;
+
+    if ((x_hi | y_hi) == 0)
+        return false;
+
+    if (x_hi != 0 && y_hi != 0)
+        return true;
+
+    /* a * b where b < 2^32: product = t * 2^32 + low limb, t < 2^64 */
+    const uint64_t a = x_hi != 0 ? x : y;
+    const uint64_t b = x_hi != 0 ? y : x;
+    const uint64_t t = (a >> 32) * b + (((a & UINT32_MAX) * b) >> 32);
+
+    return (t >> 32) != 0;
+}
+
+static inline bool __kumul64_overflow(uint64_t x, uint64_t y, uint64_t *res);
+static inline bool __kumul64_overflow(uint64_t x, uint64_t y, uint64_t *res)
+{
+#ifdef KCOMPILER_HAS_INT128
+    uint64_t hi;
+    *res = __kmul64_wide(x, y, &hi);
+
+    return hi != 0;
+#else
+    return __kumul64_overflow_limbs(x, y, res);
+#endif
+}
+
+static inline bool __ksmul64_overflow(int64_t x, int64_t y, int64_t *res);
+static inline bool __ksmul64_overflow(int64_t x, int64_t y, int64_t *res)
+{
+    const uint64_t ux = (uint64_t)x;
+    const uint64_t uy = (uint64_t)y;
+    uint64_t hi;
+    const uint64_t lo = __kmul64_wide(ux, uy, &hi);
+
+    /* signed high part = unsigned high part - (x < 0 ? y : 0) - (y < 0 ? x : 0) (mod 2^64) */
+    hi -= (0 - (ux >> 63)) & uy;
+    hi -= (0 - (uy >> 63)) & ux;
+
+    *res = (int64_t)lo;
+
+    /* product fits when high part is only sign extension of low part */
+    return hi != 0 - (lo >> 63);
+}
+
+static inline bool __kumul_overflow(unsigned int x, unsigned int y, unsigned int* res)
+{
+    const uint64_t p = (uint64_t)x * y;
+    *res = (unsigned int)p;
+
+    return p > UINT_MAX;
 }
 
 static inline bool __kumull_overflow(unsigned long x, unsigned long y, unsigned long* res)
 {
-    *res = x * y;
-    return x > ULONG_MAX / y;
+#if ULONG_MAX == UINT32_MAX
+    const uint64_t p = (uint64_t)x * y;
+    *res = (unsigned long)p;
+
+    return p > ULONG_MAX;
+#else
+    uint64_t r;
+    const bool overflow = __kumul64_overflow((uint64_t)x, (uint64_t)y, &r);
+    *res = (unsigned long)r;
+
+    return overflow;
+#endif
 }
 
 static inline bool __kumulll_overflow(unsigned long long x, unsigned long long y, unsigned long long* res)
 {
-    *res = x * y;
-    return x > ULLONG_MAX / y;
+    uint64_t r;
+    const bool overflow = __kumul64_overflow((uint64_t)x, (uint64_t)y, &r);
+    *res = (unsigned long long)r;
+
+    return overflow;
 }
 
 static inline bool __ksmul_overflow(int x, int y, int* res)
 {
-    *res = x * y;
-    return  (x == -1 && y == INT_MIN) ||
-            (y == -1 && x == INT_MIN) ||
-            (x > INT_MAX / y) ||
-            (x < INT_MIN / y);
+    const int64_t p = (int64_t)x * y;
+    *res = (int)p;
+
+    return p < INT_MIN || p > INT_MAX;
 }
 
 static inline bool __ksmull_overflow(long x, long y, long* res)
 {
-    *res = x * y;
-    return  (x == -1 && y == LONG_MIN) ||
-            (y == -1 && x == LONG_MIN) ||
-            (x > LONG_MAX / y) ||
-            (x < LONG_MIN / y);
+#if LONG_MAX == INT32_MAX
+    const int64_t p = (int64_t)x * y;
+    *res = (long)p;
+
+    return p < LONG_MIN || p > LONG_MAX;
+#else
+    int64_t r;
+    const bool overflow = __ksmul64_overflow((int64_t)x, (int64_t)y, &r);
+    *res = (long)r;
+
+    return overflow;
+#endif
 }
 
 static inline bool __ksmulll_overflow(long long x, long long y, long long* res)
 {
-    *res = x * y;
-    return  (x == -1 && y == LLONG_MIN) ||
-            (y == -1 && x == LLONG_MIN) ||
-            (x > LLONG_MAX / y) ||
-            (x < LLONG_MIN / y);
+    int64_t r;
+    const bool overflow = __ksmul64_overflow((int64_t)x, (int64_t)y, &r);
+    *res = (long long)r;
+
+    return overflow;
 }
 
 #endif
@@ -257,6 +257,21 @@
 #define KBSWAP32(x)      __builtin_bswap32(x)
 #define KBSWAP64(x)      __builtin_bswap64(x)
 
+/**
+ * See https://clang.llvm.org/docs/LanguageExtensions.html#builtin-bitreverse
+ *
+ * Returns x with the order of the bits reversed; for example, 0x01 (8 bits) becomes 0x80.
+ *
+ * KBITREVERSE8(uint8_t x)
+ * KBITREVERSE16(uint16_t x)
+ * KBITREVERSE32(uint32_t x)
+ * KBITREVERSE64(uint64_t x)
+ */
+#define KBITREVERSE8(x)  __builtin_bitreverse8(x)
+#define KBITREVERSE16(x) __builtin_bitreverse16(x)
+#define KBITREVERSE32(x) __builtin_bitreverse32(x)
+#define KBITREVERSE64(x) __builtin_bitreverse64(x)
+
 /**
  * See https://clang.llvm.org/docs/LanguageExtensions.html#builtin-macros
  *
@@ -315,6 +330,80 @@
 #define KSMULL_OVERFLOW(x, y, res)    __builtin_smull_overflow(x, y, res)
 #define KSMULLL_OVERFLOW(x, y, res)   __builtin_smulll_overflow(x, y, res)
 
+/*********** ATOMICS SECTION ******************/
+
+/**
+ * See: https://gcc.gnu.org/onlinedocs/gcc/_005f_005fatomic-Builtins.html
+ *
+ * Memory orders for KATOMIC_* macros
+ */
+#define KATOMIC_RELAXED                 __ATOMIC_RELAXED
+#define KATOMIC_CONSUME                 __ATOMIC_CONSUME
+#define KATOMIC_ACQUIRE                 __ATOMIC_ACQUIRE
+#define KATOMIC_RELEASE                 __ATOMIC_RELEASE
+#define KATOMIC_ACQ_REL                 __ATOMIC_ACQ_REL
+#define KATOMIC_SEQ_CST                 __ATOMIC_SEQ_CST
+
+/**
+ * Type of variable used by KATOMIC_* macros.
+ * Here it is plain type (__atomic builtins work on every integer and pointer),
+ * on unknown compiler it is _Atomic(type), so always declare shared variables by KATOMIC.
+ *
+ * Example:
+ * static KATOMIC(size_t) counter;
+ */
+#define KATOMIC(type)                   type
+
+/**
+ * See: https://gcc.gnu.org/onlinedocs/gcc/_005f_005fatomic-Builtins.html
+ *
+ * Atomic operations with explicit memory order on integer or pointer variable
+ *
+ * KATOMIC_LOAD(ptr, order) --> return *ptr
+ * KATOMIC_STORE(ptr, val, order) --> *ptr = val
+ * KATOMIC_EXCHANGE(ptr, val, order) --> old = *ptr, *ptr = val, return old
+ *
+ * KATOMIC_CAS(ptr, expected_ptr, desired, success_order, failure_order)
+ * if *ptr == *expected_ptr then *ptr = desired and return true,
+ * otherwise *expected_ptr = *ptr and return false.
+ * KATOMIC_CAS_WEAK may fail spuriously, use it in loops (cheaper on LL/SC architectures)
+ *
+ * KATOMIC_FETCH_ADD(ptr, val, order) --> old = *ptr, *ptr += val, return old
+ * The same convention is applicable to SUB, AND, OR, XOR
+ *
+ * KATOMIC_THREAD_FENCE(order) --> fence between threads
+ * KATOMIC_SIGNAL_FENCE(order) --> fence between thread and signal handler (compiler barrier only)
+ */
+#define KATOMIC_LOAD(ptr, order)                                 __atomic_load_n(ptr, order)
+#define KATOMIC_STORE(ptr, val, order)                           __atomic_store_n(ptr, val, order)
+#define KATOMIC_EXCHANGE(ptr, val, order)                        __atomic_exchange_n(ptr, val, order)
+#define KATOMIC_CAS(ptr, expected_ptr, desired, succ, fail)      __atomic_compare_exchange_n(ptr, expected_ptr, desired, false, succ, fail)
+#define KATOMIC_CAS_WEAK(ptr, expected_ptr, desired, succ, fail) __atomic_compare_exchange_n(ptr, expected_ptr, desired, true, succ, fail)
+
+#define KATOMIC_FETCH_ADD(ptr, val, order)                       __atomic_fetch_add(ptr, val, order)
+#define KATOMIC_FETCH_SUB(ptr, val, order)                       __atomic_fetch_sub(ptr, val, order)
+#define KATOMIC_FETCH_AND(ptr, val, order)                       __atomic_fetch_and(ptr, val, order)
+#define KATOMIC_FETCH_OR(ptr, val, order)                        __atomic_fetch_or(ptr, val, order)
+#define KATOMIC_FETCH_XOR(ptr, val, order)                       __atomic_fetch_xor(ptr, val, order)
+
+#define KATOMIC_THREAD_FENCE(order)                              __atomic_thread_fence(order)
+#define KATOMIC_SIGNAL_FENCE(order)                              __atomic_signal_fence(order)
+
+/**
+ * Hint for CPU inside spin loop (pause on x86, yield on ARM).
+ * It saves power, gives resources to sibling hyper thread and avoids memory order violation on loop exit.
+ * On other CPUs it is only compiler barrier
+ */
+#if defined(__x86_64__) || defined(__i386__)
+#define KCPU_RELAX()                    __builtin_ia32_pause()
+#elif defined(__aarch64__) || (defined(__ARM_ARCH) && __ARM_ARCH >= 7)
+#define KCPU_RELAX()                    __asm__ __volatile__("yield" ::: "memory")
+#elif defined(__powerpc__) || defined(__powerpc64__)
+#define KCPU_RELAX()                    __asm__ __volatile__("or 27,27,27" ::: "memory")
+#else
+#define KCPU_RELAX()                    __asm__ __volatile__("" ::: "memory")
+#endif
+
 /*********** ATTRIBUTES SECTION ******************/
 
 #if defined(__has_attribute)
@@ -668,9 +757,12 @@
  * int *ptr KATTR_VAR_CLEANUP(ptr_clean) = malloc(sizeof(*ptr) * 100);
  *
  * When ptr will go out of scope ptr_clan will be called. You can use this to implement RAII in C.
+ *
+ * KATTR_VAR_CLEANUP_SUPPORTED is defined only when cleanup really runs (otherwise KATTR_VAR_CLEANUP is empty)
  */
 #if __has_attribute(cleanup)
 #define KATTR_VAR_CLEANUP(func) __attribute__((cleanup(func)))
+#define KATTR_VAR_CLEANUP_SUPPORTED
 #else
 #define KATTR_VAR_CLEANUP(func)
 #endif
@@ -13,6 +13,21 @@
     KCOMPILER_MAJOR_VERSION is a preprocessor int value i.e for gcc8 it will be 8
     KCOMPILER_MINOR_VERSION is a preprocessor int value i.e for gcc8.4 it will be 4
 
+    KCOMPILER_LITTLE_ENDIAN is defined when compiler reports little endian byte order
+    KCOMPILER_BIG_ENDIAN is defined when compiler reports big endian byte order
+    (none of them is defined when compiler does not report byte order)
+
+    KCOMPILER_HAS_INT128 is defined when compiler supports __int128 and unsigned __int128
+
+    KCOMPILER_TARGET_* is defined when compiler generates code for this target / instruction set
+    (i.e. -mavx2 or -march=native). Only gnu C compilers are reporting it
+    KCOMPILER_TARGET_X86_64 is defined for x86_64
+    KCOMPILER_TARGET_POPCNT is defined when popcnt instruction is available
+    KCOMPILER_TARGET_SSSE3 is defined when SSSE3 instructions are available
+    KCOMPILER_TARGET_AVX2 is defined when AVX2 instructions are available
+    KCOMPILER_TARGET_BMI2 is defined when BMI2 instructions (pext / pdep) are available
+    KCOMPILER_TARGET_AVX512_VPOPCNTDQ is defined when AVX512F and AVX512 VPOPCNTDQ instructions are available
+
     Do not include it directly
 
     Author: Michal Kukowski
@@ -57,4 +72,38 @@
 
 #endif /* #ifdef __clang__ and #elif defined(__GNUC__) */
 
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define KCOMPILER_LITTLE_ENDIAN
+#elif defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define KCOMPILER_BIG_ENDIAN
+#endif
+
+#ifdef __SIZEOF_INT128__
+#define KCOMPILER_HAS_INT128
+#endif
+
+#if defined(__x86_64__)
+#define KCOMPILER_TARGET_X86_64
+#endif
+
+#ifdef __POPCNT__
+#define KCOMPILER_TARGET_POPCNT
+#endif
+
+#ifdef __SSSE3__
+#define KCOMPILER_TARGET_SSSE3
+#endif
+
+#ifdef __AVX2__
+#define KCOMPILER_TARGET_AVX2
+#endif
+
+#ifdef __BMI2__
+#define KCOMPILER_TARGET_BMI2
+#endif
+
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+#define KCOMPILER_TARGET_AVX512_VPOPCNTDQ
+#endif
+
 #endif /* include guard */
@@ -194,6 +194,19 @@
 #define KBSWAP32(x)      kbuiltin_bswap32_impl(x)
 #define KBSWAP64(x)      kbuiltin_bswap64_impl(x)
 
+/**
+ * Returns x with the order of the bits reversed; for example, 0x01 (8 bits) becomes 0x80.
+ *
+ * KBITREVERSE8(uint8_t x)
+ * KBITREVERSE16(uint16_t x)
+ * KBITREVERSE32(uint32_t x)
+ * KBITREVERSE64(uint64_t x)
+ */
+#define KBITREVERSE8(x)  kbuiltin_bitreverse8_impl(x)
+#define KBITREVERSE16(x) kbuiltin_bitreverse16_impl(x)
+#define KBITREVERSE32(x) kbuiltin_bitreverse32_impl(x)
+#define KBITREVERSE64(x) kbuiltin_bitreverse64_impl(x)
+
 /**
  * See https://clang.llvm.org/docs/LanguageExtensions.html#builtin-macros
  *
@@ -252,6 +265,46 @@
 #define KSMULL_OVERFLOW(x, y, res)    kbuiltin_smull_overflow_impl(x, y, res)
 #define KSMULLL_OVERFLOW(x, y, res)   kbuiltin_smulll_overflow_impl(x, y, res)
 
+/*********** ATOMICS SECTION ******************/
+
+/*
+    Unknown compiler has no __atomic builtins, so C11 <stdatomic.h> is used.
+    Variables have to be declared by KATOMIC(type), because C11 atomic functions work only on _Atomic types.
+    When compiler has no C11 atomics (__STDC_NO_ATOMICS__) KATOMIC_* macros are not defined
+*/
+#ifndef __STDC_NO_ATOMICS__
+
+#include <stdatomic.h>
+
+#define KATOMIC_RELAXED                 memory_order_relaxed
+#define KATOMIC_CONSUME                 memory_order_consume
+#define KATOMIC_ACQUIRE                 memory_order_acquire
+#define KATOMIC_RELEASE                 memory_order_release
+#define KATOMIC_ACQ_REL                 memory_order_acq_rel
+#define KATOMIC_SEQ_CST                 memory_order_seq_cst
+
+#define KATOMIC(type)                   _Atomic(type)
+
+#define KATOMIC_LOAD(ptr, order)                                 atomic_load_explicit(ptr, order)
+#define KATOMIC_STORE(ptr, val, order)                           atomic_store_explicit(ptr, val, order)
+#define KATOMIC_EXCHANGE(ptr, val, order)                        atomic_exchange_explicit(ptr, val, order)
+#define KATOMIC_CAS(ptr, expected_ptr, desired, succ, fail)      atomic_compare_exchange_strong_explicit(ptr, expected_ptr, desired, succ, fail)
+#define KATOMIC_CAS_WEAK(ptr, expected_ptr, desired, succ, fail) atomic_compare_exchange_weak_explicit(ptr, expected_ptr, desired, succ, fail)
+
+#define KATOMIC_FETCH_ADD(ptr, val, order)                       atomic_fetch_add_explicit(ptr, val, order)
+#define KATOMIC_FETCH_SUB(ptr, val, order)                       atomic_fetch_sub_explicit(ptr, val, order)
+#define KATOMIC_FETCH_AND(ptr, val, order)                       atomic_fetch_and_explicit(ptr, val, order)
+#define KATOMIC_FETCH_OR(ptr, val, order)                        atomic_fetch_or_explicit(ptr, val, order)
+#define KATOMIC_FETCH_XOR(ptr, val, order)                       atomic_fetch_xor_explicit(ptr, val, order)
+
+#define KATOMIC_THREAD_FENCE(order)                              atomic_thread_fence(order)
+#define KATOMIC_SIGNAL_FENCE(order)                              atomic_signal_fence(order)
+
+/* We dont know CPU instruction, so only compiler barrier */
+#define KCPU_RELAX()                    atomic_signal_fence(memory_order_seq_cst)
+
+#endif /* #ifndef __STDC_NO_ATOMICS__ */
+
 /*********** ATTRIBUTES SECTION ******************/
 #define KATTR_FUNC_ALWAYS_INLINE
 #define KATTR_FUNC_CONST
@@ -0,0 +1,303 @@
+#ifndef KDIVIDER_H
+#define KDIVIDER_H
+
+/*
+    This is the public header for the KDivider.
+
+    KDivider divides by value known only at runtime (hash table capacity, sample rate, number of shards)
+    without div instruction. Divider precomputes magic multiplier and shift once,
+    then every division is multiply high + add + shifts (no branches).
+
+    Algorithms are from Granlund, Montgomery "Division by Invariant Integers using Multiplication":
+    unsigned: m = floor(2^N * (2^l - d) / d) + 1, l = ceil(log2(d))
+              t = mulhi(m, n), q = (t + ((n - t) >> min(l, 1))) >> max(l - 1, 0)
+    signed:   m = floor(2^(N + l - 1) / |d|) + 1 - 2^N, l = max(ceil(log2(|d|)), 1)
+              q = ((n + mulsh(m, n)) >> (l - 1)) - sign(n), negated when d < 0
+
+    Include it directly: #include <kmacros/kdivider.h>
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE: GPL3
+*/
+
+#include "kmacros.h"
+#include "kint128.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct kdivider_u32
+{
+    uint32_t d;
+    uint32_t magic;
+    uint8_t  shift1;
+    uint8_t  shift2;
+} kdivider_u32_t;
+
+typedef struct kdivider_u64
+{
+    uint64_t d;
+    uint64_t magic;
+    uint8_t  shift1;
+    uint8_t  shift2;
+} kdivider_u64_t;
+
+typedef struct kdivider_s32
+{
+    int32_t  d;
+    uint32_t magic;
+    uint8_t  shift;
+} kdivider_s32_t;
+
+typedef struct kdivider_s64
+{
+    int64_t  d;
+    uint64_t magic;
+    uint8_t  shift;
+} kdivider_s64_t;
+
+/**
+ * Divide / modulo by divider created by kdivider_*_create, result is the same as for n / d and n % d.
+ * For signed dividers INT*_MIN / -1 wraps to INT*_MIN (native division traps).
+ *
+ * @param[in] n - dividend
+ * @param[in] div - pointer to divider
+ *
+ * @return n / d or n % d
+ *
+ * Example
+ * const kdivider_u64_t shards = kdivider_u64_create(nshards);
+ * for (size_t i = 0; i < nkeys; ++i)
+ *     shard[i] = KMOD_U64(hash[i], &shards);
+ */
+#define KDIV_U32(n, div)      kdivider_u32_div(n, div)
+#define KMOD_U32(n, div)      kdivider_u32_mod(n, div)
+#define KDIV_U64(n, div)      kdivider_u64_div(n, div)
+#define KMOD_U64(n, div)      kdivider_u64_mod(n, div)
+#define KDIV_S32(n, div)      kdivider_s32_div(n, div)
+#define KMOD_S32(n, div)      kdivider_s32_mod(n, div)
+#define KDIV_S64(n, div)      kdivider_s64_div(n, div)
+#define KMOD_S64(n, div)      kdivider_s64_mod(n, div)
+
+/**
+ * Batch versions: dst[i] = src[i] / d or src[i] % d, dst can be the same array as src.
+ * Divider is loaded once, so loop can be vectorized by compiler.
+ *
+ * @param[out] dst - output array of n elements
+ * @param[in] src - input array of n elements
+ * @param[in] n - number of elements
+ * @param[in] div - pointer to divider
+ */
+#define KDIV_U32_ARRAY(dst, src, n, div)      kdivider_u32_div_array(dst, src, n, div)
+#define KMOD_U32_ARRAY(dst, src, n, div)      kdivider_u32_mod_array(dst, src, n, div)
+#define KDIV_U64_ARRAY(dst, src, n, div)      kdivider_u64_div_array(dst, src, n, div)
+#define KMOD_U64_ARRAY(dst, src, n, div)      kdivider_u64_mod_array(dst, src, n, div)
+
+static inline kdivider_u32_t kdivider_u32_create(uint32_t d);
+static inline kdivider_u64_t kdivider_u64_create(uint64_t d);
+static inline kdivider_s32_t kdivider_s32_create(int32_t d);
+static inline kdivider_s64_t kdivider_s64_create(int64_t d);
+
+static inline uint32_t kdivider_u32_div(uint32_t n, const kdivider_u32_t *div);
+static inline uint32_t kdivider_u32_mod(uint32_t n, const kdivider_u32_t *div);
+static inline uint64_t kdivider_u64_div(uint64_t n, const kdivider_u64_t *div);
+static inline uint64_t kdivider_u64_mod(uint64_t n, const kdivider_u64_t *div);
+static inline int32_t kdivider_s32_div(int32_t n, const kdivider_s32_t *div);
+static inline int32_t kdivider_s32_mod(int32_t n, const kdivider_s32_t *div);
+static inline int64_t kdivider_s64_div(int64_t n, const kdivider_s64_t *div);
+static inline int64_t kdivider_s64_mod(int64_t n, const kdivider_s64_t *div);
+
+static inline void kdivider_u32_div_array(uint32_t *dst, const uint32_t *src, size_t n, const kdivider_u32_t *div);
+static inline void kdivider_u32_mod_array(uint32_t *dst, const uint32_t *src, size_t n, const kdivider_u32_t *div);
+static inline void kdivider_u64_div_array(uint64_t *dst, const uint64_t *src, size_t n, const kdivider_u64_t *div);
+static inline void kdivider_u64_mod_array(uint64_t *dst, const uint64_t *src, size_t n, const kdivider_u64_t *div);
+
+/* Private helpers, do not use */
+static inline uint32_t __kdivider_u32_div(uint32_t n, uint32_t magic, unsigned int shift1, unsigned int shift2);
+static inline uint64_t __kdivider_u64_div(uint64_t n, uint64_t magic, unsigned int shift1, unsigned int shift2);
+static inline uint32_t __kdivider_sra32(uint32_t x, unsigned int s);
+static inline uint64_t __kdivider_sra64(uint64_t x, unsigned int s);
+
+static inline uint32_t __kdivider_u32_div(uint32_t n, uint32_t magic, unsigned int shift1, unsigned int shift2)
+{
+    const uint32_t t = (uint32_t)(((uint64_t)magic * n) >> 32);
+
+    return (t + ((n - t) >> shift1)) >> shift2;
+}
+
+static inline uint64_t __kdivider_u64_div(uint64_t n, uint64_t magic, unsigned int shift1, unsigned int shift2)
+{
+    const uint64_t t = kuint128_mulhi64(magic, n);
+
+    return (t + ((n - t) >> shift1)) >> shift2;
+}
+
+/* Arithmetic shift right of signed value kept in unsigned type (>> on negative value is implementation defined) */
+static inline uint32_t __kdivider_sra32(uint32_t x, unsigned int s)
+{
+    const uint32_t sign = 0 - (x >> 31);
+
+    return ((x ^ sign) >> s) ^ sign;
+}
+
+static inline uint64_t __kdivider_sra64(uint64_t x, unsigned int s)
+{
+    const uint64_t sign = 0 - (x >> 63);
+
+    return ((x ^ sign) >> s) ^ sign;
+}
+
+/**
+ * Create divider, it is computed once and can be used for any number of divisions
+ *
+ * @param[in] d - divisor, d != 0
+ *
+ * @return divider
+ */
+static inline kdivider_u32_t kdivider_u32_create(uint32_t d)
+{
+    const unsigned int l = (unsigned int)KLOG2_CEIL((unsigned int)d);
+    /* 2^l - d < 2^32, so product fits into 64 bits */
+    const uint64_t m = ((((uint64_t)1 << l) - d) << 32) / d + 1;
+
+    return (kdivider_u32_t){.d = d, .magic = (uint32_t)m, .shift1 = (uint8_t)(l < 1 ? l : 1), .shift2 = (uint8_t)(l < 1 ? 0 : l - 1)};
+}
+
+static inline kdivider_u64_t kdivider_u64_create(uint64_t d)
+{
+    const unsigned int l = (unsigned int)KLOG2_CEIL((unsigned long long)d);
+    /* (2^l - d) * 2^64 / d, 2^l - d < d so quotient fits into 64 bits, 2^64 mod 2^64 = 0 */
+    const uint64_t rem = (l == 64 ? 0 : (uint64_t)1 << l) - d;
+    const uint64_t m = kuint128_divrem64(kuint128_make(rem, 0), d, NULL) + 1;
+
+    return (kdivider_u64_t){.d = d, .magic = m, .shift1 = (uint8_t)(l < 1 ? l : 1), .shift2 = (uint8_t)(l < 1 ? 0 : l - 1)};
+}
+
+static inline kdivider_s32_t kdivider_s32_create(int32_t d)
+{
+    const uint32_t ad = d < 0 ? 0 - (uint32_t)d : (uint32_t)d;
+    /* l = max(ceil(log2(|d|)), 1) = floor(log2(|d| - 1)) + 1, in unsigned arithmetic */
+    const unsigned int l = ad <= 2 ? 1 : (unsigned int)KLOG2_FLOOR((unsigned int)(ad - 1)) + 1u;
+    /* subtracting 2^32 does nothing in 32-bit magic */
+    const uint64_t m = ((uint64_t)1 << (31 + l)) / ad + 1;
+
+    return (kdivider_s32_t){.d = d, .magic = (uint32_t)m, .shift = (uint8_t)(l - 1)};
+}
+
+static inline kdivider_s64_t kdivider_s64_create(int64_t d)
+{
+    const uint64_t ad = d < 0 ? 0 - (uint64_t)d : (uint64_t)d;
+    /* l = max(ceil(log2(|d|)), 1) = floor(log2(|d| - 1)) + 1, in unsigned arithmetic */
+    const unsigned int l = ad <= 2 ? 1 : (unsigned int)KLOG2_FLOOR((unsigned long long)(ad - 1)) + 1u;
+    /* for |d| = 1: 2^64 / 1 + 1 = 1 (mod 2^64), otherwise 2^(l - 1) < |d| so quotient fits into 64 bits */
+    const uint64_t m = ad == 1 ? 1 : kuint128_divrem64(kuint128_make((uint64_t)1 << (l - 1), 0), ad, NULL) + 1;
+
+    return (kdivider_s64_t){.d = d, .magic = m, .shift = (uint8_t)(l - 1)};
+}
+
+static inline uint32_t kdivider_u32_div(uint32_t n, const kdivider_u32_t *div)
+{
+    return __kdivider_u32_div(n, div->magic, div->shift1, div->shift2);
+}
+
+static inline uint32_t kdivider_u32_mod(uint32_t n, const kdivider_u32_t *div)
+{
+    return n - kdivider_u32_div(n, div) * div->d;
+}
+
+static inline uint64_t kdivider_u64_div(uint64_t n, const kdivider_u64_t *div)
+{
+    return __kdivider_u64_div(n, div->magic, div->shift1, div->shift2);
+}
+
+static inline uint64_t kdivider_u64_mod(uint64_t n, const kdivider_u64_t *div)
+{
+    return n - kdivider_u64_div(n, div) * div->d;
+}
+
+static inline int32_t kdivider_s32_div(int32_t n, const kdivider_s32_t *div)
+{
+    const uint32_t un = (uint32_t)n;
+    const uint32_t dsign = 0 - ((uint32_t)div->d >> 31);
+
+    /* n + mulsh(m, n), computed mod 2^32 */
+    const uint64_t p = (uint64_t)((int64_t)(int32_t)div->magic * n);
+    uint32_t q = un + (uint32_t)(p >> 32);
+
+    /* q - sign(n) rounds toward zero */
+    q = __kdivider_sra32(q, div->shift) + (un >> 31);
+
+    return (int32_t)((q ^ dsign) - dsign);
+}
+
+static inline int32_t kdivider_s32_mod(int32_t n, const kdivider_s32_t *div)
+{
+    return (int32_t)((uint32_t)n - (uint32_t)kdivider_s32_div(n, div) * (uint32_t)div->d);
+}
+
+static inline int64_t kdivider_s64_div(int64_t n, const kdivider_s64_t *div)
+{
+    const uint64_t un = (uint64_t)n;
+    const uint64_t m = div->magic;
+    const uint64_t dsign = 0 - ((uint64_t)div->d >> 63);
+
+    /* signed high part = unsigned high part - (m < 0 ? n : 0) - (n < 0 ? m : 0) */
+    uint64_t mulsh = kuint128_mulhi64(m, un);
+    mulsh -= (0 - (m >> 63)) & un;
+    mulsh -= (0 - (un >> 63)) & m;
+
+    uint64_t q = un + mulsh;
+    q = __kdivider_sra64(q, div->shift) + (un >> 63);
+
+    return (int64_t)((q ^ dsign) - dsign);
+}
+
+static inline int64_t kdivider_s64_mod(int64_t n, const kdivider_s64_t *div)
+{
+    return (int64_t)((uint64_t)n - (uint64_t)kdivider_s64_div(n, div) * (uint64_t)div->d);
+}
+
+static inline void kdivider_u32_div_array(uint32_t *dst, const uint32_t *src, size_t n, const kdivider_u32_t *div)
+{
+    const uint32_t magic = div->magic;
+    const unsigned int shift1 = div->shift1;
+    const unsigned int shift2 = div->shift2;
+
+    for (size_t i = 0; i < n; ++i)
+        dst[i] = __kdivider_u32_div(src[i], magic, shift1, shift2);
+}
+
+static inline void kdivider_u32_mod_array(uint32_t *dst, const uint32_t *src, size_t n, const kdivider_u32_t *div)
+{
+    const uint32_t d = div->d;
+    const uint32_t magic = div->magic;
+    const unsigned int shift1 = div->shift1;
+    const unsigned int shift2 = div->shift2;
+
+    for (size_t i = 0; i < n; ++i)
+        dst[i] = src[i] - __kdivider_u32_div(src[i], magic, shift1, shift2) * d;
+}
+
+static inline void kdivider_u64_div_array(uint64_t *dst, const uint64_t *src, size_t n, const kdivider_u64_t *div)
+{
+    const uint64_t magic = div->magic;
+    const unsigned int shift1 = div->shift1;
+    const unsigned int shift2 = div->shift2;
+
+    for (size_t i = 0; i < n; ++i)
+        dst[i] = __kdivider_u64_div(src[i], magic, shift1, shift2);
+}
+
+static inline void kdivider_u64_mod_array(uint64_t *dst, const uint64_t *src, size_t n, const kdivider_u64_t *div)
+{
+    const uint64_t d = div->d;
+    const uint64_t magic = div->magic;
+    const unsigned int shift1 = div->shift1;
+    const unsigned int shift2 = div->shift2;
+
+    for (size_t i = 0; i < n; ++i)
+        dst[i] = src[i] - __kdivider_u64_div(src[i], magic, shift1, shift2) * d;
+}
+
+#endif
@@ -0,0 +1,241 @@
+#ifndef KFUTEX_H
+#define KFUTEX_H
+
+/*
+    This is the public header for the KFutex.
+
+    Sleeping synchronization primitives on Linux futex(2), for places where spinning is wrong
+    (long critical sections, more threads than CPUs). Uncontended paths are single atomic operation
+    and never enter the kernel, syscall is made only to sleep or to wake sleeping thread.
+
+    kfutex_mutex - mutex with 3 states (Ulrich Drepper, "Futexes Are Tricky"):
+                   0 - unlocked, 1 - locked without waiters, 2 - locked, maybe with waiters.
+                   Unlock calls FUTEX_WAKE only in state 2.
+    kfutex_event - manual reset event: kfutex_event_wait sleeps until kfutex_event_set, event stays set
+                   until kfutex_event_reset. Set wakes all waiters, but only when someone waits.
+    kfutex_latch - countdown latch: kfutex_latch_wait sleeps until counter drops to 0.
+
+    All primitives are process private (FUTEX_PRIVATE_FLAG) and 4 bytes big (+ 4 for latch).
+
+    syscall(2) is hidden in strict ISO C mode (-std=c11), so compile with -std=gnu11 or newer
+    or define _DEFAULT_SOURCE for whole translation unit.
+
+    Include it directly: #include <kmacros/kfutex.h>
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE: GPL3
+*/
+
+#include "kmacros.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#ifndef SYS_futex
+#error "KFutex needs Linux futex(2) (SYS_futex)"
+#endif
+
+/* libc declares syscall only with BSD / GNU extensions, they are off in strict ISO C mode without feature macros */
+#if defined(__STRICT_ANSI__) && !defined(_DEFAULT_SOURCE) && !defined(_GNU_SOURCE) && !defined(_BSD_SOURCE)
+#error "KFutex needs syscall(2), compile with -std=gnu11 or define _DEFAULT_SOURCE"
+#endif
+
+typedef struct kfutex_mutex
+{
+    KATOMIC(uint32_t) state;
+} kfutex_mutex_t;
+
+typedef struct kfutex_event
+{
+    KATOMIC(uint32_t) state; /* 0 - not set, 1 - set, 2 - not set with waiters */
+} kfutex_event_t;
+
+typedef struct kfutex_latch
+{
+    KATOMIC(uint32_t) count;
+    KATOMIC(uint32_t) waiters;
+} kfutex_latch_t;
+
+#define KFUTEX_MUTEX_INIT       {.state = 0}
+#define KFUTEX_EVENT_INIT       {.state = 0}
+#define KFUTEX_LATCH_INIT(n)    {.count = (n), .waiters = 0}
+
+static inline void kfutex_mutex_init(kfutex_mutex_t *mutex);
+static inline bool kfutex_mutex_trylock(kfutex_mutex_t *mutex);
+static inline void kfutex_mutex_lock(kfutex_mutex_t *mutex);
+static inline void kfutex_mutex_unlock(kfutex_mutex_t *mutex);
+
+static inline void kfutex_event_init(kfutex_event_t *event);
+static inline bool kfutex_event_is_set(const kfutex_event_t *event);
+static inline void kfutex_event_wait(kfutex_event_t *event);
+static inline void kfutex_event_set(kfutex_event_t *event);
+static inline void kfutex_event_reset(kfutex_event_t *event);
+
+static inline void kfutex_latch_init(kfutex_latch_t *latch, uint32_t count);
+static inline void kfutex_latch_count_down(kfutex_latch_t *latch, uint32_t n);
+static inline bool kfutex_latch_try_wait(const kfutex_latch_t *latch);
+static inline void kfutex_latch_wait(kfutex_latch_t *latch);
+
+/* Private helpers, do not use */
+static inline void __kfutex_wait(KATOMIC(uint32_t) *addr, uint32_t val);
+static inline void __kfutex_wake(KATOMIC(uint32_t) *addr, int count);
+static inline void __kfutex_mutex_lock_slow(kfutex_mutex_t *mutex, uint32_t state);
+
+/* Sleep while *addr == val. Spurious wake up (EINTR) and EAGAIN are fine, callers check state in loop */
+static inline void __kfutex_wait(KATOMIC(uint32_t) *addr, uint32_t val)
+{
+    (void)syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+}
+
+static inline void __kfutex_wake(KATOMIC(uint32_t) *addr, int count)
+{
+    (void)syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+static inline void kfutex_mutex_init(kfutex_mutex_t *mutex)
+{
+    KATOMIC_STORE(&mutex->state, 0, KATOMIC_RELAXED);
+}
+
+/**
+ * Try to take mutex without sleeping
+ *
+ * @return true when mutex has been taken
+ */
+static inline bool kfutex_mutex_trylock(kfutex_mutex_t *mutex)
+{
+    uint32_t state = 0;
+
+    return KATOMIC_CAS(&mutex->state, &state, 1, KATOMIC_ACQUIRE, KATOMIC_RELAXED);
+}
+
+static inline void __kfutex_mutex_lock_slow(kfutex_mutex_t *mutex, uint32_t state)
+{
+    /* mark mutex as contended, so owner will wake us, and sleep until we get it in state 0 */
+    if (state != 2)
+        state = KATOMIC_EXCHANGE(&mutex->state, 2, KATOMIC_ACQUIRE);
+
+    while (state != 0)
+    {
+        __kfutex_wait(&mutex->state, 2);
+        state = KATOMIC_EXCHANGE(&mutex->state, 2, KATOMIC_ACQUIRE);
+    }
+}
+
+static inline void kfutex_mutex_lock(kfutex_mutex_t *mutex)
+{
+    uint32_t state = 0;
+
+    if (KLIKELY(KATOMIC_CAS(&mutex->state, &state, 1, KATOMIC_ACQUIRE, KATOMIC_RELAXED)))
+        return;
+
+    __kfutex_mutex_lock_slow(mutex, state);
+}
+
+static inline void kfutex_mutex_unlock(kfutex_mutex_t *mutex)
+{
+    if (KLIKELY(KATOMIC_FETCH_SUB(&mutex->state, 1, KATOMIC_RELEASE) == 1))
+        return;
+
+    /* state was 2, someone may sleep */
+    KATOMIC_STORE(&mutex->state, 0, KATOMIC_RELEASE);
+    __kfutex_wake(&mutex->state, 1);
+}
+
+static inline void kfutex_event_init(kfutex_event_t *event)
+{
+    KATOMIC_STORE(&event->state, 0, KATOMIC_RELAXED);
+}
+
+static inline bool kfutex_event_is_set(const kfutex_event_t *event)
+{
+    return KATOMIC_LOAD(&event->state, KATOMIC_ACQUIRE) == 1;
+}
+
+/**
+ * Sleep until event is set, return immediately when event is already set
+ */
+static inline void kfutex_event_wait(kfutex_event_t *event)
+{
+    uint32_t state = KATOMIC_LOAD(&event->state, KATOMIC_ACQUIRE);
+
+    while (state != 1)
+    {
+        /* announce waiter (0 -> 2), CAS failure loads current state */
+        if (state == 2 || KATOMIC_CAS(&event->state, &state, 2, KATOMIC_ACQUIRE, KATOMIC_ACQUIRE))
+        {
+            __kfutex_wait(&event->state, 2);
+            state = KATOMIC_LOAD(&event->state, KATOMIC_ACQUIRE);
+        }
+    }
+}
+
+/**
+ * Set event and wake all waiters
+ */
+static inline void kfutex_event_set(kfutex_event_t *event)
+{
+    if (KUNLIKELY(KATOMIC_EXCHANGE(&event->state, 1, KATOMIC_RELEASE) == 2))
+        __kfutex_wake(&event->state, INT_MAX);
+}
+
+/**
+ * Clear event, next kfutex_event_wait will sleep
+ */
+static inline void kfutex_event_reset(kfutex_event_t *event)
+{
+    uint32_t state = 1;
+
+    (void)KATOMIC_CAS(&event->state, &state, 0, KATOMIC_RELAXED, KATOMIC_RELAXED);
+}
+
+static inline void kfutex_latch_init(kfutex_latch_t *latch, uint32_t count)
+{
+    KATOMIC_STORE(&latch->count, count, KATOMIC_RELAXED);
+    KATOMIC_STORE(&latch->waiters, 0, KATOMIC_RELAXED);
+}
+
+/**
+ * Decrease counter by n, the last count down wakes all waiters.
+ * Counter cannot go below 0, so n has to be <= current counter
+ */
+static inline void kfutex_latch_count_down(kfutex_latch_t *latch, uint32_t n)
+{
+    /* seq_cst pairs with waiter: either waiter sees count 0 or we see waiter */
+    if (KATOMIC_FETCH_SUB(&latch->count, n, KATOMIC_SEQ_CST) != n)
+        return;
+
+    if (KATOMIC_LOAD(&latch->waiters, KATOMIC_SEQ_CST) != 0)
+        __kfutex_wake(&latch->count, INT_MAX);
+}
+
+/**
+ * @return true when counter is 0
+ */
+static inline bool kfutex_latch_try_wait(const kfutex_latch_t *latch)
+{
+    return KATOMIC_LOAD(&latch->count, KATOMIC_ACQUIRE) == 0;
+}
+
+/**
+ * Sleep until counter drops to 0
+ */
+static inline void kfutex_latch_wait(kfutex_latch_t *latch)
+{
+    uint32_t count;
+
+    while ((count = KATOMIC_LOAD(&latch->count, KATOMIC_ACQUIRE)) != 0)
+    {
+        (void)KATOMIC_FETCH_ADD(&latch->waiters, 1, KATOMIC_SEQ_CST);
+        __kfutex_wait(&latch->count, count);
+        (void)KATOMIC_FETCH_SUB(&latch->waiters, 1, KATOMIC_RELAXED);
+    }
+}
+
+#endif
@@ -0,0 +1,351 @@
+#ifndef KINT128_H
+#define KINT128_H
+
+/*
+    This is the public header for the KInt128.
+
+    KInt128 is unsigned 128-bit integer arithmetic.
+    With GNU C (compiler supports unsigned __int128) kuint128_t is unsigned __int128 and every function
+    is a single operator, so there is no overhead. Otherwise kuint128_t is a struct with 2 64-bit limbs.
+    Define KINT128_PORTABLE before include to always use limbs.
+
+    Value of kuint128_t should be used only by functions from this header, so code works on both paths.
+
+    Include it directly: #include <kmacros/kint128.h>
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE: GPL3
+*/
+
+#include "kmacros.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(KCOMPILER_HAS_INT128) && !defined(KINT128_PORTABLE)
+#define KINT128_NATIVE
+#endif
+
+#ifdef KINT128_NATIVE
+__extension__ typedef unsigned __int128 kuint128_t;
+#else
+typedef struct kuint128
+{
+    uint64_t lo;
+    uint64_t hi;
+} kuint128_t;
+#endif
+
+static inline kuint128_t kuint128_make(uint64_t hi, uint64_t lo);
+static inline kuint128_t kuint128_from64(uint64_t x);
+static inline uint64_t kuint128_lo(kuint128_t a);
+static inline uint64_t kuint128_hi(kuint128_t a);
+
+static inline kuint128_t kuint128_add(kuint128_t a, kuint128_t b);
+static inline kuint128_t kuint128_sub(kuint128_t a, kuint128_t b);
+static inline kuint128_t kuint128_add_carry(kuint128_t a, kuint128_t b, bool carry_in, bool *carry_out);
+static inline kuint128_t kuint128_sub_borrow(kuint128_t a, kuint128_t b, bool borrow_in, bool *borrow_out);
+
+static inline kuint128_t kuint128_mul64(uint64_t x, uint64_t y);
+static inline uint64_t kuint128_mulhi64(uint64_t x, uint64_t y);
+static inline kuint128_t kuint128_mul(kuint128_t a, kuint128_t b);
+static inline kuint128_t kuint128_mulhi(kuint128_t a, kuint128_t b);
+static inline uint64_t kuint128_divrem64(kuint128_t n, uint64_t d, uint64_t *rem);
+
+static inline kuint128_t kuint128_shl(kuint128_t a, unsigned int n);
+static inline kuint128_t kuint128_shr(kuint128_t a, unsigned int n);
+static inline int kuint128_clz(kuint128_t a);
+static inline int kuint128_ctz(kuint128_t a);
+
+static inline int kuint128_cmp(kuint128_t a, kuint128_t b);
+static inline bool kuint128_eq(kuint128_t a, kuint128_t b);
+static inline bool kuint128_lt(kuint128_t a, kuint128_t b);
+
+/**
+ * Create value hi * 2^64 + lo
+ */
+static inline kuint128_t kuint128_make(uint64_t hi, uint64_t lo)
+{
+#ifdef KINT128_NATIVE
+    return ((kuint128_t)hi << 64) | lo;
+#else
+    return (kuint128_t){.lo = lo, .hi = hi};
+#endif
+}
+
+static inline kuint128_t kuint128_from64(uint64_t x)
+{
+    return kuint128_make(0, x);
+}
+
+/**
+ * Low and high 64 bits of value
+ */
+static inline uint64_t kuint128_lo(kuint128_t a)
+{
+#ifdef KINT128_NATIVE
+    return (uint64_t)a;
+#else
+    return a.lo;
+#endif
+}
+
+static inline uint64_t kuint128_hi(kuint128_t a)
+{
+#ifdef KINT128_NATIVE
+    return (uint64_t)(a >> 64);
+#else
+    return a.hi;
+#endif
+}
+
+/**
+ * a + b and a - b mod 2^128
+ */
+static inline kuint128_t kuint128_add(kuint128_t a, kuint128_t b)
+{
+#ifdef KINT128_NATIVE
+    return a + b;
+#else
+    const uint64_t lo = a.lo + b.lo;
+
+    return kuint128_make(a.hi + b.hi + (lo < a.lo), lo);
+#endif
+}
+
+static inline kuint128_t kuint128_sub(kuint128_t a, kuint128_t b)
+{
+#ifdef KINT128_NATIVE
+    return a - b;
+#else
+    return kuint128_make(a.hi - b.hi - (a.lo < b.lo), a.lo - b.lo);
+#endif
+}
+
+/**
+ * Add with carry: a + b + carry_in, carry_out is set when result does not fit into 128 bits.
+ * Chain of calls adds numbers wider than 128 bits.
+ *
+ * @param[in] a - first value
+ * @param[in] b - second value
+ * @param[in] carry_in - carry from previous (less significant) addition
+ * @param[out] carry_out - carry to next (more significant) addition
+ *
+ * @return a + b + carry_in mod 2^128
+ */
+static inline kuint128_t kuint128_add_carry(kuint128_t a, kuint128_t b, bool carry_in, bool *carry_out)
+{
+    const kuint128_t s = kuint128_add(a, b);
+    const kuint128_t r = kuint128_add(s, kuint128_from64(carry_in));
+
+    *carry_out = kuint128_lt(s, a) || kuint128_lt(r, s);
+
+    return r;
+}
+
+/**
+ * Subtract with borrow: a - b - borrow_in, borrow_out is set when b + borrow_in > a.
+ *
+ * @param[in] a - first value
+ * @param[in] b - second value
+ * @param[in] borrow_in - borrow from previous (less significant) subtraction
+ * @param[out] borrow_out - borrow to next (more significant) subtraction
+ *
+ * @return a - b - borrow_in mod 2^128
+ */
+static inline kuint128_t kuint128_sub_borrow(kuint128_t a, kuint128_t b, bool borrow_in, bool *borrow_out)
+{
+    const kuint128_t d = kuint128_sub(a, b);
+    const kuint128_t r = kuint128_sub(d, kuint128_from64(borrow_in));
+
+    *borrow_out = kuint128_lt(a, b) || kuint128_lt(d, kuint128_from64(borrow_in));
+
+    return r;
+}
+
+/**
+ * Full product of 2 64-bit values (64x64 -> 128)
+ */
+static inline kuint128_t kuint128_mul64(uint64_t x, uint64_t y)
+{
+#ifdef KINT128_NATIVE
+    return (kuint128_t)x * y;
+#else
+    uint64_t hi;
+    const uint64_t lo = __kmul64_wide_limbs(x, y, &hi);
+
+    return kuint128_make(hi, lo);
+#endif
+}
+
+/**
+ * High 64 bits of 64x64 product (mulhi), used by fixed-point and division by multiplication
+ */
+static inline uint64_t kuint128_mulhi64(uint64_t x, uint64_t y)
+{
+    return kuint128_hi(kuint128_mul64(x, y));
+}
+
+/**
+ * a * b mod 2^128
+ */
+static inline kuint128_t kuint128_mul(kuint128_t a, kuint128_t b)
+{
+#ifdef KINT128_NATIVE
+    return a * b;
+#else
+    const kuint128_t ll = kuint128_mul64(a.lo, b.lo);
+
+    return kuint128_make(ll.hi + a.lo * b.hi + a.hi * b.lo, ll.lo);
+#endif
+}
+
+/**
+ * High 128 bits of 128x128 product
+ */
+static inline kuint128_t kuint128_mulhi(kuint128_t a, kuint128_t b)
+{
+    const uint64_t a_lo = kuint128_lo(a);
+    const uint64_t a_hi = kuint128_hi(a);
+    const uint64_t b_lo = kuint128_lo(b);
+    const uint64_t b_hi = kuint128_hi(b);
+
+    const kuint128_t ll = kuint128_mul64(a_lo, b_lo);
+    const kuint128_t lh = kuint128_mul64(a_lo, b_hi);
+    const kuint128_t hl = kuint128_mul64(a_hi, b_lo);
+    const kuint128_t hh = kuint128_mul64(a_hi, b_hi);
+
+    /* bits [64; 191] of product, carry goes to the highest limb */
+    bool carry1;
+    bool carry2;
+    kuint128_t mid = kuint128_add_carry(lh, hl, false, &carry1);
+    mid = kuint128_add_carry(mid, kuint128_from64(kuint128_hi(ll)), false, &carry2);
+
+    const kuint128_t high = kuint128_make((uint64_t)carry1 + (uint64_t)carry2, kuint128_hi(mid));
+
+    return kuint128_add(hh, high);
+}
+
+/**
+ * Division 128 / 64 -> 64 (like x86 div instruction)
+ *
+ * @param[in] n - dividend, high 64 bits of n have to be smaller than d (quotient fits into 64 bits)
+ * @param[in] d - divisor, d != 0
+ * @param[out] rem - remainder (can be NULL)
+ *
+ * @return quotient n / d
+ */
+static inline uint64_t kuint128_divrem64(kuint128_t n, uint64_t d, uint64_t *rem)
+{
+#ifdef KINT128_NATIVE
+    const uint64_t q = (uint64_t)(n / d);
+
+    if (rem != NULL)
+        *rem = (uint64_t)(n % d);
+
+    return q;
+#else
+    /* restoring division, r < d is invariant so r * 2 + bit needs 65 bits (top bit is kept in flag) */
+    uint64_t r = n.hi;
+    uint64_t q = 0;
+
+    for (int i = 63; i >= 0; --i)
+    {
+        const bool top = (r >> 63) != 0;
+        r = (r << 1) | ((n.lo >> i) & 1u);
+
+        const bool ge = top || r >= d;
+        r -= ge ? d : 0;
+        q |= (uint64_t)ge << i;
+    }
+
+    if (rem != NULL)
+        *rem = r;
+
+    return q;
+#endif
+}
+
+/**
+ * Shifts, valid n is [0; 127]
+ */
+static inline kuint128_t kuint128_shl(kuint128_t a, unsigned int n)
+{
+#ifdef KINT128_NATIVE
+    return a << n;
+#else
+    if (n == 0)
+        return a;
+
+    if (n >= 64)
+        return kuint128_make(a.lo << (n - 64), 0);
+
+    return kuint128_make((a.hi << n) | (a.lo >> (64 - n)), a.lo << n);
+#endif
+}
+
+static inline kuint128_t kuint128_shr(kuint128_t a, unsigned int n)
+{
+#ifdef KINT128_NATIVE
+    return a >> n;
+#else
+    if (n == 0)
+        return a;
+
+    if (n >= 64)
+        return kuint128_make(0, a.hi >> (n - 64));
+
+    return kuint128_make(a.hi >> n, (a.lo >> n) | (a.hi << (64 - n)));
+#endif
+}
+
+/**
+ * Count leading / trailing zeros, like KCLZLL and KCTZLL a has to be != 0
+ */
+static inline int kuint128_clz(kuint128_t a)
+{
+    const uint64_t hi = kuint128_hi(a);
+
+    return hi != 0 ? KCLZLL(hi) : 64 + KCLZLL(kuint128_lo(a));
+}
+
+static inline int kuint128_ctz(kuint128_t a)
+{
+    const uint64_t lo = kuint128_lo(a);
+
+    return lo != 0 ? KCTZLL(lo) : 64 + KCTZLL(kuint128_hi(a));
+}
+
+/**
+ * Compare values
+ *
+ * @return -1 when a < b, 0 when a == b, 1 when a > b
+ */
+static inline int kuint128_cmp(kuint128_t a, kuint128_t b)
+{
+    const bool lt = kuint128_lt(a, b);
+    const bool gt = kuint128_lt(b, a);
+
+    return (int)gt - (int)lt;
+}
+
+static inline bool kuint128_eq(kuint128_t a, kuint128_t b)
+{
+#ifdef KINT128_NATIVE
+    return a == b;
+#else
+    return a.lo == b.lo && a.hi == b.hi;
+#endif
+}
+
+static inline bool kuint128_lt(kuint128_t a, kuint128_t b)
+{
+#ifdef KINT128_NATIVE
+    return a < b;
+#else
+    return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo);
+#endif
+}
+
+#endif
@@ -0,0 +1,249 @@
+#ifndef KLOCK_H
+#define KLOCK_H
+
+/*
+    This is the public header for the KLock.
+
+    Busy waiting locks for very short critical sections, built on KATOMIC_* from kcompiler headers:
+
+    kspinlock   - test and test and set spinlock. Waiting thread reads lock (cache line stays shared)
+                  and tries exchange only when lock looks free. Between reads it waits with exponential backoff
+                  (KCPU_RELAX), after KLOCK_BACKOFF_MAX it gives CPU to other threads (sched_yield).
+    kticketlock - fair (FIFO) ticket lock. Thread takes ticket by fetch add and waits until owner == ticket.
+    kseqlock    - sequence lock for read mostly data. Readers do not write to shared memory at all,
+                  they only read sequence before and after reading data and retry when writer was active.
+                  Writers are serialized by kspinlock.
+
+    Every lock is aligned (and so padded) to cache line (_Alignas), so lock does not share line with
+    data of other locks. Uncontended path is a single atomic operation under KLIKELY.
+
+    Include it directly: #include <kmacros/klock.h>
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE: GPL3
+*/
+
+#include "kmacros.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sched.h>
+
+/* Define before include to change the longest backoff (KCPU_RELAX calls) before sched_yield */
+#ifndef KLOCK_BACKOFF_MAX
+#define KLOCK_BACKOFF_MAX       1024u
+#endif
+
+typedef struct kspinlock
+{
+    _Alignas(KCACHE_LINE_SIZE) KATOMIC(uint32_t) locked;
+} kspinlock_t;
+
+typedef struct kticketlock
+{
+    _Alignas(KCACHE_LINE_SIZE) KATOMIC(uint32_t) next;
+    KATOMIC(uint32_t) owner;
+} kticketlock_t;
+
+typedef struct kseqlock
+{
+    /* readers touch only this line */
+    _Alignas(KCACHE_LINE_SIZE) KATOMIC(uint32_t) seq;
+    kspinlock_t writer;
+} kseqlock_t;
+
+#define KSPINLOCK_INIT      {.locked = 0}
+#define KTICKETLOCK_INIT    {.next = 0, .owner = 0}
+#define KSEQLOCK_INIT       {.seq = 0, .writer = KSPINLOCK_INIT}
+
+static inline void kspinlock_init(kspinlock_t *lock);
+static inline bool kspinlock_trylock(kspinlock_t *lock);
+static inline void kspinlock_lock(kspinlock_t *lock);
+static inline void kspinlock_unlock(kspinlock_t *lock);
+
+static inline void kticketlock_init(kticketlock_t *lock);
+static inline bool kticketlock_trylock(kticketlock_t *lock);
+static inline void kticketlock_lock(kticketlock_t *lock);
+static inline void kticketlock_unlock(kticketlock_t *lock);
+
+static inline void kseqlock_init(kseqlock_t *lock);
+static inline uint32_t kseqlock_read_begin(const kseqlock_t *lock);
+static inline bool kseqlock_read_retry(const kseqlock_t *lock, uint32_t seq);
+static inline void kseqlock_write_begin(kseqlock_t *lock);
+static inline void kseqlock_write_end(kseqlock_t *lock);
+
+/* Private helpers, do not use */
+static inline uint32_t __klock_backoff(uint32_t backoff);
+static inline void __kspinlock_lock_slow(kspinlock_t *lock);
+
+/* Wait backoff KCPU_RELAX and return next backoff, the longest one gives CPU to other threads */
+static inline uint32_t __klock_backoff(uint32_t backoff)
+{
+    if (backoff >= KLOCK_BACKOFF_MAX)
+    {
+        (void)sched_yield();
+        return backoff;
+    }
+
+    for (uint32_t i = 0; i < backoff; ++i)
+        KCPU_RELAX();
+
+    return backoff << 1;
+}
+
+static inline void kspinlock_init(kspinlock_t *lock)
+{
+    KATOMIC_STORE(&lock->locked, 0, KATOMIC_RELAXED);
+}
+
+/**
+ * Try to take lock without waiting
+ *
+ * @return true when lock has been taken
+ */
+static inline bool kspinlock_trylock(kspinlock_t *lock)
+{
+    return KATOMIC_LOAD(&lock->locked, KATOMIC_RELAXED) == 0 &&
+           KATOMIC_EXCHANGE(&lock->locked, 1, KATOMIC_ACQUIRE) == 0;
+}
+
+static inline void __kspinlock_lock_slow(kspinlock_t *lock)
+{
+    uint32_t backoff = 1;
+
+    do
+    {
+        /* read only loop, line is not stolen from owner until lock looks free */
+        while (KATOMIC_LOAD(&lock->locked, KATOMIC_RELAXED) != 0)
+            backoff = __klock_backoff(backoff);
+    } while (KATOMIC_EXCHANGE(&lock->locked, 1, KATOMIC_ACQUIRE) != 0);
+}
+
+static inline void kspinlock_lock(kspinlock_t *lock)
+{
+    if (KLIKELY(KATOMIC_EXCHANGE(&lock->locked, 1, KATOMIC_ACQUIRE) == 0))
+        return;
+
+    __kspinlock_lock_slow(lock);
+}
+
+static inline void kspinlock_unlock(kspinlock_t *lock)
+{
+    KATOMIC_STORE(&lock->locked, 0, KATOMIC_RELEASE);
+}
+
+static inline void kticketlock_init(kticketlock_t *lock)
+{
+    KATOMIC_STORE(&lock->next, 0, KATOMIC_RELAXED);
+    KATOMIC_STORE(&lock->owner, 0, KATOMIC_RELAXED);
+}
+
+/**
+ * Try to take lock without waiting (only when nobody waits, so FIFO order is kept)
+ *
+ * @return true when lock has been taken
+ */
+static inline bool kticketlock_trylock(kticketlock_t *lock)
+{
+    uint32_t ticket = KATOMIC_LOAD(&lock->owner, KATOMIC_RELAXED);
+
+    return KATOMIC_CAS(&lock->next, &ticket, ticket + 1, KATOMIC_ACQUIRE, KATOMIC_RELAXED);
+}
+
+static inline void kticketlock_lock(kticketlock_t *lock)
+{
+    const uint32_t ticket = KATOMIC_FETCH_ADD(&lock->next, 1, KATOMIC_RELAXED);
+
+    if (KLIKELY(KATOMIC_LOAD(&lock->owner, KATOMIC_ACQUIRE) == ticket))
+        return;
+
+    uint32_t backoff = 1;
+    uint32_t owner;
+    while ((owner = KATOMIC_LOAD(&lock->owner, KATOMIC_ACQUIRE)) != ticket)
+    {
+        /* the first waiter spins, others give CPU to owner, because they wait for many critical sections */
+        if (ticket - owner > 1)
+            (void)sched_yield();
+        else
+            backoff = __klock_backoff(backoff);
+    }
+}
+
+static inline void kticketlock_unlock(kticketlock_t *lock)
+{
+    /* only owner writes owner field */
+    const uint32_t owner = KATOMIC_LOAD(&lock->owner, KATOMIC_RELAXED);
+
+    KATOMIC_STORE(&lock->owner, owner + 1, KATOMIC_RELEASE);
+}
+
+static inline void kseqlock_init(kseqlock_t *lock)
+{
+    KATOMIC_STORE(&lock->seq, 0, KATOMIC_RELAXED);
+    kspinlock_init(&lock->writer);
+}
+
+/**
+ * Start reading data, waits while writer is active
+ *
+ * Example:
+ * uint32_t seq;
+ * do
+ * {
+ *     seq = kseqlock_read_begin(&lock);
+ *     memcpy(&copy, &stats, sizeof(copy));
+ * } while (kseqlock_read_retry(&lock, seq));
+ *
+ * Use data only after kseqlock_read_retry returned false, copy can be torn before
+ *
+ * @return sequence to pass to kseqlock_read_retry
+ */
+static inline uint32_t kseqlock_read_begin(const kseqlock_t *lock)
+{
+    uint32_t seq = KATOMIC_LOAD(&lock->seq, KATOMIC_ACQUIRE);
+
+    uint32_t backoff = 1;
+    while (KUNLIKELY(seq & 1u))
+    {
+        backoff = __klock_backoff(backoff);
+        seq = KATOMIC_LOAD(&lock->seq, KATOMIC_ACQUIRE);
+    }
+
+    return seq;
+}
+
+/**
+ * Finish reading data
+ *
+ * @return true when writer changed data during read, so read has to be repeated
+ */
+static inline bool kseqlock_read_retry(const kseqlock_t *lock, uint32_t seq)
+{
+    /* reads of data cannot be moved after seq load */
+    KATOMIC_THREAD_FENCE(KATOMIC_ACQUIRE);
+
+    return KUNLIKELY(KATOMIC_LOAD(&lock->seq, KATOMIC_RELAXED) != seq);
+}
+
+static inline void kseqlock_write_begin(kseqlock_t *lock)
+{
+    kspinlock_lock(&lock->writer);
+
+    const uint32_t seq = KATOMIC_LOAD(&lock->seq, KATOMIC_RELAXED);
+    KATOMIC_STORE(&lock->seq, seq + 1, KATOMIC_RELAXED);
+
+    /* odd seq is visible before any write of data */
+    KATOMIC_THREAD_FENCE(KATOMIC_RELEASE);
+}
+
+static inline void kseqlock_write_end(kseqlock_t *lock)
+{
+    const uint32_t seq = KATOMIC_LOAD(&lock->seq, KATOMIC_RELAXED);
+    KATOMIC_STORE(&lock->seq, seq + 1, KATOMIC_RELEASE);
+
+    kspinlock_unlock(&lock->writer);
+}
+
+#endif
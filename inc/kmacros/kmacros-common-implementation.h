@@ -2,6 +2,7 @@
 #define KMACROS_COMMON_IMPLEMENTATION_H
 
 #include <limits.h>
+#include <stdint.h>
 #include <stdio.h>
 
 #include "kcompiler.h"
@@ -44,6 +45,11 @@ static inline unsigned int kround_power2_down_uint(unsigned int n);
 static inline unsigned long kround_power2_down_ulong(unsigned long n);
 static inline unsigned long long kround_power2_down_ulonglong(unsigned long long n);
 
+static inline uint32_t kfastrange32(uint32_t hash, uint32_t n);
+static inline uint64_t kfastrange64(uint64_t hash, uint64_t n);
+static inline uint32_t kbucket_index_pow2_32(uint32_t hash, uint32_t n);
+static inline uint64_t kbucket_index_pow2_64(uint64_t hash, uint64_t n);
+
 static inline bool kis_power2_uint(unsigned int n)
 {
     return KPOPCOUNT(n) == 1;
@@ -61,17 +67,20 @@ static inline bool kis_power2_ulonglong(unsigned long long n)
 
 static inline int klog2_ceil_uint(unsigned int n)
 {
-    return n == 0? -1 : klog2_floor_uint(n) + !kis_power2_uint(n);
+    /* ceil(log2(n)) = floor(log2(n - 1)) + 1 for n >= 2, single clz instead of clz and popcount */
+    return n <= 1? (n == 0? -1 : 0) : klog2_floor_uint(n - 1) + 1;
 }
 
 static inline long klog2_ceil_ulong(unsigned long n)
 {
-    return n == 0? -1 : klog2_floor_ulong(n) + !kis_power2_ulong(n);
+    /* ceil(log2(n)) = floor(log2(n - 1)) + 1 for n >= 2, single clz instead of clz and popcount */
+    return n <= 1? (n == 0? -1 : 0) : klog2_floor_ulong(n - 1) + 1;
 }
 
 static inline long long klog2_ceil_ulonglong(unsigned long long n)
 {
-    return n == 0? -1 : klog2_floor_ulonglong(n) + !kis_power2_ulonglong(n);
+    /* ceil(log2(n)) = floor(log2(n - 1)) + 1 for n >= 2, single clz instead of clz and popcount */
+    return n <= 1? (n == 0? -1 : 0) : klog2_floor_ulonglong(n - 1) + 1;
 }
 
 static inline int klog2_floor_uint(unsigned int n)
@@ -119,39 +128,100 @@ static inline unsigned long long kround_power2_down_ulonglong(unsigned long long
     return n == 0? 0 : 1ull << klog2_floor_ulonglong(n);
 }
 
+static inline uint32_t kfastrange32(uint32_t hash, uint32_t n)
+{
+    return (uint32_t)(((uint64_t)hash * n) >> 32);
+}
+
+static inline uint64_t kfastrange64(uint64_t hash, uint64_t n)
+{
+    uint64_t hi;
+    (void)__kmul64_wide(hash, n, &hi);
+
+    return hi;
+}
+
+/* n = 2^k: (hash * 2^k) >> width = hash >> (width - k), 2 shifts because k = 0 would need shift by width */
+static inline uint32_t kbucket_index_pow2_32(uint32_t hash, uint32_t n)
+{
+    return (hash >> 1) >> (31 - KCTZ(n));
+}
+
+static inline uint64_t kbucket_index_pow2_64(uint64_t hash, uint64_t n)
+{
+    return (hash >> 1) >> (63 - KCTZLL(n));
+}
+
+/* Number of k in [k0; k0 + 7] for which n >> k != 0 */
+#define KLOG2_CONST_PRIV_COUNT8(n, k0) \
+    (((n) >> ((k0) + 0) != 0) + ((n) >> ((k0) + 1) != 0) + ((n) >> ((k0) + 2) != 0) + ((n) >> ((k0) + 3) != 0) + \
+     ((n) >> ((k0) + 4) != 0) + ((n) >> ((k0) + 5) != 0) + ((n) >> ((k0) + 6) != 0) + ((n) >> ((k0) + 7) != 0))
+
+/* Number of significant bits of n (floor(log2(n)) + 1), n is casted so shifts up to 63 are valid for every type */
+#define KLOG2_CONST_PRIV_BITS(n) \
+    (KLOG2_CONST_PRIV_COUNT8((unsigned long long)(n), 0)  + KLOG2_CONST_PRIV_COUNT8((unsigned long long)(n), 8)  + \
+     KLOG2_CONST_PRIV_COUNT8((unsigned long long)(n), 16) + KLOG2_CONST_PRIV_COUNT8((unsigned long long)(n), 24) + \
+     KLOG2_CONST_PRIV_COUNT8((unsigned long long)(n), 32) + KLOG2_CONST_PRIV_COUNT8((unsigned long long)(n), 40) + \
+     KLOG2_CONST_PRIV_COUNT8((unsigned long long)(n), 48) + KLOG2_CONST_PRIV_COUNT8((unsigned long long)(n), 56))
+
+/* Copy highest set bit to every lower bit, keeps type of n. Shift 16 twice because shift 32 is UB for 32-bit types */
+#define KROUND_POWER2_CONST_PRIV_SMEAR1(n)  ((n) | ((n) >> 1))
+#define KROUND_POWER2_CONST_PRIV_SMEAR2(n)  (KROUND_POWER2_CONST_PRIV_SMEAR1(n) | (KROUND_POWER2_CONST_PRIV_SMEAR1(n) >> 2))
+#define KROUND_POWER2_CONST_PRIV_SMEAR4(n)  (KROUND_POWER2_CONST_PRIV_SMEAR2(n) | (KROUND_POWER2_CONST_PRIV_SMEAR2(n) >> 4))
+#define KROUND_POWER2_CONST_PRIV_SMEAR8(n)  (KROUND_POWER2_CONST_PRIV_SMEAR4(n) | (KROUND_POWER2_CONST_PRIV_SMEAR4(n) >> 8))
+#define KROUND_POWER2_CONST_PRIV_SMEAR16(n) (KROUND_POWER2_CONST_PRIV_SMEAR8(n) | (KROUND_POWER2_CONST_PRIV_SMEAR8(n) >> 16))
+#define KROUND_POWER2_CONST_PRIV_SMEAR(n)   (KROUND_POWER2_CONST_PRIV_SMEAR16(n) | (KROUND_POWER2_CONST_PRIV_SMEAR16(n) >> 16 >> 16))
+
+/*
+    Constant paths of front macros (KLOG2_FLOOR etc.), n is mentioned few times, so front macros can be nested.
+    On gcc and clang KCLZLL of constant is folded at compile time. Other compilers never take constant path
+    (KIS_CONSTANT_EXPRESSION is always false), so the function versions are used there.
+*/
+#if defined(KCOMPILER_GCC) || defined(KCOMPILER_CLANG)
+#define KLOG2_FLOOR_PRIV_FOLD(n)        ((n) == 0 ? -1 : 63 - KCLZLL((unsigned long long)(n)))
+#define KLOG2_CEIL_PRIV_FOLD(n)         ((n) <= 1 ? (int)(n) - 1 : 64 - KCLZLL((unsigned long long)(n) - 1))
+#define KROUND_POWER2_UP_PRIV_FOLD(n)   ((n) <= 1 ? (n) : (__typeof__(n))1 << (64 - KCLZLL((unsigned long long)(n) - 1)))
+#define KROUND_POWER2_DOWN_PRIV_FOLD(n) ((n) == 0 ? (n) : (__typeof__(n))1 << (63 - KCLZLL((unsigned long long)(n))))
+#else
+#define KLOG2_FLOOR_PRIV_FOLD(n)        KLOG2_FLOOR_TYPE(n)
+#define KLOG2_CEIL_PRIV_FOLD(n)         KLOG2_CEIL_TYPE(n)
+#define KROUND_POWER2_UP_PRIV_FOLD(n)   KROUND_POWER2_UP_TYPE(n)
+#define KROUND_POWER2_DOWN_PRIV_FOLD(n) KROUND_POWER2_DOWN_TYPE(n)
+#endif
+
 #define KIS_POWER2_TYPE(n) \
     _Generic((n), \
-        unsigned int:       kis_power2_uint((unsigned int)n), \
-        unsigned long:      kis_power2_ulong((unsigned long)n), \
-        unsigned long long: kis_power2_ulonglong((unsigned long long)n) \
+        unsigned int:       kis_power2_uint((unsigned int)(n)), \
+        unsigned long:      kis_power2_ulong((unsigned long)(n)), \
+        unsigned long long: kis_power2_ulonglong((unsigned long long)(n)) \
     )
 
 #define KLOG2_FLOOR_TYPE(n) \
     _Generic((n), \
-        unsigned int:       klog2_floor_uint((unsigned int)n), \
-        unsigned long:      klog2_floor_ulong((unsigned long)n), \
-        unsigned long long: klog2_floor_ulonglong((unsigned long long)n) \
+        unsigned int:       klog2_floor_uint((unsigned int)(n)), \
+        unsigned long:      klog2_floor_ulong((unsigned long)(n)), \
+        unsigned long long: klog2_floor_ulonglong((unsigned long long)(n)) \
     )
 
 #define KLOG2_CEIL_TYPE(n) \
     _Generic((n), \
-        unsigned int:       klog2_ceil_uint((unsigned int)n), \
-        unsigned long:      klog2_ceil_ulong((unsigned long)n), \
-        unsigned long long: klog2_ceil_ulonglong((unsigned long long)n) \
+        unsigned int:       klog2_ceil_uint((unsigned int)(n)), \
+        unsigned long:      klog2_ceil_ulong((unsigned long)(n)), \
+        unsigned long long: klog2_ceil_ulonglong((unsigned long long)(n)) \
     )
 
 #define KROUND_POWER2_UP_TYPE(n) \
     _Generic((n), \
-        unsigned int:       kround_power2_up_uint((unsigned int)n), \
-        unsigned long:      kround_power2_up_ulong((unsigned long)n), \
-        unsigned long long: kround_power2_up_ulonglong((unsigned long long)n) \
+        unsigned int:       kround_power2_up_uint((unsigned int)(n)), \
+        unsigned long:      kround_power2_up_ulong((unsigned long)(n)), \
+        unsigned long long: kround_power2_up_ulonglong((unsigned long long)(n)) \
     )
 
 #define KROUND_POWER2_DOWN_TYPE(n) \
     _Generic((n), \
-        unsigned int:       kround_power2_down_uint((unsigned int)n), \
-        unsigned long:      kround_power2_down_ulong((unsigned long)n), \
-        unsigned long long: kround_power2_down_ulonglong((unsigned long long)n) \
+        unsigned int:       kround_power2_down_uint((unsigned int)(n)), \
+        unsigned long:      kround_power2_down_ulong((unsigned long)(n)), \
+        unsigned long long: kround_power2_down_ulonglong((unsigned long long)(n)) \
     )
 
 #endif
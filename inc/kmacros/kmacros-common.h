@@ -41,6 +41,14 @@
  */
 #define KARRAY_SIZE(arr) (sizeof(arr) / sizeof(arr[0]))
 
+/**
+ * Size of CPU cache line, used to align and pad data shared between threads.
+ * Define it before include to change default value
+ */
+#ifndef KCACHE_LINE_SIZE
+#define KCACHE_LINE_SIZE 64
+#endif
+
 /**
  * Deallocate memory in normal way (using free) + set pointer to NULL to avoid dangling pointer issue
  */
@@ -178,6 +186,24 @@
  */
 #define KSWAP(a, b) KSWAP_PRIV(a, b, KVAR_ALMOST_UNIQUE_NAME(KCONCAT(a, b)))
 
+/**
+ * Integer constant expression versions of KIS_POWER2, KLOG2_FLOOR, KLOG2_CEIL,
+ * KROUND_POWER2_UP and KROUND_POWER2_DOWN. Results are the same as from function versions.
+ * They can size static arrays, be used in KSTATIC_ASSERT and case labels.
+ * n is expanded many times, so pass only constants (at runtime use versions without _CONST).
+ *
+ * Works for every integer type with at most 64 bits, KROUND_POWER2_* keeps type of n
+ *
+ * Example:
+ * static uint8_t ring[KROUND_POWER2_UP_CONST(1000u)];
+ * KSTATIC_ASSERT(KLOG2_FLOOR_CONST(sizeof(ring)) == 10);
+ */
+#define KIS_POWER2_CONST(n)         ((n) != 0 && ((n) & ((n) - 1)) == 0)
+#define KLOG2_FLOOR_CONST(n)        (KLOG2_CONST_PRIV_BITS(n) - 1)
+#define KLOG2_CEIL_CONST(n)         ((n) == 0 ? -1 : KLOG2_CONST_PRIV_BITS((n) - 1))
+#define KROUND_POWER2_UP_CONST(n)   (KROUND_POWER2_CONST_PRIV_SMEAR((n) - 1) + 1)
+#define KROUND_POWER2_DOWN_CONST(n) (KROUND_POWER2_CONST_PRIV_SMEAR(n) - (KROUND_POWER2_CONST_PRIV_SMEAR(n) >> 1))
+
 /**
  * Check if n is power of 2
  *
@@ -185,8 +211,10 @@
  * unsigned int
  * unsigned long
  * unsigned long long
+ *
+ * For constant n result is computed at compile time by KIS_POWER2_CONST
  */
-#define KIS_POWER2(n) KIS_POWER2_TYPE(n)
+#define KIS_POWER2(n) (KIS_CONSTANT_EXPRESSION(n) ? (bool)KIS_POWER2_CONST(n) : KIS_POWER2_TYPE(n))
 
 /**
  * Calculate floor(log2(n)) but without coprocessor
@@ -195,8 +223,11 @@
  * unsigned int
  * unsigned long
  * unsigned long long
+ *
+ * For constant n result is computed at compile time (gcc, clang),
+ * where integer constant expression is needed use KLOG2_FLOOR_CONST
  */
-#define KLOG2_FLOOR(n) KLOG2_FLOOR_TYPE(n)
+#define KLOG2_FLOOR(n) (KIS_CONSTANT_EXPRESSION(n) ? KLOG2_FLOOR_PRIV_FOLD(n) : KLOG2_FLOOR_TYPE(n))
 
 /**
  * Calculate ceil(log2(n)) but without coprocessor
@@ -205,8 +236,11 @@
  * unsigned int
  * unsigned long
  * unsigned long long
+ *
+ * For constant n result is computed at compile time (gcc, clang),
+ * where integer constant expression is needed use KLOG2_CEIL_CONST
  */
-#define KLOG2_CEIL(n) KLOG2_CEIL_TYPE(n)
+#define KLOG2_CEIL(n) (KIS_CONSTANT_EXPRESSION(n) ? KLOG2_CEIL_PRIV_FOLD(n) : KLOG2_CEIL_TYPE(n))
 
 /**
  * This is only an alias to KLOG2_FLOOR
@@ -220,8 +254,11 @@
  * unsigned int
  * unsigned long
  * unsigned long long
+ *
+ * For constant n result is computed at compile time (gcc, clang),
+ * where integer constant expression is needed use KROUND_POWER2_UP_CONST
  */
-#define KROUND_POWER2_UP(n) KROUND_POWER2_UP_TYPE(n)
+#define KROUND_POWER2_UP(n) (KIS_CONSTANT_EXPRESSION(n) ? KROUND_POWER2_UP_PRIV_FOLD(n) : KROUND_POWER2_UP_TYPE(n))
 
 /**
  * Find first power of 2 <= than n
@@ -230,8 +267,11 @@
  * unsigned int
  * unsigned long
  * unsigned long long
+ *
+ * For constant n result is computed at compile time (gcc, clang),
+ * where integer constant expression is needed use KROUND_POWER2_DOWN_CONST
  */
-#define KROUND_POWER2_DOWN(n) KROUND_POWER2_DOWN_TYPE(n)
+#define KROUND_POWER2_DOWN(n) (KIS_CONSTANT_EXPRESSION(n) ? KROUND_POWER2_DOWN_PRIV_FOLD(n) : KROUND_POWER2_DOWN_TYPE(n))
 
 /**
  * Allign n to power of 2.
@@ -244,4 +284,38 @@
  */
 #define KALLIGN_POWER2(n) KROUND_POWER2_UP(n)
 
+/**
+ * Lemire fast range reduction: map hash into [0; n) by multiply high (hash * n) >> width, without %.
+ * Result depends on high bits of hash, so hash should be well mixed.
+ *
+ * @param[in] hash - 32-bit or 64-bit hash
+ * @param[in] n - size of range, for n = 0 result is 0
+ *
+ * @return index in [0; n)
+ */
+#define KFASTRANGE32(hash, n) kfastrange32((uint32_t)(hash), (uint32_t)(n))
+#define KFASTRANGE64(hash, n) kfastrange64((uint64_t)(hash), (uint64_t)(n))
+
+/**
+ * x % n when n is power of 2 (x & (n - 1))
+ */
+#define KMOD_POW2(x, n) ((x) & ((n) - 1))
+
+/**
+ * Bucket index of hash in table with n buckets, n > 0.
+ * When KIS_CONSTANT_EXPRESSION proves that n is power of 2, index is a shift,
+ * otherwise KFASTRANGE is used. For power of 2 both paths return the same index (high bits of hash),
+ * so result does not depend on which path compiler has chosen.
+ * n is expanded many times, so it cannot have side effects (hash is expanded once).
+ *
+ * Example:
+ * buckets[KBUCKET_INDEX64(hash, 1024)] -> hash >> 54
+ * buckets[KBUCKET_INDEX64(hash, table->n)] -> KFASTRANGE64(hash, table->n)
+ */
+#define KBUCKET_INDEX32(hash, n) \
+    ((KIS_CONSTANT_EXPRESSION(n) && KIS_POWER2_CONST(n)) ? kbucket_index_pow2_32((uint32_t)(hash), (uint32_t)(n)) : KFASTRANGE32(hash, n))
+
+#define KBUCKET_INDEX64(hash, n) \
+    ((KIS_CONSTANT_EXPRESSION(n) && KIS_POWER2_CONST(n)) ? kbucket_index_pow2_64((uint64_t)(hash), (uint64_t)(n)) : KFASTRANGE64(hash, n))
+
 #endif
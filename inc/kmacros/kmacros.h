@@ -13,5 +13,6 @@
 #include "kprimitives.h"
 #include "knargs.h"
 #include "kbits.h"
+#include "karith.h"
 
 #endif
@@ -0,0 +1,368 @@
+#ifndef KPOOL_H
+#define KPOOL_H
+
+/*
+    This is the public header for the KPool.
+
+    KPool is an intrusive pool of objects of one type. Object embeds kpool_node_t and free list
+    is threaded through this node, pool gets object back by KCONTAINER_OF, so free object costs no extra memory.
+    Objects are carved from slabs of slab_objs objects, slabs are returned to system only by destroy,
+    so objects with high churn (connections, sessions, requests) never reach general allocator.
+
+    KPOOL_DEFINE(name, type, member) generates typed functions name_init / name_destroy /
+    name_alloc / name_free / name_cache_init / name_cache_destroy / name_cache_alloc / name_cache_free.
+
+    Pool functions (name_alloc / name_free) are not thread safe. For many threads give every thread
+    own kpool_cache_t (static _Thread_local kpool_cache_t cache). Cache keeps up to 2 * KPOOL_CACHE_BATCH objects,
+    it takes from pool and gives back to pool KPOOL_CACHE_BATCH objects under pool lock at once,
+    so lock is taken once per KPOOL_CACHE_BATCH operations. When caches are used, every thread has to use cache.
+
+    Define KPOOL_DEBUG before include to poison freed objects (except node) with KPOOL_POISON_BYTE
+    and check poison in alloc, so write after free is caught by assert.
+
+    Include it directly: #include <kmacros/kpool.h>
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE: GPL3
+*/
+
+#include "kmacros.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#ifdef KPOOL_DEBUG
+#include <assert.h>
+#include <string.h>
+#endif
+
+/* Default number of objects in slab for init(pool, 0) */
+#ifndef KPOOL_SLAB_OBJS
+#define KPOOL_SLAB_OBJS         256
+#endif
+
+/* Define before include to change number of objects moved between cache and pool at once */
+#ifndef KPOOL_CACHE_BATCH
+#define KPOOL_CACHE_BATCH       32
+#endif
+
+#define KPOOL_POISON_BYTE       0x6B
+
+KSTATIC_ASSERT_MSG(KPOOL_CACHE_BATCH > 0, "Cache has to move at least 1 object");
+
+/* Node embedded in object, valid only when object is free */
+typedef struct kpool_node
+{
+    struct kpool_node *next;
+} kpool_node_t;
+
+typedef struct kpool_slab
+{
+    struct kpool_slab *next;
+} kpool_slab_t;
+
+typedef struct kpool
+{
+    kpool_node_t    *free_list;
+    char            *bump;          /* first never used object of current slab */
+    size_t           bump_left;     /* objects left in current slab */
+    kpool_slab_t    *slabs;
+    size_t           nslabs;
+    size_t           obj_size;
+    size_t           obj_align;
+    size_t           node_offset;   /* offsetof(type, member) */
+    size_t           slab_objs;
+    pthread_mutex_t  lock;          /* used only by caches */
+} kpool_t;
+
+typedef struct kpool_cache
+{
+    kpool_node_t *free_list;
+    size_t        count;
+    kpool_t      *pool;
+} kpool_cache_t;
+
+/**
+ * Generate typed pool for type with kpool_node_t member
+ *
+ * Example:
+ * struct conn { int fd; kpool_node_t node; };
+ * KPOOL_DEFINE(conn_pool, struct conn, node)
+ *
+ * kpool_t pool;
+ * conn_pool_init(&pool, 0);
+ * struct conn *c = conn_pool_alloc(&pool);
+ * conn_pool_free(&pool, c);
+ * conn_pool_destroy(&pool);
+ */
+#define KPOOL_DEFINE(name, type, member) \
+    KSTATIC_ASSERT_MSG(_Generic(((type *)0)->member, kpool_node_t: 1, default: 0), "Member has to be kpool_node_t"); \
+    static inline int name##_init(kpool_t *pool, size_t slab_objs); \
+    static inline int name##_init(kpool_t *pool, size_t slab_objs) \
+    { \
+        return __kpool_init(pool, sizeof(type), _Alignof(type), offsetof(type, member), slab_objs); \
+    } \
+    static inline void name##_destroy(kpool_t *pool); \
+    static inline void name##_destroy(kpool_t *pool) \
+    { \
+        __kpool_destroy(pool); \
+    } \
+    static inline type *name##_alloc(kpool_t *pool); \
+    static inline type *name##_alloc(kpool_t *pool) \
+    { \
+        kpool_node_t *node = __kpool_alloc(pool); \
+        return node == NULL ? NULL : (type *)KCONTAINER_OF(node, type, member); \
+    } \
+    static inline void name##_free(kpool_t *pool, type *obj); \
+    static inline void name##_free(kpool_t *pool, type *obj) \
+    { \
+        if (obj != NULL) \
+            __kpool_free(pool, &obj->member); \
+    } \
+    static inline void name##_cache_init(kpool_cache_t *cache, kpool_t *pool); \
+    static inline void name##_cache_init(kpool_cache_t *cache, kpool_t *pool) \
+    { \
+        __kpool_cache_init(cache, pool); \
+    } \
+    static inline void name##_cache_destroy(kpool_cache_t *cache); \
+    static inline void name##_cache_destroy(kpool_cache_t *cache) \
+    { \
+        __kpool_cache_destroy(cache); \
+    } \
+    static inline type *name##_cache_alloc(kpool_cache_t *cache); \
+    static inline type *name##_cache_alloc(kpool_cache_t *cache) \
+    { \
+        kpool_node_t *node = __kpool_cache_alloc(cache); \
+        return node == NULL ? NULL : (type *)KCONTAINER_OF(node, type, member); \
+    } \
+    static inline void name##_cache_free(kpool_cache_t *cache, type *obj); \
+    static inline void name##_cache_free(kpool_cache_t *cache, type *obj) \
+    { \
+        if (obj != NULL) \
+            __kpool_cache_free(cache, &obj->member); \
+    }
+
+/* Private functions used by KPOOL_DEFINE, do not use */
+static inline int __kpool_init(kpool_t *pool, size_t obj_size, size_t obj_align, size_t node_offset, size_t slab_objs);
+static inline void __kpool_destroy(kpool_t *pool);
+static inline kpool_node_t *__kpool_refill(kpool_t *pool);
+static inline kpool_node_t *__kpool_alloc(kpool_t *pool);
+static inline void __kpool_free(kpool_t *pool, kpool_node_t *node);
+static inline void __kpool_cache_init(kpool_cache_t *cache, kpool_t *pool);
+static inline void __kpool_cache_destroy(kpool_cache_t *cache);
+static inline kpool_node_t *__kpool_cache_alloc(kpool_cache_t *cache);
+static inline void __kpool_cache_free(kpool_cache_t *cache, kpool_node_t *node);
+static inline void __kpool_poison(const kpool_t *pool, kpool_node_t *node);
+static inline void __kpool_check_poison(const kpool_t *pool, const kpool_node_t *node);
+
+static inline int __kpool_init(kpool_t *pool, size_t obj_size, size_t obj_align, size_t node_offset, size_t slab_objs)
+{
+    pool->free_list = NULL;
+    pool->bump = NULL;
+    pool->bump_left = 0;
+    pool->slabs = NULL;
+    pool->nslabs = 0;
+    pool->obj_size = obj_size;
+    pool->obj_align = KMAX(obj_align, _Alignof(max_align_t));
+    pool->node_offset = node_offset;
+    pool->slab_objs = slab_objs == 0 ? KPOOL_SLAB_OBJS : slab_objs;
+
+    return pthread_mutex_init(&pool->lock, NULL) == 0 ? 0 : -1;
+}
+
+static inline void __kpool_destroy(kpool_t *pool)
+{
+    kpool_slab_t *slab = pool->slabs;
+    while (slab != NULL)
+    {
+        kpool_slab_t *next = slab->next;
+        free(slab);
+        slab = next;
+    }
+
+    pool->free_list = NULL;
+    pool->bump = NULL;
+    pool->bump_left = 0;
+    pool->slabs = NULL;
+    pool->nslabs = 0;
+
+    (void)pthread_mutex_destroy(&pool->lock);
+}
+
+static inline void __kpool_poison(const kpool_t *pool, kpool_node_t *node)
+{
+#ifdef KPOOL_DEBUG
+    char *obj = (char *)node - pool->node_offset;
+    const size_t node_end = pool->node_offset + sizeof(*node);
+
+    (void)memset(obj, KPOOL_POISON_BYTE, pool->node_offset);
+    (void)memset(obj + node_end, KPOOL_POISON_BYTE, pool->obj_size - node_end);
+#else
+    (void)pool;
+    (void)node;
+#endif
+}
+
+static inline void __kpool_check_poison(const kpool_t *pool, const kpool_node_t *node)
+{
+#ifdef KPOOL_DEBUG
+    const unsigned char *obj = (const unsigned char *)node - pool->node_offset;
+    const size_t node_end = pool->node_offset + sizeof(*node);
+
+    for (size_t i = 0; i < pool->obj_size; ++i)
+        assert((i >= pool->node_offset && i < node_end) || obj[i] == KPOOL_POISON_BYTE);
+
+    /* used only by assert */
+    (void)obj;
+    (void)node_end;
+#else
+    (void)pool;
+    (void)node;
+#endif
+}
+
+static inline kpool_node_t *__kpool_refill(kpool_t *pool)
+{
+    /* objects start after header rounded up to object alignment */
+    const size_t header = KMAX(sizeof(kpool_slab_t), pool->obj_align);
+    const size_t bytes = header + pool->slab_objs * pool->obj_size;
+
+    kpool_slab_t *slab = aligned_alloc(pool->obj_align, (bytes + pool->obj_align - 1) & ~(pool->obj_align - 1));
+    if (slab == NULL)
+        return NULL;
+
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+    ++pool->nslabs;
+
+    char *obj = (char *)slab + header;
+    pool->bump = obj + pool->obj_size;
+    pool->bump_left = pool->slab_objs - 1;
+
+    return (kpool_node_t *)(void *)(obj + pool->node_offset);
+}
+
+static inline kpool_node_t *__kpool_alloc(kpool_t *pool)
+{
+    kpool_node_t *node = pool->free_list;
+    if (KLIKELY(node != NULL))
+    {
+        pool->free_list = node->next;
+        __kpool_check_poison(pool, node);
+
+        return node;
+    }
+
+    if (KLIKELY(pool->bump_left > 0))
+    {
+        char *obj = pool->bump;
+        pool->bump += pool->obj_size;
+        --pool->bump_left;
+
+        return (kpool_node_t *)(void *)(obj + pool->node_offset);
+    }
+
+    return __kpool_refill(pool);
+}
+
+static inline void __kpool_free(kpool_t *pool, kpool_node_t *node)
+{
+    __kpool_poison(pool, node);
+
+    node->next = pool->free_list;
+    pool->free_list = node;
+}
+
+static inline void __kpool_cache_init(kpool_cache_t *cache, kpool_t *pool)
+{
+    cache->free_list = NULL;
+    cache->count = 0;
+    cache->pool = pool;
+}
+
+static inline void __kpool_cache_destroy(kpool_cache_t *cache)
+{
+    kpool_t *pool = cache->pool;
+
+    (void)pthread_mutex_lock(&pool->lock);
+    while (cache->free_list != NULL)
+    {
+        kpool_node_t *node = cache->free_list;
+        cache->free_list = node->next;
+
+        node->next = pool->free_list;
+        pool->free_list = node;
+    }
+    (void)pthread_mutex_unlock(&pool->lock);
+
+    cache->count = 0;
+}
+
+static inline kpool_node_t *__kpool_cache_alloc(kpool_cache_t *cache)
+{
+    kpool_node_t *node = cache->free_list;
+    if (KUNLIKELY(node == NULL))
+    {
+        /* refill batch from pool, objects are already poisoned, so take them without check */
+        kpool_t *pool = cache->pool;
+
+        (void)pthread_mutex_lock(&pool->lock);
+        for (size_t i = 0; i < KPOOL_CACHE_BATCH; ++i)
+        {
+            kpool_node_t *obj = pool->free_list;
+            if (obj != NULL)
+                pool->free_list = obj->next;
+            else if ((obj = __kpool_alloc(pool)) == NULL)
+                break;
+            else
+                __kpool_poison(pool, obj);
+
+            obj->next = cache->free_list;
+            cache->free_list = obj;
+            ++cache->count;
+        }
+        (void)pthread_mutex_unlock(&pool->lock);
+
+        node = cache->free_list;
+        if (node == NULL)
+            return NULL;
+    }
+
+    cache->free_list = node->next;
+    --cache->count;
+    __kpool_check_poison(cache->pool, node);
+
+    return node;
+}
+
+static inline void __kpool_cache_free(kpool_cache_t *cache, kpool_node_t *node)
+{
+    __kpool_poison(cache->pool, node);
+
+    node->next = cache->free_list;
+    cache->free_list = node;
+    ++cache->count;
+
+    if (KLIKELY(cache->count <= 2 * KPOOL_CACHE_BATCH))
+        return;
+
+    /* give back batch to pool, chain is built before lock, so critical section is a single splice */
+    kpool_node_t *first = cache->free_list;
+    kpool_node_t *last = first;
+    for (size_t i = 1; i < KPOOL_CACHE_BATCH; ++i)
+        last = last->next;
+
+    cache->free_list = last->next;
+    cache->count -= KPOOL_CACHE_BATCH;
+
+    kpool_t *pool = cache->pool;
+    (void)pthread_mutex_lock(&pool->lock);
+    last->next = pool->free_list;
+    pool->free_list = first;
+    (void)pthread_mutex_unlock(&pool->lock);
+}
+
+#endif
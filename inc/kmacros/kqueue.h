@@ -0,0 +1,187 @@
+#ifndef KQUEUE_H
+#define KQUEUE_H
+
+/*
+    This is the public header for the KQueue.
+
+    KQueue MPMC is a bounded lock-free queue for many producers and many consumers (Dmitry Vyukov's algorithm).
+    Capacity has to be power of 2 (checked by KIS_POWER2), so cell of position is pos & mask.
+    Every cell has own sequence number, which says whose turn it is:
+    seq == pos                  - cell is free for producer of position pos
+    seq == pos + 1              - cell keeps item for consumer of position pos
+    seq == pos + capacity       - cell is free again for producer of the next lap
+    Producer (consumer) claims position by single CAS on enqueue (dequeue) cursor, then writes (reads) cell
+    and publishes it by release store (KATOMIC_STORE) of sequence, so producers and consumers touch different cursors
+    and never wait for each other except on the same cell.
+    Cursors live on own cache lines (_Alignas), so producers do not invalidate line of consumers.
+
+    KQUEUE_MPMC_DEFINE(name, type) generates name_t and typed functions name_init / name_destroy /
+    name_push / name_pop / name_capacity / name_size.
+    kqueue_mpmc_t for void * is already defined.
+
+    name_t is cache line aligned, allocate it statically, on stack or by aligned_alloc.
+
+    Include it directly: #include <kmacros/kqueue.h>
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE: GPL3
+*/
+
+#include "kmacros.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/**
+ * Generate MPMC queue of type
+ *
+ * Example:
+ * KQUEUE_MPMC_DEFINE(task_queue, struct task *)
+ *
+ * task_queue_t queue;
+ * task_queue_init(&queue, 1024);
+ * any thread: if (!task_queue_push(&queue, task)) -> queue is full
+ * any thread: struct task *task; if (task_queue_pop(&queue, &task)) ...
+ */
+#define KQUEUE_MPMC_DEFINE(name, type) \
+    typedef type name##_item_t; \
+    \
+    typedef struct name##_cell \
+    { \
+        KATOMIC(size_t) seq; \
+        name##_item_t   item; \
+    } name##_cell_t; \
+    \
+    typedef struct name \
+    { \
+        /* read only after init */ \
+        _Alignas(KCACHE_LINE_SIZE) name##_cell_t *cells; \
+        size_t mask; \
+        _Alignas(KCACHE_LINE_SIZE) KATOMIC(size_t) enqueue_pos; \
+        _Alignas(KCACHE_LINE_SIZE) KATOMIC(size_t) dequeue_pos; \
+        /* keep next object out of dequeue_pos line */ \
+        _Alignas(KCACHE_LINE_SIZE) char pad; \
+    } name##_t; \
+    \
+    /* Init empty queue, capacity has to be power of 2 >= 2, return 0 on success, -1 on failure */ \
+    static inline int name##_init(name##_t *queue, size_t capacity); \
+    static inline int name##_init(name##_t *queue, size_t capacity) \
+    { \
+        if (capacity < 2 || !KIS_POWER2(capacity) || capacity > (SIZE_MAX >> 1) / sizeof(name##_cell_t)) \
+            return -1; \
+        \
+        const size_t bytes = (capacity * sizeof(name##_cell_t) + KCACHE_LINE_SIZE - 1) & ~((size_t)KCACHE_LINE_SIZE - 1); \
+        queue->cells = aligned_alloc(KCACHE_LINE_SIZE, bytes); \
+        if (queue->cells == NULL) \
+            return -1; \
+        \
+        for (size_t i = 0; i < capacity; ++i) \
+            KATOMIC_STORE(&queue->cells[i].seq, i, KATOMIC_RELAXED); \
+        \
+        queue->mask = capacity - 1; \
+        KATOMIC_STORE(&queue->enqueue_pos, 0, KATOMIC_RELAXED); \
+        KATOMIC_STORE(&queue->dequeue_pos, 0, KATOMIC_RELAXED); \
+        \
+        return 0; \
+    } \
+    \
+    static inline void name##_destroy(name##_t *queue); \
+    static inline void name##_destroy(name##_t *queue) \
+    { \
+        free(queue->cells); \
+        queue->cells = NULL; \
+    } \
+    \
+    static inline size_t name##_capacity(const name##_t *queue); \
+    static inline size_t name##_capacity(const name##_t *queue) \
+    { \
+        return queue->mask + 1; \
+    } \
+    \
+    /* Approximate number of items, exact only when no thread uses queue */ \
+    static inline size_t name##_size(const name##_t *queue); \
+    static inline size_t name##_size(const name##_t *queue) \
+    { \
+        const size_t dequeue_pos = KATOMIC_LOAD(&queue->dequeue_pos, KATOMIC_RELAXED); \
+        const size_t enqueue_pos = KATOMIC_LOAD(&queue->enqueue_pos, KATOMIC_RELAXED); \
+        \
+        return enqueue_pos - dequeue_pos > queue->mask + 1 ? 0 : enqueue_pos - dequeue_pos; \
+    } \
+    \
+    /* Any thread, return false when queue is full */ \
+    static inline bool name##_push(name##_t *queue, name##_item_t item); \
+    static inline bool name##_push(name##_t *queue, name##_item_t item) \
+    { \
+        name##_cell_t *cell; \
+        size_t pos = KATOMIC_LOAD(&queue->enqueue_pos, KATOMIC_RELAXED); \
+        \
+        for (;;) \
+        { \
+            cell = &queue->cells[pos & queue->mask]; \
+            const size_t seq = KATOMIC_LOAD(&cell->seq, KATOMIC_ACQUIRE); \
+            const intptr_t diff = (intptr_t)(seq - pos); \
+            \
+            if (KLIKELY(diff == 0)) \
+            { \
+                /* on failure pos is reloaded by CAS */ \
+                if (KLIKELY(KATOMIC_CAS_WEAK(&queue->enqueue_pos, &pos, pos + 1, KATOMIC_RELAXED, KATOMIC_RELAXED))) \
+                    break; \
+            } \
+            else if (KUNLIKELY(diff < 0)) \
+            { \
+                /* cell still keeps item from previous lap */ \
+                return false; \
+            } \
+            else \
+            { \
+                pos = KATOMIC_LOAD(&queue->enqueue_pos, KATOMIC_RELAXED); \
+            } \
+        } \
+        \
+        cell->item = item; \
+        KATOMIC_STORE(&cell->seq, pos + 1, KATOMIC_RELEASE); \
+        \
+        return true; \
+    } \
+    \
+    /* Any thread, return false when queue is empty */ \
+    static inline bool name##_pop(name##_t *queue, name##_item_t *item); \
+    static inline bool name##_pop(name##_t *queue, name##_item_t *item) \
+    { \
+        name##_cell_t *cell; \
+        size_t pos = KATOMIC_LOAD(&queue->dequeue_pos, KATOMIC_RELAXED); \
+        \
+        for (;;) \
+        { \
+            cell = &queue->cells[pos & queue->mask]; \
+            const size_t seq = KATOMIC_LOAD(&cell->seq, KATOMIC_ACQUIRE); \
+            const intptr_t diff = (intptr_t)(seq - (pos + 1)); \
+            \
+            if (KLIKELY(diff == 0)) \
+            { \
+                if (KLIKELY(KATOMIC_CAS_WEAK(&queue->dequeue_pos, &pos, pos + 1, KATOMIC_RELAXED, KATOMIC_RELAXED))) \
+                    break; \
+            } \
+            else if (KUNLIKELY(diff < 0)) \
+            { \
+                /* producer of this cell has not published item yet */ \
+                return false; \
+            } \
+            else \
+            { \
+                pos = KATOMIC_LOAD(&queue->dequeue_pos, KATOMIC_RELAXED); \
+            } \
+        } \
+        \
+        *item = cell->item; \
+        KATOMIC_STORE(&cell->seq, pos + queue->mask + 1, KATOMIC_RELEASE); \
+        \
+        return true; \
+    }
+
+KQUEUE_MPMC_DEFINE(kqueue_mpmc, void *)
+
+#endif
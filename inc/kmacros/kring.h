@@ -0,0 +1,185 @@
+#ifndef KRING_H
+#define KRING_H
+
+/*
+    This is the public header for the KRing.
+
+    KRing SPSC is a lock-free ring buffer for exactly one producer thread and exactly one consumer thread.
+    Capacity is rounded by KROUND_POWER2_UP, so slot of index is index & mask (no division).
+    Head and tail are free running counters (KATOMIC), each of them is written by one thread only and lives on own
+    cache line (_Alignas), so producer and consumer do not invalidate each other's line on every operation.
+    Every side keeps a local copy of the opposite index and reads the shared one only when the local copy
+    says that ring is full (producer) or empty (consumer).
+    Batch push / pop moves many items with one release store, so cost of index exchange is paid once per batch.
+
+    KRING_SPSC_DEFINE(name, type) generates name_t and typed functions name_init / name_destroy /
+    name_push / name_pop / name_push_batch / name_pop_batch / name_size / name_capacity.
+    kring_spsc_t for void * is already defined.
+
+    name_t is cache line aligned, allocate it statically, on stack or by aligned_alloc.
+
+    Include it directly: #include <kmacros/kring.h>
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE: GPL3
+*/
+
+#include "kmacros.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/**
+ * Generate SPSC ring of type
+ *
+ * Example:
+ * KRING_SPSC_DEFINE(job_ring, struct job)
+ *
+ * job_ring_t ring;
+ * job_ring_init(&ring, 1000); <- capacity is 1024
+ * producer: while (!job_ring_push(&ring, job)) ;
+ * consumer: struct job job; if (job_ring_pop(&ring, &job)) ...
+ */
+#define KRING_SPSC_DEFINE(name, type) \
+    /* typedef keeps const on item for pointer types (const type * for void * is const void **) */ \
+    typedef type name##_item_t; \
+    \
+    typedef struct name \
+    { \
+        /* read only after init */ \
+        _Alignas(KCACHE_LINE_SIZE) name##_item_t *slots; \
+        size_t mask; \
+        /* producer */ \
+        _Alignas(KCACHE_LINE_SIZE) KATOMIC(size_t) tail; \
+        size_t head_cache; \
+        /* consumer */ \
+        _Alignas(KCACHE_LINE_SIZE) KATOMIC(size_t) head; \
+        size_t tail_cache; \
+    } name##_t; \
+    \
+    /* Init empty ring with capacity rounded up to power of 2, return 0 on success, -1 on failure */ \
+    static inline int name##_init(name##_t *ring, size_t capacity); \
+    static inline int name##_init(name##_t *ring, size_t capacity) \
+    { \
+        if (capacity == 0 || capacity > (SIZE_MAX >> 1) / sizeof(name##_item_t)) \
+            return -1; \
+        \
+        capacity = KROUND_POWER2_UP(capacity); \
+        const size_t bytes = (capacity * sizeof(name##_item_t) + KCACHE_LINE_SIZE - 1) & ~((size_t)KCACHE_LINE_SIZE - 1); \
+        ring->slots = aligned_alloc(KCACHE_LINE_SIZE, bytes); \
+        if (ring->slots == NULL) \
+            return -1; \
+        \
+        ring->mask = capacity - 1; \
+        KATOMIC_STORE(&ring->tail, 0, KATOMIC_RELAXED); \
+        ring->head_cache = 0; \
+        KATOMIC_STORE(&ring->head, 0, KATOMIC_RELAXED); \
+        ring->tail_cache = 0; \
+        \
+        return 0; \
+    } \
+    \
+    static inline void name##_destroy(name##_t *ring); \
+    static inline void name##_destroy(name##_t *ring) \
+    { \
+        free(ring->slots); \
+        ring->slots = NULL; \
+    } \
+    \
+    static inline size_t name##_capacity(const name##_t *ring); \
+    static inline size_t name##_capacity(const name##_t *ring) \
+    { \
+        return ring->mask + 1; \
+    } \
+    \
+    /* Number of items in ring, exact only when called by producer or consumer while other side waits */ \
+    static inline size_t name##_size(const name##_t *ring); \
+    static inline size_t name##_size(const name##_t *ring) \
+    { \
+        return KATOMIC_LOAD(&ring->tail, KATOMIC_ACQUIRE) - KATOMIC_LOAD(&ring->head, KATOMIC_ACQUIRE); \
+    } \
+    \
+    /* Producer only, return false when ring is full */ \
+    static inline bool name##_push(name##_t *ring, name##_item_t item); \
+    static inline bool name##_push(name##_t *ring, name##_item_t item) \
+    { \
+        const size_t tail = KATOMIC_LOAD(&ring->tail, KATOMIC_RELAXED); \
+        if (KUNLIKELY(tail - ring->head_cache > ring->mask)) \
+        { \
+            ring->head_cache = KATOMIC_LOAD(&ring->head, KATOMIC_ACQUIRE); \
+            if (tail - ring->head_cache > ring->mask) \
+                return false; \
+        } \
+        \
+        ring->slots[tail & ring->mask] = item; \
+        KATOMIC_STORE(&ring->tail, tail + 1, KATOMIC_RELEASE); \
+        \
+        return true; \
+    } \
+    \
+    /* Consumer only, return false when ring is empty */ \
+    static inline bool name##_pop(name##_t *ring, name##_item_t *item); \
+    static inline bool name##_pop(name##_t *ring, name##_item_t *item) \
+    { \
+        const size_t head = KATOMIC_LOAD(&ring->head, KATOMIC_RELAXED); \
+        if (KUNLIKELY(head == ring->tail_cache)) \
+        { \
+            ring->tail_cache = KATOMIC_LOAD(&ring->tail, KATOMIC_ACQUIRE); \
+            if (head == ring->tail_cache) \
+                return false; \
+        } \
+        \
+        *item = ring->slots[head & ring->mask]; \
+        KATOMIC_STORE(&ring->head, head + 1, KATOMIC_RELEASE); \
+        \
+        return true; \
+    } \
+    \
+    /* Producer only, push up to n items, return number of pushed items */ \
+    static inline size_t name##_push_batch(name##_t *ring, const name##_item_t *items, size_t n); \
+    static inline size_t name##_push_batch(name##_t *ring, const name##_item_t *items, size_t n) \
+    { \
+        const size_t tail = KATOMIC_LOAD(&ring->tail, KATOMIC_RELAXED); \
+        size_t free_slots = ring->mask + 1 - (tail - ring->head_cache); \
+        if (free_slots < n) \
+        { \
+            ring->head_cache = KATOMIC_LOAD(&ring->head, KATOMIC_ACQUIRE); \
+            free_slots = ring->mask + 1 - (tail - ring->head_cache); \
+            n = KMIN(n, free_slots); \
+        } \
+        \
+        for (size_t i = 0; i < n; ++i) \
+            ring->slots[(tail + i) & ring->mask] = items[i]; \
+        \
+        KATOMIC_STORE(&ring->tail, tail + n, KATOMIC_RELEASE); \
+        \
+        return n; \
+    } \
+    \
+    /* Consumer only, pop up to n items, return number of popped items */ \
+    static inline size_t name##_pop_batch(name##_t *ring, name##_item_t *items, size_t n); \
+    static inline size_t name##_pop_batch(name##_t *ring, name##_item_t *items, size_t n) \
+    { \
+        const size_t head = KATOMIC_LOAD(&ring->head, KATOMIC_RELAXED); \
+        size_t ready = ring->tail_cache - head; \
+        if (ready < n) \
+        { \
+            ring->tail_cache = KATOMIC_LOAD(&ring->tail, KATOMIC_ACQUIRE); \
+            ready = ring->tail_cache - head; \
+            n = KMIN(n, ready); \
+        } \
+        \
+        for (size_t i = 0; i < n; ++i) \
+            items[i] = ring->slots[(head + i) & ring->mask]; \
+        \
+        KATOMIC_STORE(&ring->head, head + n, KATOMIC_RELEASE); \
+        \
+        return n; \
+    }
+
+KRING_SPSC_DEFINE(kring_spsc, void *)
+
+#endif
@@ -0,0 +1,225 @@
+#ifndef KSLAB_H
+#define KSLAB_H
+
+/*
+    This is the public header for the KSlab.
+
+    KSlab is an allocator for small objects with power of 2 size classes [KSLAB_MIN_SIZE; KSLAB_MAX_SIZE].
+    Class of size is computed by KLOG2_CEIL (for constant size at compile time).
+    Every class has own free list and bump pointer into current slab. Slab is a cache line aligned block
+    of KSLAB_SLAB_SIZE bytes taken from system allocator, so alloc and free are a few pointer operations.
+    Bigger objects go directly to malloc / free.
+
+    KSlab is not thread safe on purpose (no locks, no atomics). Use one kslab_t per thread:
+    static _Thread_local kslab_t slab;
+    Object has to be freed to the same kslab_t with the same size as was used in kslab_alloc.
+    Memory of slabs is returned to system only by kslab_destroy.
+
+    Include it directly: #include <kmacros/kslab.h>
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE: GPL3
+*/
+
+#include "kmacros.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/* Define before include to change size of single slab (power of 2) */
+#ifndef KSLAB_SLAB_SIZE
+#define KSLAB_SLAB_SIZE     ((size_t)64 * 1024)
+#endif
+
+/* Define before include to change the biggest size class (2^KSLAB_MAX_SHIFT) */
+#ifndef KSLAB_MAX_SHIFT
+#define KSLAB_MAX_SHIFT     13
+#endif
+
+#define KSLAB_MIN_SHIFT     4
+#define KSLAB_MIN_SIZE      ((size_t)1 << KSLAB_MIN_SHIFT)
+#define KSLAB_MAX_SIZE      ((size_t)1 << KSLAB_MAX_SHIFT)
+#define KSLAB_CLASSES       (KSLAB_MAX_SHIFT - KSLAB_MIN_SHIFT + 1)
+
+KSTATIC_ASSERT_MSG(KIS_POWER2_CONST(KSLAB_SLAB_SIZE), "KSLAB_SLAB_SIZE has to be power of 2");
+KSTATIC_ASSERT_MSG(KSLAB_MAX_SIZE <= (KSLAB_SLAB_SIZE - KCACHE_LINE_SIZE) / 4, "Slab should keep at least 4 objects of the biggest class");
+
+/* Free object keeps pointer to next free object of the same class */
+typedef struct kslab_free_obj
+{
+    struct kslab_free_obj *next;
+} kslab_free_obj_t;
+
+/* Header in the first cache line of every slab, objects start from the second cache line */
+typedef struct kslab_slab
+{
+    struct kslab_slab *next;
+} kslab_slab_t;
+
+typedef struct kslab_class
+{
+    kslab_free_obj_t *free_list;
+    char             *bump;      /* first never used byte of current slab */
+    size_t            bump_left; /* bytes from bump to end of current slab */
+} kslab_class_t;
+
+typedef struct kslab
+{
+    kslab_class_t classes[KSLAB_CLASSES];
+    kslab_slab_t *slabs;
+    size_t        nslabs;
+} kslab_t;
+
+/**
+ * Allocate object of type and free it (size is known at compile time, so class index is a constant)
+ *
+ * Example:
+ * struct node *n = KSLAB_NEW(&slab, struct node);
+ * KSLAB_DELETE(&slab, n);
+ */
+#define KSLAB_NEW(slab, type)   ((type *)kslab_alloc(slab, sizeof(type)))
+#define KSLAB_DELETE(slab, ptr) kslab_free(slab, ptr, sizeof(*(ptr)))
+
+static inline void kslab_init(kslab_t *slab);
+static inline void kslab_destroy(kslab_t *slab);
+
+static inline size_t kslab_class_index(size_t size);
+static inline size_t kslab_class_size(size_t index);
+
+static inline void *kslab_alloc(kslab_t *slab, size_t size) KATTR_FUNC_MALLOC;
+static inline void kslab_free(kslab_t *slab, void *ptr, size_t size);
+
+/* Private helpers, do not use */
+static inline void *__kslab_refill(kslab_t *slab, kslab_class_t *cls, size_t obj_size);
+
+/**
+ * Init empty slab allocator, no memory is allocated until first kslab_alloc
+ */
+static inline void kslab_init(kslab_t *slab)
+{
+    for (size_t i = 0; i < KSLAB_CLASSES; ++i)
+        slab->classes[i] = (kslab_class_t){.free_list = NULL, .bump = NULL, .bump_left = 0};
+
+    slab->slabs = NULL;
+    slab->nslabs = 0;
+}
+
+/**
+ * Return every slab to system, all objects from slab allocator become invalid.
+ * Objects bigger than KSLAB_MAX_SIZE have to be freed by kslab_free
+ */
+static inline void kslab_destroy(kslab_t *slab)
+{
+    kslab_slab_t *s = slab->slabs;
+    while (s != NULL)
+    {
+        kslab_slab_t *next = s->next;
+        free(s);
+        s = next;
+    }
+
+    kslab_init(slab);
+}
+
+/**
+ * Size class of size, valid size is [0; KSLAB_MAX_SIZE]
+ *
+ * @return index of class, class size is KSLAB_MIN_SIZE << index
+ */
+static inline size_t kslab_class_index(size_t size)
+{
+    if (size <= KSLAB_MIN_SIZE)
+        return 0;
+
+    const long log = KLOG2_CEIL(size);
+
+    return (size_t)log - KSLAB_MIN_SHIFT;
+}
+
+static inline size_t kslab_class_size(size_t index)
+{
+    return KSLAB_MIN_SIZE << index;
+}
+
+static inline void *__kslab_refill(kslab_t *slab, kslab_class_t *cls, size_t obj_size)
+{
+    kslab_slab_t *s = aligned_alloc(KCACHE_LINE_SIZE, KSLAB_SLAB_SIZE);
+    if (s == NULL)
+        return NULL;
+
+    s->next = slab->slabs;
+    slab->slabs = s;
+    ++slab->nslabs;
+
+    /* rest of previous slab is smaller than obj_size, so nothing is lost */
+    char *obj = (char *)s + KCACHE_LINE_SIZE;
+    cls->bump = obj + obj_size;
+    cls->bump_left = KSLAB_SLAB_SIZE - KCACHE_LINE_SIZE - obj_size;
+
+    return obj;
+}
+
+/**
+ * Allocate memory for object.
+ * Object of class >= KCACHE_LINE_SIZE is cache line aligned, smaller object is aligned to its class size
+ *
+ * @param[in] slab - slab allocator
+ * @param[in] size - size of object, size > KSLAB_MAX_SIZE is allocated by malloc
+ *
+ * @return pointer to memory or NULL on failure
+ */
+static inline void *kslab_alloc(kslab_t *slab, size_t size)
+{
+    if (KUNLIKELY(size > KSLAB_MAX_SIZE))
+        return malloc(size);
+
+    const size_t index = kslab_class_index(size);
+    kslab_class_t *cls = &slab->classes[index];
+
+    kslab_free_obj_t *obj = cls->free_list;
+    if (KLIKELY(obj != NULL))
+    {
+        cls->free_list = obj->next;
+        return obj;
+    }
+
+    const size_t obj_size = kslab_class_size(index);
+    if (KLIKELY(cls->bump_left >= obj_size))
+    {
+        char *ptr = cls->bump;
+        cls->bump += obj_size;
+        cls->bump_left -= obj_size;
+        return ptr;
+    }
+
+    return __kslab_refill(slab, cls, obj_size);
+}
+
+/**
+ * Free object allocated by kslab_alloc, free of NULL does nothing
+ *
+ * @param[in] slab - slab allocator used by kslab_alloc
+ * @param[in] ptr - object
+ * @param[in] size - size passed to kslab_alloc
+ */
+static inline void kslab_free(kslab_t *slab, void *ptr, size_t size)
+{
+    if (ptr == NULL)
+        return;
+
+    if (KUNLIKELY(size > KSLAB_MAX_SIZE))
+    {
+        free(ptr);
+        return;
+    }
+
+    kslab_class_t *cls = &slab->classes[kslab_class_index(size)];
+    kslab_free_obj_t *obj = ptr;
+
+    obj->next = cls->free_list;
+    cls->free_list = obj;
+}
+
+#endif
@@ -0,0 +1,452 @@
+#ifndef KTLSF_H
+#define KTLSF_H
+
+/*
+    This is the public header for the KTlsf.
+
+    KTlsf is a Two-Level Segregated Fit allocator (Masmano, Ripoll, Crespo, Real
+    "TLSF: a New Dynamic Memory Allocator for Real-Time Systems") for memory region given by caller.
+    Allocation and free are O(1) in the worst case: no loops over blocks, only bitmap searches.
+
+    Free blocks are kept in lists indexed by 2 levels:
+    first level (fl)  - floor(log2(size)), found by KCLZLL
+    second level (sl) - KTLSF_SL_COUNT linear subranges of [2^fl; 2^(fl + 1))
+    Bit in fl_bitmap says that at least one list of fl is not empty, bit in sl_bitmap[fl] says that list [fl][sl] is not empty.
+    Suitable list is found by KFFSLL on masked bitmaps, so search is 2 ffs instructions.
+
+    Block has header with pointer to previous physical block and size (flags in low bits),
+    so free merges block with both physical neighbours in O(1). Payload is aligned to KTLSF_ALIGN_SIZE.
+
+    Control structure is placed at the beginning of region, so KTlsf never calls system allocator.
+    KTlsf is not thread safe, use one region per thread or lock.
+
+    Include it directly: #include <kmacros/ktlsf.h>
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE: GPL3
+*/
+
+#include "kmacros.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Payload alignment and granularity, header of block has the same size */
+#define KTLSF_ALIGN_SIZE        (2 * sizeof(void *))
+#define KTLSF_ALIGN_SHIFT       KLOG2_FLOOR_CONST(KTLSF_ALIGN_SIZE)
+
+/* Second level: 2^KTLSF_SL_LOG2 lists per power of 2 */
+#define KTLSF_SL_LOG2           5
+#define KTLSF_SL_COUNT          (1 << KTLSF_SL_LOG2)
+
+/* Sizes below KTLSF_SMALL_SIZE are in first level 0, split linearly by KTLSF_ALIGN_SIZE */
+#define KTLSF_FL_INDEX_SHIFT    (KTLSF_SL_LOG2 + KTLSF_ALIGN_SHIFT)
+#define KTLSF_SMALL_SIZE        ((size_t)1 << KTLSF_FL_INDEX_SHIFT)
+
+/* Define before include to change the biggest block (2^KTLSF_FL_MAX_LOG2 - 1 bytes), it has to be < bits of size_t */
+#ifndef KTLSF_FL_MAX_LOG2
+#if SIZE_MAX > UINT32_MAX
+#define KTLSF_FL_MAX_LOG2       32
+#else
+#define KTLSF_FL_MAX_LOG2       31
+#endif
+#endif
+
+#define KTLSF_FL_COUNT          (KTLSF_FL_MAX_LOG2 - KTLSF_FL_INDEX_SHIFT + 1)
+#define KTLSF_BLOCK_SIZE_MAX    (((size_t)1 << KTLSF_FL_MAX_LOG2) - KTLSF_ALIGN_SIZE)
+#define KTLSF_BLOCK_SIZE_MIN    KTLSF_ALIGN_SIZE
+
+/* Flags in low bits of block size */
+#define KTLSF_BLOCK_FREE        ((size_t)1)
+#define KTLSF_BLOCK_PREV_FREE   ((size_t)2)
+#define KTLSF_BLOCK_FLAGS       (KTLSF_BLOCK_FREE | KTLSF_BLOCK_PREV_FREE)
+
+typedef struct ktlsf_block
+{
+    struct ktlsf_block *prev_phys;  /* previous block in memory, NULL for the first block */
+    size_t              size;       /* payload size | KTLSF_BLOCK_FLAGS */
+
+    /* Payload starts here, links are valid only for free block */
+    struct ktlsf_block *next_free;
+    struct ktlsf_block *prev_free;
+} ktlsf_block_t;
+
+#define KTLSF_HEADER_SIZE       offsetof(ktlsf_block_t, next_free)
+
+KSTATIC_ASSERT_MSG(KTLSF_HEADER_SIZE == KTLSF_ALIGN_SIZE, "Header has to keep payload aligned");
+KSTATIC_ASSERT_MSG(KTLSF_FL_COUNT > 0 && KTLSF_FL_COUNT <= 64, "First level bitmap is uint64_t");
+KSTATIC_ASSERT_MSG(KTLSF_FL_MAX_LOG2 < sizeof(size_t) * 8, "Blocks have to be smaller than address space");
+
+typedef struct ktlsf
+{
+    uint64_t       fl_bitmap;
+    uint64_t       sl_bitmap[KTLSF_FL_COUNT];
+    ktlsf_block_t *blocks[KTLSF_FL_COUNT][KTLSF_SL_COUNT];
+
+    ktlsf_block_t *first;           /* first physical block of pool */
+    size_t         pool_size;       /* bytes managed by allocator (headers and payloads) */
+    size_t         used_size;       /* payload bytes of used blocks */
+    size_t         free_size;       /* payload bytes of free blocks */
+    size_t         used_blocks;
+    size_t         free_blocks;
+} ktlsf_t;
+
+typedef struct ktlsf_stats
+{
+    size_t pool_size;
+    size_t used_size;
+    size_t free_size;
+    size_t used_blocks;
+    size_t free_blocks;
+    size_t largest_block;           /* payload of the biggest free block */
+    size_t largest_free;            /* the biggest allocation which can succeed (good fit rounds size up to next list) */
+    double fragmentation;           /* 1 - largest_block / free_size, 0 means whole free memory is in one block */
+} ktlsf_stats_t;
+
+static inline ktlsf_t *ktlsf_create(void *mem, size_t bytes);
+
+static inline void *ktlsf_alloc(ktlsf_t *tlsf, size_t size) KATTR_FUNC_MALLOC;
+static inline void ktlsf_free(ktlsf_t *tlsf, void *ptr);
+static inline size_t ktlsf_usable_size(const void *ptr);
+
+static inline void ktlsf_stats(const ktlsf_t *tlsf, ktlsf_stats_t *stats);
+
+/* Private helpers, do not use */
+static inline size_t __ktlsf_block_size(const ktlsf_block_t *block);
+static inline void *__ktlsf_block_payload(const ktlsf_block_t *block);
+static inline ktlsf_block_t *__ktlsf_block_from_payload(const void *ptr);
+static inline ktlsf_block_t *__ktlsf_block_next(const ktlsf_block_t *block);
+static inline void __ktlsf_block_set_free(ktlsf_block_t *block, bool is_free);
+
+static inline unsigned int __ktlsf_fls(size_t size);
+static inline void __ktlsf_mapping_insert(size_t size, unsigned int *fl, unsigned int *sl);
+static inline void __ktlsf_mapping_search(size_t size, unsigned int *fl, unsigned int *sl);
+static inline ktlsf_block_t *__ktlsf_search_suitable(const ktlsf_t *tlsf, unsigned int *fl, unsigned int *sl);
+
+static inline void __ktlsf_insert_free(ktlsf_t *tlsf, ktlsf_block_t *block);
+static inline void __ktlsf_remove_free(ktlsf_t *tlsf, ktlsf_block_t *block);
+static inline void __ktlsf_split(ktlsf_t *tlsf, ktlsf_block_t *block, size_t size);
+static inline ktlsf_block_t *__ktlsf_merge(ktlsf_block_t *prev, ktlsf_block_t *block);
+
+static inline size_t __ktlsf_block_size(const ktlsf_block_t *block)
+{
+    return block->size & ~KTLSF_BLOCK_FLAGS;
+}
+
+static inline void *__ktlsf_block_payload(const ktlsf_block_t *block)
+{
+    return (char *)block + KTLSF_HEADER_SIZE;
+}
+
+static inline ktlsf_block_t *__ktlsf_block_from_payload(const void *ptr)
+{
+    return (ktlsf_block_t *)(void *)((char *)ptr - KTLSF_HEADER_SIZE);
+}
+
+static inline ktlsf_block_t *__ktlsf_block_next(const ktlsf_block_t *block)
+{
+    return (ktlsf_block_t *)(void *)((char *)__ktlsf_block_payload(block) + __ktlsf_block_size(block));
+}
+
+/* Set free flag of block and prev free flag of next physical block */
+static inline void __ktlsf_block_set_free(ktlsf_block_t *block, bool is_free)
+{
+    ktlsf_block_t *next = __ktlsf_block_next(block);
+
+    if (is_free)
+    {
+        block->size |= KTLSF_BLOCK_FREE;
+        next->size |= KTLSF_BLOCK_PREV_FREE;
+    }
+    else
+    {
+        block->size &= ~KTLSF_BLOCK_FREE;
+        next->size &= ~KTLSF_BLOCK_PREV_FREE;
+    }
+}
+
+/* Index of the most significant set bit, size > 0 */
+static inline unsigned int __ktlsf_fls(size_t size)
+{
+    return (unsigned int)(63 - KCLZLL((unsigned long long)size));
+}
+
+static inline void __ktlsf_mapping_insert(size_t size, unsigned int *fl, unsigned int *sl)
+{
+    if (size < KTLSF_SMALL_SIZE)
+    {
+        *fl = 0;
+        *sl = (unsigned int)(size / (KTLSF_SMALL_SIZE / KTLSF_SL_COUNT));
+        return;
+    }
+
+    const unsigned int log = __ktlsf_fls(size);
+
+    /* sl is next KTLSF_SL_LOG2 bits after the most significant bit */
+    *sl = (unsigned int)(size >> (log - KTLSF_SL_LOG2)) ^ (1u << KTLSF_SL_LOG2);
+    *fl = log - (unsigned int)KTLSF_FL_INDEX_SHIFT + 1;
+}
+
+/* Round size up to the next list, so every block from found list is big enough (good fit) */
+static inline void __ktlsf_mapping_search(size_t size, unsigned int *fl, unsigned int *sl)
+{
+    if (size >= KTLSF_SMALL_SIZE)
+        size += ((size_t)1 << (__ktlsf_fls(size) - KTLSF_SL_LOG2)) - 1;
+
+    __ktlsf_mapping_insert(size, fl, sl);
+}
+
+static inline ktlsf_block_t *__ktlsf_search_suitable(const ktlsf_t *tlsf, unsigned int *fl, unsigned int *sl)
+{
+    if (*fl >= KTLSF_FL_COUNT)
+        return NULL;
+
+    /* lists >= sl in the same fl */
+    uint64_t sl_map = tlsf->sl_bitmap[*fl] & (~UINT64_C(0) << *sl);
+    if (sl_map == 0)
+    {
+        /* any list in bigger fl */
+        const uint64_t fl_map = *fl + 1 < 64 ? tlsf->fl_bitmap & (~UINT64_C(0) << (*fl + 1)) : 0;
+        if (fl_map == 0)
+            return NULL;
+
+        *fl = (unsigned int)KFFSLL((long long)fl_map) - 1;
+        sl_map = tlsf->sl_bitmap[*fl];
+    }
+
+    *sl = (unsigned int)KFFSLL((long long)sl_map) - 1;
+
+    return tlsf->blocks[*fl][*sl];
+}
+
+static inline void __ktlsf_insert_free(ktlsf_t *tlsf, ktlsf_block_t *block)
+{
+    unsigned int fl;
+    unsigned int sl;
+    __ktlsf_mapping_insert(__ktlsf_block_size(block), &fl, &sl);
+
+    ktlsf_block_t *head = tlsf->blocks[fl][sl];
+    block->next_free = head;
+    block->prev_free = NULL;
+    if (head != NULL)
+        head->prev_free = block;
+
+    tlsf->blocks[fl][sl] = block;
+    tlsf->fl_bitmap = KBIT_SET(tlsf->fl_bitmap, fl);
+    tlsf->sl_bitmap[fl] = KBIT_SET(tlsf->sl_bitmap[fl], sl);
+
+    tlsf->free_size += __ktlsf_block_size(block);
+    ++tlsf->free_blocks;
+}
+
+static inline void __ktlsf_remove_free(ktlsf_t *tlsf, ktlsf_block_t *block)
+{
+    unsigned int fl;
+    unsigned int sl;
+    __ktlsf_mapping_insert(__ktlsf_block_size(block), &fl, &sl);
+
+    if (block->next_free != NULL)
+        block->next_free->prev_free = block->prev_free;
+
+    if (block->prev_free != NULL)
+        block->prev_free->next_free = block->next_free;
+    else
+        tlsf->blocks[fl][sl] = block->next_free;
+
+    if (tlsf->blocks[fl][sl] == NULL)
+    {
+        tlsf->sl_bitmap[fl] = KBIT_CLEAR(tlsf->sl_bitmap[fl], sl);
+        if (tlsf->sl_bitmap[fl] == 0)
+            tlsf->fl_bitmap = KBIT_CLEAR(tlsf->fl_bitmap, fl);
+    }
+
+    tlsf->free_size -= __ktlsf_block_size(block);
+    --tlsf->free_blocks;
+}
+
+/* Cut block to size, rest becomes a new free block when it is big enough */
+static inline void __ktlsf_split(ktlsf_t *tlsf, ktlsf_block_t *block, size_t size)
+{
+    const size_t block_size = __ktlsf_block_size(block);
+    if (block_size < size + KTLSF_HEADER_SIZE + KTLSF_BLOCK_SIZE_MIN)
+        return;
+
+    ktlsf_block_t *rest = (ktlsf_block_t *)(void *)((char *)__ktlsf_block_payload(block) + size);
+    rest->prev_phys = block;
+    rest->size = block_size - size - KTLSF_HEADER_SIZE;
+    block->size = size | (block->size & KTLSF_BLOCK_FLAGS);
+
+    __ktlsf_block_next(rest)->prev_phys = rest;
+    __ktlsf_block_set_free(rest, true);
+    __ktlsf_insert_free(tlsf, rest);
+}
+
+/* Absorb block into prev (both are not in free lists), returns merged block */
+static inline ktlsf_block_t *__ktlsf_merge(ktlsf_block_t *prev, ktlsf_block_t *block)
+{
+    prev->size += __ktlsf_block_size(block) + KTLSF_HEADER_SIZE;
+    __ktlsf_block_next(prev)->prev_phys = prev;
+
+    return prev;
+}
+
+/**
+ * Create allocator in memory region. Control structure and all blocks are placed in region.
+ *
+ * @param[in] mem - memory region, it has to be valid until allocator is used
+ * @param[in] bytes - size of region, bytes beyond sizeof(ktlsf_t) + KTLSF_BLOCK_SIZE_MAX are not used
+ *
+ * @return allocator or NULL when region is too small
+ */
+static inline ktlsf_t *ktlsf_create(void *mem, size_t bytes)
+{
+    const uintptr_t start = (uintptr_t)mem;
+    const uintptr_t aligned = (start + KTLSF_ALIGN_SIZE - 1) & ~(uintptr_t)(KTLSF_ALIGN_SIZE - 1);
+    const size_t tlsf_size = (sizeof(ktlsf_t) + KTLSF_ALIGN_SIZE - 1) & ~(KTLSF_ALIGN_SIZE - 1);
+
+    /* control structure, first block header with min payload and sentinel header */
+    if (bytes < (size_t)(aligned - start) + tlsf_size + 2 * KTLSF_HEADER_SIZE + KTLSF_BLOCK_SIZE_MIN)
+        return NULL;
+
+    ktlsf_t *tlsf = (ktlsf_t *)aligned;
+    *tlsf = (ktlsf_t){.fl_bitmap = 0};
+
+    size_t pool_size = (bytes - (size_t)(aligned - start) - tlsf_size) & ~(KTLSF_ALIGN_SIZE - 1);
+    pool_size = KMIN(pool_size, KTLSF_BLOCK_SIZE_MAX + 2 * KTLSF_HEADER_SIZE);
+
+    ktlsf_block_t *block = (ktlsf_block_t *)(aligned + tlsf_size);
+    block->prev_phys = NULL;
+    block->size = pool_size - 2 * KTLSF_HEADER_SIZE;
+
+    /* used block with size 0 at the end, so next of the last block always exists and is never merged */
+    ktlsf_block_t *sentinel = __ktlsf_block_next(block);
+    sentinel->prev_phys = block;
+    sentinel->size = 0;
+
+    __ktlsf_block_set_free(block, true);
+    __ktlsf_insert_free(tlsf, block);
+
+    tlsf->first = block;
+    tlsf->pool_size = pool_size;
+
+    return tlsf;
+}
+
+/**
+ * Allocate memory in bounded time
+ *
+ * @param[in] tlsf - allocator
+ * @param[in] size - bytes to allocate
+ *
+ * @return pointer aligned to KTLSF_ALIGN_SIZE, NULL when size is 0 or there is no free block big enough
+ */
+static inline void *ktlsf_alloc(ktlsf_t *tlsf, size_t size)
+{
+    if (KUNLIKELY(size == 0 || size > KTLSF_BLOCK_SIZE_MAX))
+        return NULL;
+
+    size = (size + KTLSF_ALIGN_SIZE - 1) & ~(KTLSF_ALIGN_SIZE - 1);
+
+    unsigned int fl;
+    unsigned int sl;
+    __ktlsf_mapping_search(size, &fl, &sl);
+
+    ktlsf_block_t *block = __ktlsf_search_suitable(tlsf, &fl, &sl);
+    if (KUNLIKELY(block == NULL))
+        return NULL;
+
+    __ktlsf_remove_free(tlsf, block);
+    __ktlsf_block_set_free(block, false);
+    __ktlsf_split(tlsf, block, size);
+
+    tlsf->used_size += __ktlsf_block_size(block);
+    ++tlsf->used_blocks;
+
+    return __ktlsf_block_payload(block);
+}
+
+/**
+ * Free memory in bounded time, block is merged with free physical neighbours. Free of NULL does nothing
+ */
+static inline void ktlsf_free(ktlsf_t *tlsf, void *ptr)
+{
+    if (ptr == NULL)
+        return;
+
+    ktlsf_block_t *block = __ktlsf_block_from_payload(ptr);
+
+    tlsf->used_size -= __ktlsf_block_size(block);
+    --tlsf->used_blocks;
+
+    if (block->size & KTLSF_BLOCK_PREV_FREE)
+    {
+        __ktlsf_remove_free(tlsf, block->prev_phys);
+        block = __ktlsf_merge(block->prev_phys, block);
+    }
+
+    ktlsf_block_t *next = __ktlsf_block_next(block);
+    if (next->size & KTLSF_BLOCK_FREE)
+    {
+        __ktlsf_remove_free(tlsf, next);
+        block = __ktlsf_merge(block, next);
+    }
+
+    __ktlsf_block_set_free(block, true);
+    __ktlsf_insert_free(tlsf, block);
+}
+
+/**
+ * Number of bytes which can be used in allocated block (>= size passed to ktlsf_alloc)
+ */
+static inline size_t ktlsf_usable_size(const void *ptr)
+{
+    return __ktlsf_block_size(__ktlsf_block_from_payload(ptr));
+}
+
+/**
+ * Get usage and fragmentation stats.
+ * Only the highest non empty list is scanned to find the largest free block.
+ * ktlsf_alloc rounds size up to the next list, so the biggest allocation is the lower bound of the highest
+ * non empty list, which can be a few % less than the largest block
+ *
+ * @param[in] tlsf - allocator
+ * @param[out] stats - stats
+ */
+static inline void ktlsf_stats(const ktlsf_t *tlsf, ktlsf_stats_t *stats)
+{
+    size_t largest = 0;
+    size_t max_alloc = 0;
+
+    if (tlsf->fl_bitmap != 0)
+    {
+        const unsigned int fl = 63u - (unsigned int)KCLZLL(tlsf->fl_bitmap);
+        const unsigned int sl = 63u - (unsigned int)KCLZLL(tlsf->sl_bitmap[fl]);
+
+        for (const ktlsf_block_t *block = tlsf->blocks[fl][sl]; block != NULL; block = block->next_free)
+            largest = KMAX(largest, __ktlsf_block_size(block));
+
+        if (fl == 0)
+        {
+            /* small lists are exact (KTLSF_ALIGN_SIZE wide) and not rounded by search */
+            max_alloc = largest;
+        }
+        else
+        {
+            const unsigned int log = fl + (unsigned int)KTLSF_FL_INDEX_SHIFT - 1;
+            max_alloc = ((size_t)1 << log) + ((size_t)sl << (log - KTLSF_SL_LOG2));
+        }
+    }
+
+    stats->pool_size = tlsf->pool_size;
+    stats->used_size = tlsf->used_size;
+    stats->free_size = tlsf->free_size;
+    stats->used_blocks = tlsf->used_blocks;
+    stats->free_blocks = tlsf->free_blocks;
+    stats->largest_block = largest;
+    stats->largest_free = max_alloc;
+    stats->fragmentation = tlsf->free_size == 0 ? 0.0 : 1.0 - (double)largest / (double)tlsf->free_size;
+}
+
+#endif
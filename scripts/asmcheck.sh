@@ -0,0 +1,96 @@
+#!/bin/bash
+
+# Zero abstraction cost check.
+# Compiles asmcheck/probes.c to assembly and compares every pair of probes
+# asm_probe_<name>_kmacros and asm_probe_<name>_ref. Fails when instructions differ.
+#
+# Usage: scripts/asmcheck.sh [compilers...]   (default: gcc clang)
+# Set ASM_OPTS to change checked optimization levels (default: "-O2 -O3")
+
+# Full path of this script
+THIS_DIR=`readlink -f "${BASH_SOURCE[0]}" 2>/dev/null||echo $0`
+
+# This directory path
+DIR=`dirname "${THIS_DIR}"`
+
+probes="${DIR}/../asmcheck/probes.c"
+inc="${DIR}/../inc"
+
+compilers="$@"
+if [ -z "$compilers" ]; then
+    compilers="gcc clang"
+fi
+
+opts="${ASM_OPTS:--O2 -O3}"
+
+tmp_dir=`mktemp -d`
+trap 'rm -rf "$tmp_dir"' EXIT
+
+# Print instructions of function $2 from assembly file $1.
+# Directives, labels and comments are skipped, local labels are renamed to .L
+function extract_body()
+{
+    awk -v fn="$2" '
+        $0 == fn":" { inside = 1; next }
+        inside && $1 == ".size" { exit }
+        inside {
+            sub(/[#;].*$/, "")
+            if ($0 ~ /^[ \t]*$/) next
+            if ($0 ~ /^[ \t]*\./) next
+            if ($0 ~ /^[^ \t].*:$/) next
+            gsub(/\.L[A-Za-z0-9_.]+/, ".L")
+            gsub(/[ \t]+/, " ")
+            sub(/^ /, "")
+            print
+        }
+    ' "$1"
+}
+
+checked=0
+failed=0
+
+for cc in $compilers; do
+    if ! command -v "$cc" > /dev/null 2>&1; then
+        echo "[SKIP]      $cc not found"
+        continue
+    fi
+
+    for opt in $opts; do
+        asm="${tmp_dir}/probes-${cc}${opt}.s"
+
+        if ! "$cc" -std=gnu17 $opt -S -fno-asynchronous-unwind-tables -fno-stack-protector \
+             -I"$inc" "$probes" -o "$asm"; then
+            echo "[FAIL]      $cc $opt: cannot compile probes"
+            failed=$((failed + 1))
+            continue
+        fi
+
+        probes_list=`grep -o '^asm_probe_[A-Za-z0-9_]*_kmacros:' "$asm" | sed -e 's/_kmacros:$//'`
+        for probe in $probes_list; do
+            extract_body "$asm" "${probe}_kmacros" > "${tmp_dir}/kmacros.s"
+            extract_body "$asm" "${probe}_ref" > "${tmp_dir}/ref.s"
+
+            name="${probe#asm_probe_}"
+            checked=$((checked + 1))
+            if cmp -s "${tmp_dir}/kmacros.s" "${tmp_dir}/ref.s"; then
+                echo "[OK]        $cc $opt $name (`wc -l < "${tmp_dir}/ref.s"` instructions)"
+            else
+                echo "[FAIL]      $cc $opt $name"
+                diff -u --label "${name}_kmacros" --label "${name}_ref" "${tmp_dir}/kmacros.s" "${tmp_dir}/ref.s"
+                failed=$((failed + 1))
+            fi
+        done
+    done
+done
+
+if [ $checked -eq 0 ]; then
+    echo "No probe has been checked"
+    exit 1
+fi
+
+if [ $failed -ne 0 ]; then
+    echo "$failed probe(s) failed"
+    exit 1
+fi
+
+echo "All $checked probes passed"